@@ -5,15 +5,23 @@
 # File:               app.cpp
 # File Description:   Driver program for website bookmarking program.
 # Input:              User input from menu options, data for new websites
-#                     and test data for loading (input.txt)
+#                     and test data for loading (input.txt), or a batch
+#                     command file (app --batch [file])
 # Output:             Diplay menu options, and data for new groups and
 #                     save data (output.txt)
 #******************************************************************************/
 #include <iostream>
+#include <fstream>
+#include <string>
+#include <chrono>
+#include <vector>
 using namespace std;
 
 #include "table.h"
 #include "website.h"
+#include "columnar.h"
+#include "perf_counters.h"
+#include "record_parser.h"
 
 //Function Prototypes
 void menu(Table &table);
@@ -24,14 +32,33 @@ void editWebsite(Table &table);
 void removeWebsites(Table &table);
 void displayTopicMatches(Table &table);
 void displayAll(Table &table);
+// for batch mode
+int runBatch(Table &table, istream &in);
+bool batchAdd(Table &table, istream &in, int &lineNum);
+bool batchEdit(Table &table, istream &in, const string &args, int &lineNum);
+void batchGet(const Table &table, const string &topic,
+              vector<const Website *> &matches);
+void batchDump(const Table &table);
 
-#include <iostream>
-using namespace std;
-
-int main()
+int main(int argc, char * argv[])
 {
    Table table;
 
+   if (argc > 1 && strcmp(argv[1], "--batch") == 0) // batch mode
+   {
+      if (argc < 3 || strcmp(argv[2], "-") == 0) // commands from stdin
+      {
+         return runBatch(table, cin);
+      }
+      ifstream commands(argv[2]);
+      if (!commands)
+      {
+         cerr << "Error opening command file " << argv[2] << endl;
+         return 1;
+      }
+      return runBatch(table, commands);
+   }
+
    table.loadFromFile("input.txt"); // load test data from file
 
    menu(table);
@@ -44,7 +71,7 @@ int main()
 // Menu function
 void menu(Table &table){
    int menuOption = 0;
-   while (menuOption != 9)
+   while (menuOption != 6)
    {
       cout << "Website Bookmark Program" << endl
             << "1. Add new website" << endl
@@ -90,9 +117,9 @@ void menu(Table &table){
          }
          case 6:
          {
-            // Exit
+            // Exit (return to main so the table is destroyed)
             cout << "Exiting program..." << endl;
-            exit (0);
+            break;
          }
          default:
          {
@@ -334,3 +361,321 @@ void displayAll(Table &table)
       }
    }
 }
+
+// BATCH MODE
+
+// Command names, in the order they are reported in the timing summary
+enum BatchCommand { CMD_LOAD, CMD_ADD, CMD_GET, CMD_EDIT, CMD_PURGE, CMD_DUMP,
+                    CMD_MERGE, CMD_SYNC, CMD_EXPORT, CMD_MEMORY, CMD_PERF,
+                    NUM_COMMANDS };
+const char * const COMMAND_NAMES[NUM_COMMANDS] = { "LOAD", "ADD", "GET",
+                                                   "EDIT", "PURGE", "DUMP",
+                                                   "MERGE", "SYNC",
+                                                   "EXPORT", "MEMORY",
+                                                   "PERF" };
+
+// runBatch function
+// Description: Runs commands from a stream against the table without any
+//              prompts, one command per line:
+//                 LOAD <file>          load websites from a file
+//                 ADD                  next 5 lines: topic, URL, summary,
+//                                      review, rating
+//                 GET <topic>          display websites for topic, best first
+//                 EDIT <topic> <url>   next 2 lines: new review, new rating
+//                 PURGE                remove 1 star websites
+//                 DUMP                 display all websites
+//                 MERGE <file>         insert new websites from a file and
+//                                      update changed reviews and ratings
+//                 SYNC <file>          MERGE, then remove websites that are
+//                                      not in the file
+//                 EXPORT <file>        write a columnar file (columnar.h)
+//                 MEMORY               display the table's memory report
+//                 PERF ON | OFF        start or stop counting table
+//                                      operations (perf_counters.h)
+//                 PERF                 display the counts so far
+//              Blank lines and lines starting with # are skipped. Results go
+//              to cout with '\n' (no flush per line). When the stream ends a
+//              summary of count and time per command is written to cerr.
+// Input: Table &table, istream &in
+// Output: 0 if every command was understood, 1 if not
+int runBatch(Table &table, istream &in)
+{
+   ios::sync_with_stdio(false); // cout is only flushed when its buffer fills
+   long long counts[NUM_COMMANDS] = { 0 };
+   chrono::nanoseconds totals[NUM_COMMANDS] = {};
+   int errors = 0;
+   int lineNum = 0;
+   string line;
+   PerfStats * perf = nullptr; // after PERF ON
+   vector<const Website *> matches(64); // GET's buffer, kept between GETs
+
+   while (getline(in, line))
+   {
+      lineNum++;
+      if (!line.empty() && line[line.size() - 1] == '\r') // CRLF files
+      {
+         line.erase(line.size() - 1);
+      }
+      if (line.empty() || line[0] == '#') // blank or comment
+      {
+         continue;
+      }
+      size_t space = line.find(' ');
+      string name = line.substr(0, space);
+      string args = space == string::npos ? "" : line.substr(space + 1);
+      int command = 0;
+      while (command < NUM_COMMANDS && name != COMMAND_NAMES[command])
+      {
+         command++;
+      }
+      if (command == NUM_COMMANDS)
+      {
+         cout << "ERROR line " << lineNum << ": unknown command " << name
+              << '\n';
+         errors++;
+         continue;
+      }
+
+      chrono::steady_clock::time_point start = chrono::steady_clock::now();
+      bool ok = true;
+      switch (command)
+      {
+         case CMD_LOAD:
+         {
+            int before = table.getSize();
+            table.loadFromFile(args.c_str());
+            cout << "LOADED " << table.getSize() - before << '\n';
+            break;
+         }
+         case CMD_ADD:
+         {
+            ok = batchAdd(table, in, lineNum);
+            break;
+         }
+         case CMD_GET:
+         {
+            batchGet(table, args, matches);
+            break;
+         }
+         case CMD_EDIT:
+         {
+            ok = batchEdit(table, in, args, lineNum);
+            break;
+         }
+         case CMD_PURGE:
+         {
+            int before = table.getSize();
+            table.removeOneStar();
+            cout << "REMOVED " << before - table.getSize() << '\n';
+            break;
+         }
+         case CMD_DUMP:
+         {
+            batchDump(table);
+            break;
+         }
+         case CMD_EXPORT:
+         {
+            ok = exportColumnar(table, args.c_str());
+            if (ok)
+            {
+               cout << "EXPORTED " << table.getSize() << '\n';
+            }
+            break;
+         }
+         case CMD_MEMORY:
+         {
+            cout << table.memoryReport();
+            break;
+         }
+         case CMD_PERF:
+         {
+            if (args == "ON" && !perf)
+            {
+               perf = new PerfStats();
+               setPerfStats(perf);
+            }
+            else if (args == "OFF" && perf)
+            {
+               setPerfStats(nullptr);
+               delete perf;
+               perf = nullptr;
+            }
+            else if (!args.empty() && args != "ON" && args != "OFF")
+            {
+               ok = false;
+               break;
+            }
+            if (perf && args.empty())
+            {
+               cout << *perf;
+            }
+            else
+            {
+               cout << "PERF " << (perf ? "ON" : "OFF") << '\n';
+            }
+            break;
+         }
+         case CMD_MERGE:
+         case CMD_SYNC:
+         {
+            MergeSummary summary;
+            ok = table.mergeFromFile(args.c_str(), command == CMD_SYNC,
+                                     summary);
+            if (ok)
+            {
+               cout << "MERGED inserted " << summary.inserted << " updated "
+                    << summary.updated << " unchanged " << summary.unchanged
+                    << " rejected " << summary.rejected << " deleted "
+                    << summary.deleted << " malformed " << summary.malformed
+                    << '\n';
+            }
+            break;
+         }
+      }
+      totals[command] += chrono::steady_clock::now() - start;
+      counts[command]++;
+      if (!ok)
+      {
+         cout << "ERROR line " << lineNum << ": bad " << name << '\n';
+         errors++;
+      }
+   }
+   cout.flush();
+   setPerfStats(nullptr);
+   delete perf;
+   perf = nullptr;
+
+   // timing summary
+   cerr << "command      count     total ms   avg us" << '\n';
+   for (int i = 0; i < NUM_COMMANDS; i++)
+   {
+      if (counts[i] == 0)
+      {
+         continue;
+      }
+      double totalMs = totals[i].count() / 1e6;
+      cerr << left << setw(8) << COMMAND_NAMES[i] << right << setw(10)
+           << counts[i] << fixed << setprecision(3) << setw(13) << totalMs
+           << setw(9) << totalMs * 1000 / counts[i] << '\n';
+   }
+   cerr << "errors: " << errors << endl;
+   return errors == 0 ? 0 : 1;
+}
+
+// batchAdd function
+// Description: Reads the 5 lines of a website after an ADD command and
+//              inserts it. Prints ADDED or EXISTS.
+// Input: Table &table, istream &in, int &lineNum (lines read so far)
+// Output: false if the record was cut short or the rating is not a whole
+//         number
+bool batchAdd(Table &table, istream &in, int &lineNum)
+{
+   string fields[5]; // topic, URL, summary, review, rating
+   for (int i = 0; i < 5; i++)
+   {
+      if (!getline(in, fields[i]))
+      {
+         return false;
+      }
+      lineNum++;
+      if (!fields[i].empty() && fields[i][fields[i].size() - 1] == '\r')
+      {
+         fields[i].erase(fields[i].size() - 1);
+      }
+   }
+   int rating = 0;
+   if (!RecordParser::parseInt(fields[4].data(),
+                               fields[4].data() + fields[4].size(), rating))
+   {
+      return false;
+   }
+   Website website;
+   website.setTopic(&fields[0][0]);
+   website.setURL(&fields[1][0]);
+   website.setSummary(&fields[2][0]);
+   website.setReview(&fields[3][0]);
+   website.setRating(rating);
+   cout << (table.insert(website) ? "ADDED" : "EXISTS") << '\n';
+   return true;
+}
+
+// batchEdit function
+// Description: Handles EDIT <topic> <url>. The URL is the last word of the
+//              line (topics may have spaces, URLs do not). Reads the new
+//              review and rating from the next 2 lines. Prints EDITED or
+//              NOT FOUND.
+// Input: Table &table, istream &in, string args (after EDIT), int &lineNum
+// Output: false if the command or its 2 lines are malformed
+bool batchEdit(Table &table, istream &in, const string &args, int &lineNum)
+{
+   size_t space = args.rfind(' ');
+   if (space == string::npos)
+   {
+      return false;
+   }
+   string topic = args.substr(0, space);
+   string url = args.substr(space + 1);
+   string review, ratingLine;
+   if (!getline(in, review) || !getline(in, ratingLine))
+   {
+      return false;
+   }
+   lineNum += 2;
+   if (!review.empty() && review[review.size() - 1] == '\r')
+   {
+      review.erase(review.size() - 1);
+   }
+   if (!ratingLine.empty() && ratingLine[ratingLine.size() - 1] == '\r')
+   {
+      ratingLine.erase(ratingLine.size() - 1);
+   }
+   int rating = 0;
+   if (!RecordParser::parseInt(ratingLine.data(),
+                               ratingLine.data() + ratingLine.size(), rating))
+   {
+      return false;
+   }
+   bool edited = table.edit(&topic[0], &url[0], &review[0], rating);
+   cout << (edited ? "EDITED" : "NOT FOUND") << '\n';
+   return true;
+}
+
+// batchGet function
+// Description: Displays every website for a topic, highest rating first,
+//              using topK so nothing is copied. Ends with FOUND <count>.
+//              The buffer is doubled while topK fills it, so it only ever
+//              grows to the longest topic run asked for.
+// Input: const Table &table, string topic
+//        matches - buffer for topK, kept by the caller between GETs
+// Output: None
+void batchGet(const Table &table, const string &topic,
+              vector<const Website *> &matches)
+{
+   int found = 0;
+   table.topK(topic.c_str(), (int)matches.size(), matches.data(), found);
+   while (found == (int)matches.size()) // the run may go on
+   {
+      matches.resize(matches.size() * 2);
+      table.topK(topic.c_str(), (int)matches.size(), matches.data(), found);
+   }
+   for (int i = 0; i < found; i++)
+   {
+      cout << *matches[i] << '\n';
+   }
+   cout << "FOUND " << found << '\n';
+}
+
+// batchDump function
+// Description: Displays every website in the table through its iterator,
+//              then SIZE <count>.
+// Input: const Table &table
+// Output: None
+void batchDump(const Table &table)
+{
+   for (Table::const_iterator it = table.begin(); it != table.end(); ++it)
+   {
+      cout << *it << '\n';
+   }
+   cout << "SIZE " << table.getSize() << '\n';
+}
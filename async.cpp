@@ -0,0 +1,244 @@
+/******************************************************************************
+# Program Desc.:      This program is a website bookmarking program. The program
+#                     implements a hash table using chaining (pointer array of
+#                     linked lists) to store website information.
+# File:               async.cpp
+# File Description:   Implementation of IoExecutor and the coroutine based
+#                     loadAsync and exportAsync.
+# Input:              Data file (loadAsync)
+# Output:             Exported data (exportAsync)
+#******************************************************************************/
+#include "async.h"
+#include "record_parser.h"
+
+#include <string>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+
+// IoExecutor constructor
+// Description: Starts the pool threads that run blocking calls.
+// Input: threads - number of pool threads (at least 1)
+IoExecutor::IoExecutor(int threads)
+{
+   stopping = false;
+   for (int i = 0; i < (threads > 0 ? threads : 1); i++)
+   {
+      workers.push_back(thread(&IoExecutor::workerLoop, this));
+   }
+}
+
+// IoExecutor destructor
+// Description: Stops the pool. Coroutines still waiting are not resumed.
+IoExecutor::~IoExecutor()
+{
+   {
+      lock_guard<mutex> guard(lock);
+      stopping = true;
+   }
+   jobReady.notify_all();
+   for (size_t i = 0; i < workers.size(); i++)
+   {
+      workers[i].join();
+   }
+}
+
+// yield
+// Description: Returns an awaiter that puts the coroutine at the back of the
+//              ready queue, so the owner's loop gets a turn.
+IoExecutor::YieldAwaiter IoExecutor::yield()
+{
+   return YieldAwaiter(this);
+}
+
+// runReady
+// Description: Resumes every coroutine that was ready when called. Must be
+//              called from the thread that owns the table.
+// Input: None
+// Output: the number of coroutines resumed
+int IoExecutor::runReady()
+{
+   deque<coroutine_handle<> > batch;
+   {
+      lock_guard<mutex> guard(lock);
+      batch.swap(readyQueue);
+   }
+   for (size_t i = 0; i < batch.size(); i++)
+   {
+      batch[i].resume();
+   }
+   return (int)batch.size();
+}
+
+// waitReady
+// Description: Blocks until a coroutine is ready to be resumed.
+void IoExecutor::waitReady()
+{
+   unique_lock<mutex> guard(lock);
+   resumeReady.wait(guard, [this] { return !readyQueue.empty(); });
+}
+
+// post
+// Description: Queues a job for a pool thread.
+void IoExecutor::post(function<void()> job)
+{
+   {
+      lock_guard<mutex> guard(lock);
+      jobs.push_back(std::move(job));
+   }
+   jobReady.notify_one();
+}
+
+// ready
+// Description: Queues a coroutine to be resumed by the owner's runReady().
+void IoExecutor::ready(coroutine_handle<> handle)
+{
+   {
+      lock_guard<mutex> guard(lock);
+      readyQueue.push_back(handle);
+   }
+   resumeReady.notify_one();
+}
+
+// workerLoop
+// Description: Pool thread body. Runs jobs until the executor stops.
+void IoExecutor::workerLoop()
+{
+   while (true)
+   {
+      function<void()> job;
+      {
+         unique_lock<mutex> guard(lock);
+         jobReady.wait(guard, [this] { return stopping || !jobs.empty(); });
+         if (stopping)
+         {
+            return;
+         }
+         job = std::move(jobs.front());
+         jobs.pop_front();
+      }
+      job();
+   }
+}
+
+// loadAsync
+// Description: Coroutine version of Table::loadFromFile. Each chunk of the
+//              file is read on a pool thread while the owner's loop keeps
+//              running, then the complete records in it are inserted on the
+//              owner's thread and the coroutine yields before the next read.
+//              Records are parsed by RecordParser, like loadFromFile, so bad
+//              records are skipped and reported to cerr the same way.
+// Input: table, executor, filename, chunkBytes - bytes per read
+// Output: the number of websites inserted, -1 if the file cannot be opened
+//         or a read fails (the chunks read before it stay inserted)
+Task<int> loadAsync(Table & table, IoExecutor & executor,
+                    const char * filename, int chunkBytes)
+{
+   string path = filename; // caller's string may not outlive the coroutine
+   int fd = co_await executor.offload([&path]
+   {
+      return open(path.c_str(), O_RDONLY);
+   });
+   if (fd < 0)
+   {
+      co_return -1;
+   }
+   vector<char> chunk(chunkBytes > 0 ? chunkBytes : 65536);
+   RecordParser parser; // keeps partial lines and records between chunks
+   int inserted = 0;
+   RecordParser::RecordHandler insertRecord = [&table, &inserted](
+      const Website & website)
+   {
+      if (table.insert(website))
+      {
+         inserted++;
+      }
+   };
+   while (true)
+   {
+      ssize_t got = co_await executor.offload([fd, &chunk]
+      {
+         ssize_t bytes;
+         do
+         {
+            bytes = read(fd, chunk.data(), chunk.size());
+         } while (bytes < 0 && errno == EINTR);
+         return bytes < 0 ? -(ssize_t)errno : bytes; // errno is the pool's
+      });
+      if (got < 0) // not the whole file, so not a load
+      {
+         cerr << path << ": read failed: " << strerror((int)-got) << endl;
+         co_await executor.offload([fd] { return close(fd); });
+         co_return -1;
+      }
+      if (got == 0) // end of file
+      {
+         break;
+      }
+      parser.feed(chunk.data(), got, insertRecord);
+      co_await executor.yield();
+   }
+   parser.finish(insertRecord);
+   parser.reportErrors(cerr, path.c_str());
+   co_await executor.offload([fd] { return close(fd); });
+   co_return inserted;
+}
+
+// exportAsync
+// Description: Coroutine version of Table::saveToFile for an open file
+//              descriptor. Takes a snapshot first (O(1)), so the output is
+//              a consistent point in time copy even though the table may be
+//              changed between batches. Each batch is formatted on the
+//              owner's thread and written on a pool thread.
+// Input: table, executor, fd - where to write, batchSize - websites per write
+// Output: the number of websites written, -1 on a write error
+Task<int> exportAsync(const Table & table, IoExecutor & executor, int fd,
+                      int batchSize)
+{
+   Table::Snapshot snapshot = table.snapshot();
+   Table::Cursor cursor;
+   vector<const Website *> batch(batchSize > 0 ? batchSize : 256);
+   string text;
+   int written = 0;
+   int count;
+   while ((count = snapshot.nextBatch(cursor, batch.data(),
+                                      (int)batch.size())) > 0)
+   {
+      text.clear();
+      for (int i = 0; i < count; i++)
+      {
+         text += batch[i]->getTopic();
+         text += '\n';
+         text += batch[i]->getURL();
+         text += '\n';
+         text += batch[i]->getSummary();
+         text += '\n';
+         text += batch[i]->getReview();
+         text += '\n';
+         text += to_string(batch[i]->getRating());
+         text += "\n\n";
+      }
+      bool ok = co_await executor.offload([fd, &text]
+      {
+         size_t done = 0;
+         while (done < text.size())
+         {
+            ssize_t sent = write(fd, text.data() + done, text.size() - done);
+            if (sent <= 0)
+            {
+               return false;
+            }
+            done += sent;
+         }
+         return true;
+      });
+      if (!ok)
+      {
+         co_return -1;
+      }
+      written += count;
+   }
+   co_return written;
+}
@@ -0,0 +1,254 @@
+/******************************************************************************
+# Program Desc.:      This program is a website bookmarking program. The program
+#                     implements a hash table using chaining (pointer array of
+#                     linked lists) to store website information.
+# File:               async.h
+# File Description:   C++20 coroutine support for long running Table I/O.
+#                     Task<T> is a lazily started coroutine that can be
+#                     co_awaited. IoExecutor runs blocking system calls on a
+#                     small thread pool and resumes the waiting coroutine on
+#                     the thread that calls runReady() (the owner's event
+#                     loop), so the Table is only ever touched by that one
+#                     thread and needs no locking. loadAsync and exportAsync
+#                     yield back to the loop between chunks, so lookups can
+#                     be served while a bulk load or export is running.
+# Input:              None
+# Output:             None
+#******************************************************************************/
+#ifndef ASYNC_H
+#define ASYNC_H
+#include <coroutine>
+#include <exception>
+#include <functional>
+#include <utility>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include "table.h"
+
+using namespace std;
+
+// Task
+// Coroutine return type. The body does not run until the task is awaited
+// (or start() is called). When it finishes, whoever awaited it is resumed.
+template <class T>
+class Task
+{
+public:
+   struct promise_type
+   {
+      T value = T();
+      exception_ptr error;
+      coroutine_handle<> continuation; // coroutine awaiting this task
+
+      Task get_return_object()
+      {
+         return Task(coroutine_handle<promise_type>::from_promise(*this));
+      }
+      suspend_always initial_suspend() noexcept
+      {
+         return suspend_always();
+      }
+      struct FinalAwaiter // hands control back to the awaiting coroutine
+      {
+         bool await_ready() noexcept
+         {
+            return false;
+         }
+         coroutine_handle<> await_suspend(
+            coroutine_handle<promise_type> handle) noexcept
+         {
+            coroutine_handle<> next = handle.promise().continuation;
+            return next ? next : noop_coroutine();
+         }
+         void await_resume() noexcept
+         {
+         }
+      };
+      FinalAwaiter final_suspend() noexcept
+      {
+         return FinalAwaiter();
+      }
+      void return_value(T aValue)
+      {
+         value = std::move(aValue);
+      }
+      void unhandled_exception()
+      {
+         error = current_exception();
+      }
+   };
+
+   Task(Task && aTask) : handle(aTask.handle)
+   {
+      aTask.handle = nullptr;
+   }
+   Task(const Task &) = delete;
+   ~Task()
+   {
+      if (handle)
+      {
+         handle.destroy();
+      }
+   }
+
+   // awaiting a task starts it and resumes the awaiter when it is done
+   bool await_ready() const
+   {
+      return handle.done();
+   }
+   coroutine_handle<> await_suspend(coroutine_handle<> awaiting)
+   {
+      handle.promise().continuation = awaiting;
+      return handle;
+   }
+   T await_resume()
+   {
+      return result();
+   }
+
+   void start() // run a top level task up to its first suspension
+   {
+      handle.resume();
+   }
+   bool done() const
+   {
+      return handle.done();
+   }
+   T result() // the value returned by the task, rethrows its exception
+   {
+      if (handle.promise().error)
+      {
+         rethrow_exception(handle.promise().error);
+      }
+      return std::move(handle.promise().value);
+   }
+
+private:
+   explicit Task(coroutine_handle<promise_type> aHandle) : handle(aHandle) {}
+   coroutine_handle<promise_type> handle;
+};
+
+// IoExecutor
+// Thread pool for blocking calls plus a ready queue of coroutines to resume
+// on the owner's thread.
+class IoExecutor
+{
+public:
+   IoExecutor(int threads = 2); // start the pool
+   ~IoExecutor(); // stop and join the pool
+   IoExecutor(const IoExecutor &) = delete;
+
+   template <class Function>
+   class OffloadAwaiter; // see offload()
+   class YieldAwaiter; // see yield()
+
+   // co_await offload(fn): run fn() on a pool thread, resume with its result
+   template <class Function>
+   OffloadAwaiter<Function> offload(Function fn);
+   // co_await yield(): let other ready coroutines and the loop run first
+   YieldAwaiter yield();
+
+   int runReady(); // resume ready coroutines, returns how many ran
+   void waitReady(); // block until at least one coroutine is ready
+   template <class T>
+   T run(Task<T> & task); // start task and run the loop until it finishes
+
+private:
+   void post(function<void()> job); // queue a job for the pool
+   void ready(coroutine_handle<> handle); // queue a resume for the owner
+   void workerLoop();
+
+   vector<thread> workers;
+   deque<function<void()> > jobs;
+   deque<coroutine_handle<> > readyQueue;
+   mutex lock; // guards jobs, readyQueue and stopping
+   condition_variable jobReady;
+   condition_variable resumeReady;
+   bool stopping;
+};
+
+template <class Function>
+class IoExecutor::OffloadAwaiter
+{
+public:
+   OffloadAwaiter(IoExecutor * anExecutor, Function aFunction)
+      : executor(anExecutor), function(std::move(aFunction)) {}
+   bool await_ready() const
+   {
+      return false;
+   }
+   void await_suspend(coroutine_handle<> handle)
+   {
+      executor->post([this, handle]
+      {
+         result = function();
+         executor->ready(handle);
+      });
+   }
+   decltype(declval<Function &>()()) await_resume()
+   {
+      return std::move(result);
+   }
+
+private:
+   IoExecutor * executor;
+   Function function;
+   decltype(declval<Function &>()()) result{};
+};
+
+class IoExecutor::YieldAwaiter
+{
+public:
+   YieldAwaiter(IoExecutor * anExecutor) : executor(anExecutor) {}
+   bool await_ready() const
+   {
+      return false;
+   }
+   void await_suspend(coroutine_handle<> handle)
+   {
+      executor->ready(handle);
+   }
+   void await_resume() const
+   {
+   }
+
+private:
+   IoExecutor * executor;
+};
+
+template <class Function>
+IoExecutor::OffloadAwaiter<Function> IoExecutor::offload(Function fn)
+{
+   return OffloadAwaiter<Function>(this, std::move(fn));
+}
+
+// run
+// Description: Drives a top level task to completion from plain code: starts
+//              it, then waits for and resumes ready coroutines until it is
+//              done. An event loop would call runReady() itself instead.
+template <class T>
+T IoExecutor::run(Task<T> & task)
+{
+   task.start();
+   while (!task.done())
+   {
+      waitReady();
+      runReady();
+   }
+   return task.result();
+}
+
+// load websites from a file, chunk by chunk, returns how many were inserted
+// or -1 if the file cannot be opened or read
+Task<int> loadAsync(Table & table, IoExecutor & executor,
+                    const char * filename, int chunkBytes = 65536);
+// write a snapshot of the table to fd in the loadFromFile format, batch by
+// batch, returns how many websites were written or -1 on a write error
+Task<int> exportAsync(const Table & table, IoExecutor & executor, int fd,
+                      int batchSize = 256);
+
+#endif
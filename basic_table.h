@@ -0,0 +1,648 @@
+/******************************************************************************
+# Program Desc.:      This program is a website bookmarking program. The program
+#                     implements a hash table using chaining (pointer array of
+#                     linked lists) to store website information.
+# File:               basic_table.h
+# File Description:   Header only, compile time configurable hash table engine
+#                     (BasicTable) and the policies it is built from: key
+#                     extractors, hash functions, key equality and growth
+#                     policies. The growth policies and topic hash are also
+#                     what Table uses to turn a topic into a bucket index.
+# Input:              None
+# Output:             None
+#******************************************************************************/
+#ifndef BASIC_TABLE_H
+#define BASIC_TABLE_H
+#include <cstring>
+#include <cstddef>
+#include <cstdint>
+#include <atomic>
+#include <chrono>
+#include <random>
+
+#include "website.h"
+
+using namespace std;
+
+// KEY EXTRACTORS
+// Return the key of a value. Called on every probe, so they are tiny inline
+// functors the compiler can see through.
+
+struct TopicKey // websites keyed by topic
+{
+   typedef const char * key_type;
+   const char * operator() (const Website & website) const
+   {
+      return website.getTopic();
+   }
+};
+
+struct UrlKey // websites keyed by URL
+{
+   typedef const char * key_type;
+   const char * operator() (const Website & website) const
+   {
+      return website.getURL();
+   }
+};
+
+// HASH FUNCTIONS
+
+// TopicSumHash
+// Adds the value of each char in the key. This is the hash Table has always
+// used: "abc" and "cba" hash the same.
+struct TopicSumHash
+{
+   size_t operator() (const char * key) const
+   {
+      size_t sum = 0;
+      for (int i = 0; key[i] != '\0'; i++)
+      {
+         sum += (unsigned char)key[i];
+      }
+      return sum;
+   }
+};
+
+// CStringHash
+// FNV-1a over the chars of the key. Position dependent, so anagrams spread.
+struct CStringHash
+{
+   size_t operator() (const char * key) const
+   {
+      uint64_t hash = UINT64_C(14695981039346656037);
+      for (int i = 0; key[i] != '\0'; i++)
+      {
+         hash ^= (unsigned char)key[i];
+         hash *= UINT64_C(1099511628211);
+      }
+      return (size_t)hash;
+   }
+};
+
+// randomSeed
+// Returns a fresh 64 bit hash seed: the OS random source is read once, then
+// each call mixes in a counter (splitmix64), so seeds differ between tables
+// and between runs and cannot be guessed from outside the process.
+inline uint64_t randomSeed()
+{
+   static const uint64_t base = ((uint64_t)random_device()() << 32) ^
+      random_device()() ^
+      (uint64_t)chrono::steady_clock::now().time_since_epoch().count();
+   static atomic<uint64_t> counter(0);
+   uint64_t x = base + ++counter * UINT64_C(0x9E3779B97F4A7C15);
+   x = (x ^ (x >> 30)) * UINT64_C(0xBF58476D1CE4E5B9);
+   x = (x ^ (x >> 27)) * UINT64_C(0x94D049BB133111EB);
+   return x ^ (x >> 31);
+}
+
+// KeyedStringHash
+// SipHash-1-3 of the chars of the key under a secret 128 bit key. Without
+// the key, inputs that collide (like anagrams under TopicSumHash) cannot be
+// crafted, so a table using it cannot be forced into long chains or probe
+// sequences. Default constructed hashes pick a random key; reseed() picks a
+// new one (a table then has to rehash everything).
+struct KeyedStringHash
+{
+   KeyedStringHash()
+   {
+      reseed();
+   }
+   KeyedStringHash(uint64_t key0, uint64_t key1) : k0(key0), k1(key1) {}
+   void reseed()
+   {
+      k0 = randomSeed();
+      k1 = randomSeed();
+   }
+   static uint64_t rotate(uint64_t x, int bits)
+   {
+      return (x << bits) | (x >> (64 - bits));
+   }
+   static void round(uint64_t & v0, uint64_t & v1, uint64_t & v2,
+                     uint64_t & v3)
+   {
+      v0 += v1; v1 = rotate(v1, 13); v1 ^= v0; v0 = rotate(v0, 32);
+      v2 += v3; v3 = rotate(v3, 16); v3 ^= v2;
+      v0 += v3; v3 = rotate(v3, 21); v3 ^= v0;
+      v2 += v1; v1 = rotate(v1, 17); v1 ^= v2; v2 = rotate(v2, 32);
+   }
+   size_t operator() (const char * key) const
+   {
+      size_t length = strlen(key);
+      uint64_t v0 = k0 ^ UINT64_C(0x736F6D6570736575);
+      uint64_t v1 = k1 ^ UINT64_C(0x646F72616E646F6D);
+      uint64_t v2 = k0 ^ UINT64_C(0x6C7967656E657261);
+      uint64_t v3 = k1 ^ UINT64_C(0x7465646279746573);
+      size_t whole = length & ~(size_t)7;
+      for (size_t i = 0; i < whole; i += 8) // 8 bytes at a time
+      {
+         uint64_t m;
+         memcpy(&m, key + i, 8);
+         v3 ^= m;
+         round(v0, v1, v2, v3);
+         v0 ^= m;
+      }
+      uint64_t last = (uint64_t)length << 56; // the rest and the length
+      for (size_t i = whole; i < length; i++)
+      {
+         last |= (uint64_t)(unsigned char)key[i] << (8 * (i - whole));
+      }
+      v3 ^= last;
+      round(v0, v1, v2, v3);
+      v0 ^= last;
+      v2 ^= 0xFF;
+      round(v0, v1, v2, v3);
+      round(v0, v1, v2, v3);
+      round(v0, v1, v2, v3);
+      return (size_t)(v0 ^ v1 ^ v2 ^ v3);
+   }
+   uint64_t k0;
+   uint64_t k1;
+};
+
+// KEY EQUALITY
+
+struct CStringEqual
+{
+   bool operator() (const char * lhs, const char * rhs) const
+   {
+      return strcmp(lhs, rhs) == 0;
+   }
+};
+
+// GROWTH POLICIES
+// A growth policy picks the capacities a table grows through and maps a hash
+// value to a bucket index for the current capacity. reset() is called every
+// time the capacity changes so per capacity constants are computed once.
+
+// PowerOfTwoGrowth
+// Capacities are powers of two, so the index is a mask instead of a '%'.
+// Needs a hash whose low bits are good (CStringHash, KeyedStringHash).
+struct PowerOfTwoGrowth
+{
+   static size_t initialCapacity()
+   {
+      return 16;
+   }
+   static size_t nextCapacity(size_t capacity)
+   {
+      return capacity * 2;
+   }
+   void reset(size_t capacity)
+   {
+      mask = capacity - 1;
+   }
+   size_t index(size_t hash) const
+   {
+      return hash & mask;
+   }
+   size_t mask = 15;
+};
+
+// PrimeGrowth
+// Capacities are primes, roughly doubling each step, so even a weak hash
+// spreads over the buckets. The modulo is done with Lemire's fast modulo:
+// reset() precomputes M = 2^64 / capacity (rounded up), then the index is
+// two multiplies instead of a divide. Exact for 32 bit hashes and capacities.
+struct PrimeGrowth
+{
+   static size_t initialCapacity()
+   {
+      return 11;
+   }
+   static size_t nextCapacity(size_t capacity)
+   {
+      static const uint32_t PRIMES[] = { 11, 23, 47, 97, 197, 397, 797, 1597,
+         3203, 6421, 12853, 25717, 51437, 102877, 205759, 411527, 823117,
+         1646237, 3292489, 6584983, 13169977, 26339969, 52679969, 105359939,
+         210719881, 421439783, 842879579, 1685759167 };
+      const int count = sizeof(PRIMES) / sizeof(PRIMES[0]);
+      for (int i = 0; i < count; i++)
+      {
+         if (PRIMES[i] > capacity)
+         {
+            return PRIMES[i];
+         }
+      }
+      return capacity; // largest supported capacity
+   }
+   void reset(size_t capacity)
+   {
+      divisor = (uint32_t)capacity;
+      multiplier = UINT64_C(0xFFFFFFFFFFFFFFFF) / divisor + 1;
+   }
+   size_t index(size_t hash) const
+   {
+      uint32_t folded = (uint32_t)(hash ^ ((uint64_t)hash >> 32));
+      uint64_t lowbits = multiplier * folded;
+      return (size_t)(((unsigned __int128)lowbits * divisor) >> 64);
+   }
+   uint32_t divisor = 11;
+   uint64_t multiplier = UINT64_C(0xFFFFFFFFFFFFFFFF) / 11 + 1;
+};
+
+// BasicTable
+// Chained hash table with unique keys. Everything about it is a template
+// parameter, so each instantiation is its own specialized code with no
+// virtual calls:
+//    Value        - stored type (copied into the node)
+//    KeyExtractor - functor returning the key of a Value
+//    Hash         - functor hashing a key to size_t
+//    Equal        - functor comparing two keys
+//    GrowthPolicy - capacities and hash to index mapping (see above)
+// The table grows to the next capacity when size passes capacity (load
+// factor 1).
+template <class Value, class KeyExtractor, class Hash, class Equal,
+          class GrowthPolicy>
+class BasicTable
+{
+public:
+   typedef typename KeyExtractor::key_type Key;
+
+   BasicTable(); // constructor
+   BasicTable(const BasicTable& aTable); // copy constructor
+   BasicTable(BasicTable&& aTable); // move constructor
+   ~BasicTable(); // destructor
+   const BasicTable& operator= (const BasicTable& aTable);
+   const BasicTable& operator= (BasicTable&& aTable);
+
+   bool insert(const Value& value); // false if the key already exists
+   const Value * find(const Key& key) const; // nullptr if not found
+   Value * find(const Key& key); // nullptr if not found
+   bool erase(const Key& key); // false if not found
+   template <class Predicate>
+   int eraseIf(Predicate predicate); // remove every match, return count
+   template <class Visitor>
+   void forEach(Visitor visit) const; // call visit(value) on every value
+   int monitor(size_t index) const; // chain length at index, -1 if bad
+   size_t getSize() const; // number of values
+   size_t getCapacity() const; // number of buckets
+
+private:
+   struct Node // node struct for the chain
+   {
+      Node(const Value& aValue) : data(aValue), next(nullptr) {}
+      Value data;
+      Node * next;
+   };
+   Node ** heads; // array of chains
+   size_t capacity; // number of chains
+   size_t size; // number of values
+   GrowthPolicy growth; // capacity steps and hash to index mapping
+   KeyExtractor keyOf;
+   Hash hasher;
+   Equal equal;
+
+   size_t indexOf(const Key& key) const; // bucket index of a key
+   void grow(); // move every node to a bigger array
+   void copy(const BasicTable& aTable); // deep copy, preserves chain order
+   void destroy(); // free every node and the array
+};
+
+// Constructor
+// Description: Makes an empty table at the policy's initial capacity.
+template <class V, class K, class H, class E, class G>
+BasicTable<V, K, H, E, G>::BasicTable()
+{
+   capacity = G::initialCapacity();
+   size = 0;
+   growth.reset(capacity);
+   heads = new Node*[capacity]();
+}
+
+// Copy constructor
+template <class V, class K, class H, class E, class G>
+BasicTable<V, K, H, E, G>::BasicTable(const BasicTable & aTable)
+{
+   copy(aTable);
+}
+
+// Move constructor
+// Description: Takes the chains of the table passed in, which is left
+//              empty at its initial capacity.
+template <class V, class K, class H, class E, class G>
+BasicTable<V, K, H, E, G>::BasicTable(BasicTable && aTable)
+{
+   heads = nullptr;
+   capacity = 0;
+   size = 0;
+   *this = std::move(aTable);
+}
+
+// Destructor
+template <class V, class K, class H, class E, class G>
+BasicTable<V, K, H, E, G>::~BasicTable()
+{
+   destroy();
+}
+
+// assignment operator overload
+template <class V, class K, class H, class E, class G>
+const BasicTable<V, K, H, E, G> &
+BasicTable<V, K, H, E, G>::operator=(const BasicTable & aTable)
+{
+   if (this != &aTable)
+   {
+      destroy();
+      copy(aTable);
+   }
+   return *this;
+}
+
+// move assignment operator overload
+template <class V, class K, class H, class E, class G>
+const BasicTable<V, K, H, E, G> &
+BasicTable<V, K, H, E, G>::operator=(BasicTable && aTable)
+{
+   if (this != &aTable)
+   {
+      destroy();
+      heads = aTable.heads;
+      capacity = aTable.capacity;
+      size = aTable.size;
+      growth = aTable.growth;
+      keyOf = aTable.keyOf; // a keyed hash must keep the key it placed with
+      hasher = aTable.hasher;
+      equal = aTable.equal;
+      aTable.capacity = G::initialCapacity();
+      aTable.size = 0;
+      aTable.growth.reset(aTable.capacity);
+      aTable.heads = new Node*[aTable.capacity]();
+   }
+   return *this;
+}
+
+// indexOf
+// Description: Hashes the key and maps it to a bucket for the current
+//              capacity. Everything here is inlined into the caller.
+template <class V, class K, class H, class E, class G>
+inline size_t BasicTable<V, K, H, E, G>::indexOf(const Key & key) const
+{
+   return growth.index(hasher(key));
+}
+
+// insert
+// Description: Adds a copy of value at the head of its chain unless a value
+//              with the same key is already there. Grows first if full.
+// Input: value - the value to insert
+// Output: true if inserted, false if the key already exists
+template <class V, class K, class H, class E, class G>
+bool BasicTable<V, K, H, E, G>::insert(const V & value)
+{
+   Key key = keyOf(value);
+   size_t index = indexOf(key);
+   for (Node * curr = heads[index]; curr; curr = curr->next)
+   {
+      if (equal(keyOf(curr->data), key)) // key already exists
+      {
+         return false;
+      }
+   }
+   if (size >= capacity) // load factor would pass 1
+   {
+      grow();
+      index = indexOf(key);
+   }
+   Node * newNode = new Node(value);
+   newNode->next = heads[index];
+   heads[index] = newNode;
+   size++;
+   return true;
+}
+
+// find (const)
+// Description: Looks up the value with the key passed in.
+// Input: key - the key to look for
+// Output: pointer to the value in the table, nullptr if not found
+template <class V, class K, class H, class E, class G>
+const V * BasicTable<V, K, H, E, G>::find(const Key & key) const
+{
+   for (Node * curr = heads[indexOf(key)]; curr; curr = curr->next)
+   {
+      if (equal(keyOf(curr->data), key))
+      {
+         return &curr->data;
+      }
+   }
+   return nullptr;
+}
+
+// find
+// Description: Same as find (const), but the value can be changed. Changing
+//              the part of the value the key comes from is not allowed.
+template <class V, class K, class H, class E, class G>
+V * BasicTable<V, K, H, E, G>::find(const Key & key)
+{
+   return const_cast<V *>(static_cast<const BasicTable &>(*this).find(key));
+}
+
+// erase
+// Description: Removes the value with the key passed in.
+// Input: key - the key to remove
+// Output: true if something was removed, false if not found
+template <class V, class K, class H, class E, class G>
+bool BasicTable<V, K, H, E, G>::erase(const Key & key)
+{
+   size_t index = indexOf(key);
+   Node * prev = nullptr;
+   for (Node * curr = heads[index]; curr; prev = curr, curr = curr->next)
+   {
+      if (equal(keyOf(curr->data), key)) // match
+      {
+         if (prev) // removing in middle or at end
+         {
+            prev->next = curr->next;
+         }
+         else // removing at beginning
+         {
+            heads[index] = curr->next;
+         }
+         delete curr;
+         size--;
+         return true;
+      }
+   }
+   return false;
+}
+
+// eraseIf
+// Description: Removes every value the predicate returns true for.
+// Input: predicate - functor taking const Value & and returning bool
+// Output: the number of values removed
+template <class V, class K, class H, class E, class G>
+template <class Predicate>
+int BasicTable<V, K, H, E, G>::eraseIf(Predicate predicate)
+{
+   int removed = 0;
+   for (size_t i = 0; i < capacity; i++)
+   {
+      Node * prev = nullptr;
+      Node * curr = heads[i];
+      while (curr)
+      {
+         if (predicate(static_cast<const V &>(curr->data))) // match
+         {
+            Node * temp = curr;
+            if (prev) // removing in middle or at end
+            {
+               prev->next = curr->next;
+            }
+            else // removing at beginning
+            {
+               heads[i] = curr->next;
+            }
+            curr = curr->next;
+            delete temp;
+            size--;
+            removed++;
+         }
+         else // no match
+         {
+            prev = curr;
+            curr = curr->next;
+         }
+      }
+   }
+   return removed;
+}
+
+// forEach
+// Description: Calls visit on every value, bucket by bucket.
+// Input: visit - functor taking const Value &
+// Output: None
+template <class V, class K, class H, class E, class G>
+template <class Visitor>
+void BasicTable<V, K, H, E, G>::forEach(Visitor visit) const
+{
+   for (size_t i = 0; i < capacity; i++)
+   {
+      for (Node * curr = heads[i]; curr; curr = curr->next)
+      {
+         visit(static_cast<const V &>(curr->data));
+      }
+   }
+}
+
+// monitor
+// Description: Returns the chain length at index, -1 if out of bounds.
+template <class V, class K, class H, class E, class G>
+int BasicTable<V, K, H, E, G>::monitor(size_t index) const
+{
+   if (index >= capacity) // if the index is out of bounds
+   {
+      return -1;
+   }
+   int length = 0;
+   for (Node * curr = heads[index]; curr; curr = curr->next)
+   {
+      length++;
+   }
+   return length;
+}
+
+// getSize
+template <class V, class K, class H, class E, class G>
+size_t BasicTable<V, K, H, E, G>::getSize() const
+{
+   return size;
+}
+
+// getCapacity
+template <class V, class K, class H, class E, class G>
+size_t BasicTable<V, K, H, E, G>::getCapacity() const
+{
+   return capacity;
+}
+
+// grow
+// Description: Moves every node (no copies) into an array of the policy's
+//              next capacity.
+template <class V, class K, class H, class E, class G>
+void BasicTable<V, K, H, E, G>::grow()
+{
+   size_t newCapacity = G::nextCapacity(capacity);
+   if (newCapacity == capacity) // already as big as the policy goes
+   {
+      return;
+   }
+   Node ** newHeads = new Node*[newCapacity]();
+   growth.reset(newCapacity);
+   for (size_t i = 0; i < capacity; i++)
+   {
+      Node * curr = heads[i];
+      while (curr)
+      {
+         Node * next = curr->next;
+         size_t index = indexOf(keyOf(curr->data));
+         curr->next = newHeads[index];
+         newHeads[index] = curr;
+         curr = next;
+      }
+   }
+   delete [] heads;
+   heads = newHeads;
+   capacity = newCapacity;
+}
+
+// copy
+// Description: Deep copies the table passed in with the array allocated at
+//              its final size and each chain built front to back.
+template <class V, class K, class H, class E, class G>
+void BasicTable<V, K, H, E, G>::copy(const BasicTable & aTable)
+{
+   capacity = aTable.capacity;
+   size = aTable.size;
+   growth = aTable.growth;
+   keyOf = aTable.keyOf; // a keyed hash must keep the key it placed with
+   hasher = aTable.hasher;
+   equal = aTable.equal;
+   heads = new Node*[capacity]();
+   for (size_t i = 0; i < capacity; i++)
+   {
+      Node * tail = nullptr;
+      for (Node * curr = aTable.heads[i]; curr; curr = curr->next)
+      {
+         Node * newNode = new Node(curr->data);
+         if (tail)
+         {
+            tail->next = newNode;
+         }
+         else
+         {
+            heads[i] = newNode;
+         }
+         tail = newNode;
+      }
+   }
+}
+
+// destroy
+// Description: Deletes every node and the bucket array.
+template <class V, class K, class H, class E, class G>
+void BasicTable<V, K, H, E, G>::destroy()
+{
+   if (heads)
+   {
+      for (size_t i = 0; i < capacity; i++)
+      {
+         Node * curr = heads[i];
+         while (curr)
+         {
+            Node * temp = curr;
+            curr = curr->next;
+            delete temp;
+         }
+      }
+      delete [] heads;
+      heads = nullptr;
+   }
+   size = 0;
+}
+
+// COMMON INSTANTIATIONS
+
+// websites keyed by URL, power of two buckets
+typedef BasicTable<Website, UrlKey, CStringHash, CStringEqual,
+                   PowerOfTwoGrowth> UrlTable;
+
+#endif
@@ -0,0 +1,2102 @@
+/******************************************************************************
+# Program Desc.:      This program is a website bookmarking program. The program
+#                     implements a hash table using chaining (pointer array of
+#                     linked lists) to store website information.
+# File:               bench.cpp
+# File Description:   Benchmarks for the Table variants. Run as
+#                     "bench <name> [options]"; "bench" alone lists them.
+# Input:              Command line options
+# Output:             Timing results
+#******************************************************************************/
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <shared_mutex>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <cstring>
+#include <cstdlib>
+#include <cmath>
+#include <algorithm>
+#include <fstream>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <time.h>
+using namespace std;
+
+#include "table.h"
+#include "website.h"
+#include "sharded_table.h"
+#include "work_pool.h"
+#include "membership_filter.h"
+#include "record_parser.h"
+#include "columnar.h"
+#include "memory_stats.h"
+#include "cuckoo_table.h"
+#include "perf_counters.h"
+#include "epoch.h"
+#include "compact_table.h"
+#include "mapped_table.h"
+#include "async.h"
+
+// Function Prototypes
+int benchSharded(int argc, char * argv[]);
+int benchScan(int argc, char * argv[]);
+int benchFilter(int argc, char * argv[]);
+int benchCache(int argc, char * argv[]);
+int benchParse(int argc, char * argv[]);
+int legacyParse(const char * filename, long long & ratingTotal);
+int benchColumnar(int argc, char * argv[]);
+int benchMemory(int argc, char * argv[]);
+int benchEvict(int argc, char * argv[]);
+int benchAdversarial(int argc, char * argv[]);
+int benchResize(int argc, char * argv[]);
+int benchPerf(int argc, char * argv[]);
+int benchLockFree(int argc, char * argv[]);
+int benchBulk(int argc, char * argv[]);
+int sameRuns(const Table & a, const Table & b, const vector<string> & names);
+int bulkTrials(uint64_t seed, int trials);
+int benchCompact(int argc, char * argv[]);
+int sameSites(const Table & table, const CompactTable & compact,
+              const vector<string> & names);
+int benchMapped(int argc, char * argv[]);
+int sameMapped(const CompactTable & compact, const MappedTable & mapped,
+               const vector<string> & names);
+int benchAsync(int argc, char * argv[]);
+void printPercentiles(const string & name, vector<double> & nanos);
+template <class Lookup>
+void printLatencies(const char * name, double buildSeconds, int keys,
+                    const vector<string> & probes, Lookup lookup);
+void printAllocations(const char * name, const AllocationCounter & counter,
+                      int ops);
+Website makeWebsite(const string &topic, const string &url, int rating);
+int intOption(int argc, char * argv[], const char * name, int fallback);
+double secondsSince(chrono::steady_clock::time_point start);
+
+// Benchmark
+// Name, description and entry point of one benchmark
+struct Benchmark
+{
+   const char * name;
+   const char * description;
+   int (*run)(int argc, char * argv[]);
+};
+
+const Benchmark BENCHMARKS[] = {
+   { "sharded", "mutex guarded Table vs ShardedTable, 1..cores threads "
+                "[--ops n] [--topics n] [--sites n]", benchSharded },
+   { "scan", "sequential vs work stealing parallel scans and purge "
+             "[--sites n] [--topics n] [--threads n]", benchScan },
+   { "filter", "retrieve with and without the membership filter, hit rate "
+               "0..100% [--sites n] [--topics n] [--lookups n]", benchFilter },
+   { "cache", "retrieveShared with and without the result cache on Zipf "
+              "topics, and retrieve, which never uses the cache "
+              "[--sites n] [--topics n] [--ops n] [--skew percent] "
+              "[--cache topics] [--writes percent]", benchCache },
+   { "parse", "old getline loader vs RecordParser, clean and damaged files "
+              "[--records n]", benchParse },
+   { "columnar", "columnar export and mapped column scans vs table scans "
+                 "[--sites n] [--topics n]", benchColumnar },
+   { "memory", "allocations per operation and the table's memory report "
+               "[--sites n] [--topics n] [--ops n]", benchMemory },
+   { "evict", "hit rate of each eviction policy for a table used as a "
+              "bounded cache on Zipf keys [--keys n] [--cap n] [--ops n] "
+              "[--skew percent] [--correlated 0|1]", benchEvict },
+   { "adversarial", "insert and lookup latency percentiles on anagram "
+                    "topics: chained Table, keyed Table, FNV BasicTable, "
+                    "CuckooTable [--keys n] [--lookups n]", benchAdversarial },
+   { "resize", "insert and lookup latency percentiles while growing: "
+               "incremental Table resize vs stop-the-world BasicTable "
+               "rehash vs presized Table [--sites n]", benchResize },
+   { "perf", "hardware counters (cycles, instructions, LLC and branch "
+             "misses) per Table operation, TopicSumHash vs keyed hash "
+             "[--sites n] [--topics n] [--ops n]", benchPerf },
+   { "lockfree", "retrieve throughput of reader threads alone, next to a "
+                 "writer, and next to a writer behind a shared_mutex "
+                 "[--sites n] [--topics n] [--readers n] [--millis n]",
+                 benchLockFree },
+   { "bulk", "cold load with insert one at a time vs insertBulk, checking "
+             "both give the same runs [--sites n] [--topics n] "
+             "[--dupes percent] [--cross percent] [--chunks n]", benchBulk },
+   { "compact", "memory per website and lookup speed of Table vs the 32 "
+                "bit index CompactTable [--sites n] [--topics n] "
+                "[--lookups n]", benchCompact },
+   { "mapped", "MappedTable: load, checkpoint and reopen times of a table "
+               "living in a file, checked against a CompactTable, and a "
+               "crash before a checkpoint [--sites n] [--topics n]",
+     benchMapped },
+   { "async", "exportAsync then loadAsync round trip, checked against "
+              "loadFromFile of the same file, lookups served while it "
+              "loads, and a failing read [--sites n] [--topics n]",
+     benchAsync },
+};
+const int NUM_BENCHMARKS = sizeof(BENCHMARKS) / sizeof(BENCHMARKS[0]);
+
+int main(int argc, char * argv[])
+{
+   for (int i = 0; argc > 1 && i < NUM_BENCHMARKS; i++)
+   {
+      if (strcmp(argv[1], BENCHMARKS[i].name) == 0)
+      {
+         return BENCHMARKS[i].run(argc - 1, argv + 1);
+      }
+   }
+   cerr << "Usage: bench <name> [options]" << endl;
+   for (int i = 0; i < NUM_BENCHMARKS; i++)
+   {
+      cerr << "  " << left << setw(10) << BENCHMARKS[i].name
+           << BENCHMARKS[i].description << endl;
+   }
+   return 1;
+}
+
+// makeWebsite function
+// Description: Builds a synthetic website.
+// Input: topic, url, rating
+// Output: the website
+Website makeWebsite(const string &topic, const string &url, int rating)
+{
+   Website website;
+   string summary = "synthetic summary for " + url;
+   string review = "synthetic review";
+   website.setTopic(const_cast<char *>(topic.c_str()));
+   website.setURL(const_cast<char *>(url.c_str()));
+   website.setSummary(&summary[0]);
+   website.setReview(&review[0]);
+   website.setRating(rating);
+   return website;
+}
+
+// intOption function
+// Description: Returns the value after --name on the command line.
+// Input: argc, argv, name (without --), fallback if it is not there
+// Output: the value
+int intOption(int argc, char * argv[], const char * name, int fallback)
+{
+   for (int i = 1; i + 1 < argc; i++)
+   {
+      if (strncmp(argv[i], "--", 2) == 0 && strcmp(argv[i] + 2, name) == 0)
+      {
+         return atoi(argv[i + 1]);
+      }
+   }
+   return fallback;
+}
+
+// secondsSince function
+// Description: Seconds elapsed since start.
+double secondsSince(chrono::steady_clock::time_point start)
+{
+   return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+// benchSharded function
+// Description: Loads topics * sites websites, then runs 1, 2, 4, ... up to
+//              the core count client threads, each doing ops operations
+//              (90% retrieve, 10% edit on random topics), first against one
+//              Table behind a mutex, then against a ShardedTable with one
+//              shard per client thread. Prints operations per second and
+//              the core count, since sharding only pays with more than one
+//              core: on one, each request is a hand off to another thread.
+// Input: argc, argv
+// Output: 0
+int benchSharded(int argc, char * argv[])
+{
+   int ops = intOption(argc, argv, "ops", 20000);
+   int topics = intOption(argc, argv, "topics", 200);
+   int sites = intOption(argc, argv, "sites", 5);
+   int cores = (int)thread::hardware_concurrency();
+   if (cores < 1)
+   {
+      cores = 1;
+   }
+   vector<Website> websites;
+   for (int i = 0; i < topics * sites; i++)
+   {
+      websites.push_back(makeWebsite("topic-" + to_string(i % topics),
+                                     "https://site/" + to_string(i),
+                                     i % 5 + 1));
+   }
+
+   cout << cores << (cores == 1 ? " core" : " cores")
+        << ": ShardedTable only pays with more than one core" << endl;
+   cout << "threads  mutex Table ops/s  ShardedTable ops/s" << endl;
+   for (int threads = 1; threads <= cores; threads *= 2)
+   {
+      // one table, one lock
+      Table table;
+      mutex tableLock;
+      for (size_t i = 0; i < websites.size(); i++)
+      {
+         table.insert(websites[i]);
+      }
+      vector<thread> clients;
+      chrono::steady_clock::time_point start = chrono::steady_clock::now();
+      for (int t = 0; t < threads; t++)
+      {
+         clients.push_back(thread([&, t]
+         {
+            mt19937 random(t);
+            vector<Website> matches(sites);
+            int found = 0;
+            for (int i = 0; i < ops; i++)
+            {
+               int site = random() % websites.size();
+               const Website &website = websites[site];
+               lock_guard<mutex> guard(tableLock);
+               if (i % 10 == 0)
+               {
+                  char review[] = "edited";
+                  table.edit(const_cast<char *>(website.getTopic()),
+                             const_cast<char *>(website.getURL()), review,
+                             site % 5 + 1);
+               }
+               else
+               {
+                  table.retrieve(website.getTopic(), matches.data(), found);
+               }
+            }
+         }));
+      }
+      for (int t = 0; t < threads; t++)
+      {
+         clients[t].join();
+      }
+      double lockedRate = threads * (double)ops / secondsSince(start);
+
+      // one shard per client thread
+      ShardedTable sharded(threads);
+      for (size_t i = 0; i < websites.size(); i++)
+      {
+         sharded.insert(websites[i]);
+      }
+      clients.clear();
+      start = chrono::steady_clock::now();
+      for (int t = 0; t < threads; t++)
+      {
+         clients.push_back(thread([&, t]
+         {
+            mt19937 random(t);
+            vector<Website> matches(sites);
+            int found = 0;
+            for (int i = 0; i < ops; i++)
+            {
+               int site = random() % websites.size();
+               const Website &website = websites[site];
+               if (i % 10 == 0)
+               {
+                  sharded.edit(website.getTopic(), website.getURL(),
+                               "edited", site % 5 + 1);
+               }
+               else
+               {
+                  sharded.retrieve(website.getTopic(), matches.data(), found);
+               }
+            }
+         }));
+      }
+      for (int t = 0; t < threads; t++)
+      {
+         clients[t].join();
+      }
+      double shardedRate = threads * (double)ops / secondsSince(start);
+      cout << setw(7) << threads << fixed << setprecision(0) << setw(19)
+           << lockedRate << setw(20) << shardedRate << endl;
+   }
+   return 0;
+}
+
+// benchScan function
+// Description: Builds a table of sites websites, by default each with its
+//              own topic, spread evenly over the buckets by the keyed hash
+//              (a topic with many websites would make the build walk its
+//              run on every insert), then times countIf, averageRatings and
+//              removeOneStar run sequentially and on a WorkStealingPool,
+//              and checks that the parallel results are identical to the
+//              sequential ones.
+// Input: argc, argv
+// Output: 0 if every parallel result matched, 1 if not
+int benchScan(int argc, char * argv[])
+{
+   int sites = intOption(argc, argv, "sites", 1000000);
+   int topics = intOption(argc, argv, "topics", sites);
+   WorkStealingPool pool(intOption(argc, argv, "threads", 0));
+   Table table(sites, randomSeed(), randomSeed()); // no pile ups
+   for (int i = 0; i < sites; i++)
+   {
+      table.insert(makeWebsite("topic-" + to_string(i % topics),
+                               "https://site/" + to_string(i), i % 5 + 1));
+   }
+   cout << sites << " websites, " << topics << " topics, "
+        << table.getCapacity() << " buckets, " << pool.getThreadCount()
+        << " threads" << endl;
+   cout << "scan            sequential s   parallel s   same" << endl;
+   bool allSame = true;
+   function<bool(const Website &)> fourPlus = [](const Website &website)
+   {
+      return website.getRating() >= 4;
+   };
+
+   chrono::steady_clock::time_point start = chrono::steady_clock::now();
+   int sequentialCount = table.countIf(fourPlus);
+   double sequential = secondsSince(start);
+   start = chrono::steady_clock::now();
+   int parallelCount = table.countIf(fourPlus, &pool);
+   double parallel = secondsSince(start);
+   bool same = sequentialCount == parallelCount;
+   allSame = allSame && same;
+   cout << left << setw(16) << "countIf" << right << fixed << setprecision(4)
+        << setw(12) << sequential << setw(13) << parallel << setw(7)
+        << (same ? "yes" : "NO") << endl;
+
+   start = chrono::steady_clock::now();
+   vector<TopicRating> sequentialRatings = table.averageRatings();
+   sequential = secondsSince(start);
+   start = chrono::steady_clock::now();
+   vector<TopicRating> parallelRatings = table.averageRatings(&pool);
+   parallel = secondsSince(start);
+   same = sequentialRatings.size() == parallelRatings.size();
+   for (size_t i = 0; same && i < sequentialRatings.size(); i++)
+   {
+      same = sequentialRatings[i].topic == parallelRatings[i].topic &&
+             sequentialRatings[i].count == parallelRatings[i].count &&
+             sequentialRatings[i].average == parallelRatings[i].average;
+   }
+   allSame = allSame && same;
+   cout << left << setw(16) << "averageRatings" << right << setw(12)
+        << sequential << setw(13) << parallel << setw(7)
+        << (same ? "yes" : "NO") << endl;
+
+   Table sequentialTable(table);
+   Table parallelTable(table);
+   start = chrono::steady_clock::now();
+   sequentialTable.removeOneStar();
+   sequential = secondsSince(start);
+   start = chrono::steady_clock::now();
+   parallelTable.removeOneStar(pool);
+   parallel = secondsSince(start);
+   same = sequentialTable.getSize() == parallelTable.getSize();
+   Table::const_iterator sequentialIt = sequentialTable.begin();
+   Table::const_iterator parallelIt = parallelTable.begin();
+   for (; same && sequentialIt != sequentialTable.end(); ++sequentialIt)
+   {
+      same = parallelIt != parallelTable.end() &&
+             strcmp(sequentialIt->getURL(), parallelIt->getURL()) == 0;
+      ++parallelIt;
+   }
+   allSame = allSame && same;
+   cout << left << setw(16) << "removeOneStar" << right << setw(12)
+        << sequential << setw(13) << parallel << setw(7)
+        << (same ? "yes" : "NO") << endl;
+   return allSame ? 0 : 1;
+}
+
+// benchFilter function
+// Description: Builds the same table of sites websites with and without the
+//              membership filter, then times lookups lookups of topics of
+//              which 0%, 25%, ... 100% exist (misses are anagrams of real
+//              topics, so without the filter they walk a full chain), and checks both tables found
+//              the same websites. Also measures the filter's false "maybe"
+//              rate on URLs that were never added.
+// Input: argc, argv
+// Output: 0 if both tables always agreed, 1 if not
+int benchFilter(int argc, char * argv[])
+{
+   int sites = intOption(argc, argv, "sites", 20000);
+   int topics = intOption(argc, argv, "topics", 1000);
+   int lookups = intOption(argc, argv, "lookups", 200000);
+   Table plain(sites);
+   Table filtered(sites); // built the same way, so node layout matches
+   filtered.enableFilter(sites);
+   for (int i = 0; i < sites; i++)
+   {
+      Website website = makeWebsite("topic-" + to_string(i % topics),
+                                    "https://site/" + to_string(i), i % 5 + 1);
+      plain.insert(website);
+      filtered.insert(website);
+   }
+   cout << sites << " websites, " << topics << " topics, " << lookups
+        << " lookups" << endl;
+   cout << "hit %   plain ns/lookup   filtered ns/lookup   same" << endl;
+
+   vector<Website> matches(sites / topics + 1);
+   bool allSame = true;
+   for (int hitPercent = 0; hitPercent <= 100; hitPercent += 25)
+   {
+      mt19937 random(hitPercent);
+      vector<string> keys;
+      for (int i = 0; i < lookups; i++)
+      {
+         bool hit = (int)(random() % 100) < hitPercent;
+         // "tpoic-n" is an anagram, so a miss walks the same chain a hit does
+         keys.push_back((hit ? "topic-" : "tpoic-") +
+                        to_string(random() % topics));
+      }
+      int plainFound = 0;
+      int found = 0;
+      chrono::steady_clock::time_point start = chrono::steady_clock::now();
+      for (int i = 0; i < lookups; i++)
+      {
+         if (plain.retrieve(keys[i].c_str(), matches.data(), found))
+         {
+            plainFound += found;
+         }
+      }
+      double plainTime = secondsSince(start);
+      int filteredFound = 0;
+      start = chrono::steady_clock::now();
+      for (int i = 0; i < lookups; i++)
+      {
+         if (filtered.retrieve(keys[i].c_str(), matches.data(), found))
+         {
+            filteredFound += found;
+         }
+      }
+      double filteredTime = secondsSince(start);
+      bool same = plainFound == filteredFound;
+      allSame = allSame && same;
+      cout << setw(5) << hitPercent << fixed << setprecision(1) << setw(18)
+           << plainTime * 1e9 / lookups << setw(21)
+           << filteredTime * 1e9 / lookups << setw(7)
+           << (same ? "yes" : "NO") << endl;
+   }
+
+   MembershipFilter urls(sites);
+   for (int i = 0; i < sites; i++)
+   {
+      urls.add(MembershipFilter::hash(("https://site/" +
+                                       to_string(i)).c_str(), 0));
+   }
+   int maybes = 0;
+   for (int i = 0; i < lookups; i++)
+   {
+      string absent = "https://absent/" + to_string(i);
+      maybes += urls.mayContain(MembershipFilter::hash(absent.c_str(), 0));
+   }
+   cout << "false maybe rate on absent URLs: " << setprecision(2)
+        << 100.0 * maybes / lookups << "%" << endl;
+   return allSame ? 0 : 1;
+}
+
+// benchCache function
+// Description: Runs ops operations on topics drawn from a Zipf distribution
+//              (topic of rank r is picked in proportion to 1 / r^skew), with
+//              writes percent of them edits, through retrieve, then
+//              retrieveShared without the result cache, then
+//              retrieveShared with it. Prints the time per operation and
+//              the cache's hit rate, and checks every run found the same
+//              websites and that, once at least half the lookups hit, the
+//              cache makes retrieveShared faster.
+// Input: argc, argv
+// Output: 0 if every run agreed and the cache paid off, 1 if not
+int benchCache(int argc, char * argv[])
+{
+   int sites = intOption(argc, argv, "sites", 20000);
+   int topics = intOption(argc, argv, "topics", 1000);
+   int ops = intOption(argc, argv, "ops", 200000);
+   double skew = intOption(argc, argv, "skew", 100) / 100.0;
+   int cacheTopics = intOption(argc, argv, "cache", 100);
+   int writes = intOption(argc, argv, "writes", 1);
+   vector<Website> websites;
+   for (int i = 0; i < sites; i++)
+   {
+      websites.push_back(makeWebsite("topic-" + to_string(i % topics),
+                                     "https://site/" + to_string(i),
+                                     i % 5 + 1));
+   }
+
+   // cumulative Zipf weights, searched with a uniform draw
+   vector<double> cumulative(topics);
+   double total = 0;
+   for (int r = 0; r < topics; r++)
+   {
+      total += 1.0 / pow(r + 1, skew);
+      cumulative[r] = total;
+   }
+   mt19937 random(1);
+   uniform_real_distribution<double> uniform(0, total);
+   vector<int> picks(ops); // website index for edits, topic for lookups
+   for (int i = 0; i < ops; i++)
+   {
+      int topic = (int)(lower_bound(cumulative.begin(), cumulative.end(),
+                                    uniform(random)) - cumulative.begin());
+      picks[i] = topic < topics ? topic : topics - 1;
+      if ((int)(random() % 100) < writes) // an edit of one of its websites
+      {
+         picks[i] = -(picks[i] + topics * (int)(random() % (sites / topics)))
+                    - 1;
+      }
+   }
+   cout << sites << " websites, " << topics << " topics, " << ops
+        << " ops, skew " << skew << ", " << cacheTopics << " cached topics, "
+        << writes << "% edits" << endl;
+   cout << "run                 ns/op   hit %   same" << endl;
+
+   vector<Website> matches(sites / topics + 1);
+   uint64_t seeds[2] = { randomSeed(), randomSeed() }; // even chains, so a
+                                                       // miss costs the same
+                                                       // for every topic
+   long long expected = 0;
+   bool allSame = true;
+   double nsPerOp[3];
+   double hitRate = 0;
+   for (int run = 0; run < 3; run++)
+   {
+      Table table(sites, seeds[0], seeds[1]);
+      for (int i = 0; i < sites; i++)
+      {
+         table.insert(websites[i]);
+      }
+      if (run == 2)
+      {
+         table.enableCache(cacheTopics);
+      }
+      long long foundTotal = 0;
+      chrono::steady_clock::time_point start = chrono::steady_clock::now();
+      for (int i = 0; i < ops; i++)
+      {
+         if (picks[i] < 0) // edit
+         {
+            const Website & website = websites[-picks[i] - 1];
+            char review[] = "edited";
+            table.edit(const_cast<char *>(website.getTopic()),
+                       const_cast<char *>(website.getURL()), review,
+                       i % 5 + 1);
+            continue;
+         }
+         string topic = "topic-" + to_string(picks[i]);
+         int found = 0;
+         if (run == 0)
+         {
+            table.retrieve(topic.c_str(), matches.data(), found);
+         }
+         else
+         {
+            found = (int)table.retrieveShared(topic.c_str())->size();
+         }
+         foundTotal += found;
+      }
+      double seconds = secondsSince(start);
+      if (run == 0)
+      {
+         expected = foundTotal;
+      }
+      bool same = foundTotal == expected;
+      allSame = allSame && same;
+      CacheStats stats = table.getCacheStats();
+      long long lookups = stats.hits + stats.misses;
+      const char * names[] = { "retrieve", "retrieveShared",
+                               "cached retrieveShared" };
+      nsPerOp[run] = seconds * 1e9 / ops;
+      hitRate = lookups ? 100.0 * stats.hits / lookups : 0.0;
+      cout << left << setw(22) << names[run] << right << fixed
+           << setprecision(0) << setw(8) << nsPerOp[run]
+           << setprecision(1) << setw(8) << hitRate << setw(7)
+           << (same ? "yes" : "NO") << endl;
+   }
+   bool cacheWins = nsPerOp[2] < nsPerOp[1];
+   cout << "cache speedup for retrieveShared: " << setprecision(2)
+        << nsPerOp[1] / nsPerOp[2] << "x" << endl;
+   cout.unsetf(ios::fixed);
+   return allSame && (cacheWins || hitRate < 50) ? 0 : 1;
+}
+
+// legacyParse function
+// Description: The record reading loop loadFromFile used before
+//              RecordParser (fixed size buffers, getline, >> for the
+//              rating), kept here to compare against. Parses only.
+// Input: filename - the file
+//        ratingTotal - sum of the ratings read, passed back
+// Output: the number of records read
+int legacyParse(const char * filename, long long & ratingTotal)
+{
+   ifstream inFile(filename);
+   char topic[MAX_CSTRING], url[MAX_CSTRING], summary[MAX_PARAGRAPH],
+        review[MAX_PARAGRAPH];
+   int rating = 0;
+   int count = 0;
+   ratingTotal = 0;
+   Website website;
+   while (inFile.getline(topic, MAX_CSTRING))
+   {
+      if (strlen(topic) == 0)
+      {
+         continue;
+      }
+      inFile.getline(url, MAX_CSTRING);
+      inFile.getline(summary, MAX_PARAGRAPH);
+      inFile.getline(review, MAX_PARAGRAPH);
+      inFile >> rating;
+      inFile.ignore();
+      website.setTopic(topic);
+      website.setURL(url);
+      website.setSummary(summary);
+      website.setReview(review);
+      website.setRating(rating);
+      ratingTotal += rating;
+      count++;
+   }
+   return count;
+}
+
+// benchParse function
+// Description: Writes records websites to a scratch file and times the old
+//              loader's parse loop against RecordParser on it (parsing only,
+//              no inserts). Then damages a copy: one summary of 2000 chars,
+//              one rating of "4 stars" and CRLF line ends, and shows how
+//              many records each one still reads.
+// Input: argc, argv
+// Output: 0 if both read the clean file the same and RecordParser read
+//         every good record of the damaged one, 1 if not
+int benchParse(int argc, char * argv[])
+{
+   int records = intOption(argc, argv, "records", 200000);
+   string clean = "/tmp/bench_parse_" + to_string(getpid()) + ".txt";
+   string damaged = clean + ".damaged";
+   {
+      ofstream out(clean.c_str());
+      ofstream bad(damaged.c_str());
+      string summary(200, 's');
+      string review(100, 'r');
+      for (int i = 0; i < records; i++)
+      {
+         string record = "topic-" + to_string(i % 1000) + "\n" +
+                         "https://site/" + to_string(i) + "\n" + summary +
+                         "\n" + review + "\n" + to_string(i % 5 + 1) +
+                         "\n\n";
+         out << record;
+         if (i == records / 3) // too long for the old loader's buffers
+         {
+            record = "long\nhttps://long\n" + string(2000, 'l') +
+                     "\nreview\n3\n\n";
+         }
+         else if (i == 2 * records / 3) // not a whole number
+         {
+            record = "stars\nhttps://stars\nsummary\nreview\n4 stars\n\n";
+         }
+         for (size_t c = 0; c < record.size(); c++) // CRLF line ends
+         {
+            bad << (record[c] == '\n' ? "\r\n" : string(1, record[c]));
+         }
+      }
+   }
+
+   cout << "file      loader          records   rating total   seconds"
+        << endl;
+   long long legacyTotal = 0;
+   chrono::steady_clock::time_point start = chrono::steady_clock::now();
+   int legacyCount = legacyParse(clean.c_str(), legacyTotal);
+   double legacySeconds = secondsSince(start);
+
+   long long parsedTotal = 0;
+   RecordParser parser;
+   start = chrono::steady_clock::now();
+   parser.parseFile(clean.c_str(), [&parsedTotal](const Website & website)
+   {
+      parsedTotal += website.getRating();
+   });
+   double parsedSeconds = secondsSince(start);
+   cout << left << setw(10) << "clean" << setw(14) << "getline" << right
+        << setw(9) << legacyCount << setw(15) << legacyTotal << fixed
+        << setprecision(4) << setw(10) << legacySeconds << endl;
+   cout << left << setw(10) << "clean" << setw(14) << "RecordParser" << right
+        << setw(9) << parser.getRecordCount() << setw(15) << parsedTotal
+        << setw(10) << parsedSeconds << endl;
+   bool ok = legacyCount == parser.getRecordCount() &&
+             legacyTotal == parsedTotal;
+
+   legacyCount = legacyParse(damaged.c_str(), legacyTotal);
+   RecordParser damagedParser;
+   parsedTotal = 0;
+   damagedParser.parseFile(damaged.c_str(),
+                           [&parsedTotal](const Website & website)
+   {
+      parsedTotal += website.getRating();
+   });
+   cout << left << setw(10) << "damaged" << setw(14) << "getline" << right
+        << setw(9) << legacyCount << setw(15) << legacyTotal << endl;
+   cout << left << setw(10) << "damaged" << setw(14) << "RecordParser"
+        << right << setw(9) << damagedParser.getRecordCount() << setw(15)
+        << parsedTotal << endl;
+   damagedParser.reportErrors(cout, "damaged");
+   ok = ok && damagedParser.getRecordCount() == records - 1;
+   remove(clean.c_str());
+   remove(damaged.c_str());
+   return ok ? 0 : 1;
+}
+
+// benchColumnar function
+// Description: Builds a table of sites websites, exports it to a scratch
+//              columnar file and maps it back, then times rating
+//              histogram, per topic count and 4 star count scans over the
+//              mapped columns against the same answers from the table's own
+//              scans (countIf, averageRatings), and checks they agree.
+// Input: argc, argv
+// Output: 0 if every answer agreed, 1 if not
+int benchColumnar(int argc, char * argv[])
+{
+   int sites = intOption(argc, argv, "sites", 20000);
+   int topics = intOption(argc, argv, "topics", 1000);
+   Table table(sites);
+   for (int i = 0; i < sites; i++)
+   {
+      table.insert(makeWebsite("topic-" + to_string(i % topics),
+                               "https://site/" + to_string(i), i % 5 + 1));
+   }
+   string path = "/tmp/bench_columnar_" + to_string(getpid()) + ".col";
+   chrono::steady_clock::time_point start = chrono::steady_clock::now();
+   bool ok = exportColumnar(table, path.c_str());
+   double exportSeconds = secondsSince(start);
+   ColumnarFile columns;
+   start = chrono::steady_clock::now();
+   ok = ok && columns.open(path.c_str());
+   double openSeconds = secondsSince(start);
+   if (!ok)
+   {
+      cerr << "could not write or map " << path << endl;
+      return 1;
+   }
+   cout << sites << " websites, " << columns.getTopicCount() << " topics"
+        << endl;
+   cout << fixed << setprecision(4) << "export " << exportSeconds
+        << " s, open and check " << openSeconds << " s" << endl;
+   cout << "scan                 table s   columns s   same" << endl;
+
+   // rating histogram
+   start = chrono::steady_clock::now();
+   vector<long long> tableHistogram(6, 0);
+   for (int rating = 0; rating <= 5; rating++)
+   {
+      tableHistogram[rating] = table.countIf([rating](const Website & website)
+      {
+         return website.getRating() == rating;
+      });
+   }
+   double tableSeconds = secondsSince(start);
+   start = chrono::steady_clock::now();
+   vector<long long> columnHistogram = columns.ratingHistogram(5);
+   double columnSeconds = secondsSince(start);
+   bool same = tableHistogram == columnHistogram;
+   bool allSame = same;
+   cout << left << setw(18) << "rating histogram" << right << setw(10)
+        << tableSeconds << setw(12) << columnSeconds << setw(7)
+        << (same ? "yes" : "NO") << endl;
+
+   // websites and average rating per topic
+   start = chrono::steady_clock::now();
+   vector<TopicRating> tableTopics = table.averageRatings();
+   tableSeconds = secondsSince(start);
+   start = chrono::steady_clock::now();
+   vector<long long> counts = columns.topicCounts();
+   vector<long long> totals = columns.topicRatingTotals();
+   columnSeconds = secondsSince(start);
+   same = (int)tableTopics.size() == columns.getTopicCount();
+   for (int id = 0; same && id < columns.getTopicCount(); id++)
+   {
+      string topic = columns.topic(id);
+      vector<TopicRating>::iterator match = lower_bound(tableTopics.begin(),
+         tableTopics.end(), topic, [](const TopicRating & rating,
+                                      const string & name)
+         {
+            return rating.topic < name;
+         });
+      same = match != tableTopics.end() && match->topic == topic &&
+             match->count == counts[id] && match->ratingTotal == totals[id];
+   }
+   allSame = allSame && same;
+   cout << left << setw(18) << "per topic totals" << right << setw(10)
+        << tableSeconds << setw(12) << columnSeconds << setw(7)
+        << (same ? "yes" : "NO") << endl;
+
+   // 4 stars or better
+   start = chrono::steady_clock::now();
+   int tableCount = table.countIf([](const Website & website)
+   {
+      return website.getRating() >= 4;
+   });
+   tableSeconds = secondsSince(start);
+   start = chrono::steady_clock::now();
+   long long columnCount = columns.countRatingAtLeast(4);
+   columnSeconds = secondsSince(start);
+   same = tableCount == columnCount;
+   allSame = allSame && same;
+   cout << left << setw(18) << "4 stars or better" << right << setw(10)
+        << tableSeconds << setw(12) << columnSeconds << setw(7)
+        << (same ? "yes" : "NO") << endl;
+   columns.close();
+   remove(path.c_str());
+   return allSame ? 0 : 1;
+}
+
+// benchMemory function
+// Description: Builds a table of sites websites, then counts the heap
+//              allocations and frees of ops inserts, retrieves, topK calls
+//              and edits (without and with a live snapshot, which makes
+//              edits copy their chain) and of one removeOneStar, using an
+//              AllocationCounter hook. Ends with the table's memory report.
+// Input: argc, argv
+// Output: 0 if every counted allocation was freed again, 1 if not
+int benchMemory(int argc, char * argv[])
+{
+   int sites = intOption(argc, argv, "sites", 20000);
+   int topics = intOption(argc, argv, "topics", 1000);
+   int ops = intOption(argc, argv, "ops", 2000);
+   AllocationCounter counter;
+   long long balance = 0; // allocations minus frees over the whole run
+   {
+      ScopedMemoryHook hook(&counter);
+      Table table(sites + ops);
+      for (int i = 0; i < sites; i++)
+      {
+         table.insert(makeWebsite("topic-" + to_string(i % topics),
+                                  "https://site/" + to_string(i), i % 5 + 1));
+      }
+      cout << sites << " websites, " << topics << " topics, " << ops
+           << " ops" << endl;
+      printAllocations("build", counter, sites);
+      cout << "operation          allocs/op    frees/op    bytes/op" << endl;
+
+      vector<Website> websites;
+      for (int i = 0; i < ops; i++)
+      {
+         websites.push_back(makeWebsite("topic-" + to_string(i % topics),
+                                        "https://new/" + to_string(i), 3));
+      }
+      balance += counter.getAllocations() - counter.getFrees();
+      counter.reset();
+      for (int i = 0; i < ops; i++)
+      {
+         table.insert(websites[i]);
+      }
+      printAllocations("insert", counter, ops);
+
+      vector<Website> matches((sites + ops) / topics + 1);
+      int found = 0;
+      balance += counter.getAllocations() - counter.getFrees();
+      counter.reset();
+      for (int i = 0; i < ops; i++)
+      {
+         table.retrieve(("topic-" + to_string(i % topics)).c_str(),
+                        matches.data(), found);
+      }
+      printAllocations("retrieve", counter, ops);
+
+      const Website * top[5];
+      balance += counter.getAllocations() - counter.getFrees();
+      counter.reset();
+      for (int i = 0; i < ops; i++)
+      {
+         table.topK(("topic-" + to_string(i % topics)).c_str(), 5, top,
+                    found);
+      }
+      printAllocations("topK", counter, ops);
+
+      char review[] = "edited review";
+      for (int pass = 0; pass < 2; pass++)
+      {
+         Table::Snapshot * snapshot = nullptr;
+         balance += counter.getAllocations() - counter.getFrees();
+         counter.reset();
+         for (int i = 0; i < ops; i++)
+         {
+            if (pass == 1)
+            {
+               delete snapshot; // a fresh snapshot before every edit
+               snapshot = new Table::Snapshot(table.snapshot());
+            }
+            string topic = "topic-" + to_string(i % topics);
+            string url = "https://site/" + to_string(i);
+            table.edit(&topic[0], &url[0], review, i % 5 + 1);
+         }
+         delete snapshot;
+         printAllocations(pass == 0 ? "edit" : "edit + snapshot", counter,
+                          ops);
+      }
+
+      balance += counter.getAllocations() - counter.getFrees();
+      counter.reset();
+      table.removeOneStar();
+      printAllocations("removeOneStar", counter, 1);
+      balance += counter.getAllocations() - counter.getFrees();
+      counter.reset();
+
+      cout << endl << table.memoryReport();
+   }
+   {
+      ScopedMemoryHook hook(&counter); // deletes what readers might have seen
+      epochSynchronize();
+   }
+   balance += counter.getAllocations() - counter.getFrees();
+   cout << "blocks not freed after the table was destroyed: " << balance
+        << endl;
+   return balance == 0 ? 0 : 1;
+}
+
+// printAllocations function
+// Description: Prints one line of counts per operation.
+// Input: name - operation, counter - its counts, ops - operations counted
+// Output: None
+void printAllocations(const char * name, const AllocationCounter & counter,
+                      int ops)
+{
+   cout << left << setw(16) << name << right << fixed << setprecision(2)
+        << setw(12) << (double)counter.getAllocations() / ops << setw(12)
+        << (double)counter.getFrees() / ops << setw(12)
+        << (double)counter.getBytesAllocated() / ops << endl;
+}
+
+// benchEvict function
+// Description: Uses a Table as a bounded cache in front of a store of keys
+//              websites (one per topic). ops lookups of topics drawn from a
+//              Zipf distribution retrieve the topic and, on a miss, insert
+//              its website as if fetched from the store. Runs once without
+//              a budget (only first time misses) and once per eviction
+//              policy with at most cap websites, printing the hit rate and
+//              time per lookup. Ratings are random, or with --correlated 1
+//              higher for more popular keys. Ends with a byte budget run
+//              that checks the tracked bytes against memoryReport.
+// Input: argc, argv
+// Output: 0 if every budget held and the byte count matched, 1 if not
+int benchEvict(int argc, char * argv[])
+{
+   int keys = intOption(argc, argv, "keys", 20000);
+   int cap = intOption(argc, argv, "cap", 2000);
+   int ops = intOption(argc, argv, "ops", 200000);
+   double skew = intOption(argc, argv, "skew", 100) / 100.0;
+   bool correlated = intOption(argc, argv, "correlated", 0) != 0;
+   mt19937 random(1);
+   vector<Website> websites;
+   vector<string> topics;
+   for (int i = 0; i < keys; i++)
+   {
+      int rating = correlated ? 5 - i * 5 / keys : (int)(random() % 5) + 1;
+      topics.push_back("topic-" + to_string(i));
+      websites.push_back(makeWebsite(topics[i], "https://site/" +
+                                     to_string(i), rating));
+   }
+   vector<double> cumulative(keys);
+   double total = 0;
+   for (int r = 0; r < keys; r++)
+   {
+      total += 1.0 / pow(r + 1, skew);
+      cumulative[r] = total;
+   }
+   uniform_real_distribution<double> uniform(0, total);
+   vector<int> picks(ops);
+   for (int i = 0; i < ops; i++)
+   {
+      int key = (int)(lower_bound(cumulative.begin(), cumulative.end(),
+                                  uniform(random)) - cumulative.begin());
+      picks[i] = key < keys ? key : keys - 1;
+   }
+   cout << keys << " keys, cap " << cap << ", " << ops << " lookups, skew "
+        << skew << (correlated ? ", ratings follow popularity" :
+                                 ", random ratings") << endl;
+   cout << "policy       hit %   ns/lookup   evictions   examined/evict"
+        << endl;
+
+   bool allHeld = true;
+   Website matches[1];
+   int found = 0;
+   for (int run = -1; run < EVICT_POLICIES; run++)
+   {
+      Table table(cap);
+      if (run >= 0)
+      {
+         EvictionBudget budget;
+         budget.maxEntries = cap;
+         budget.policy = (EvictionPolicy)run;
+         table.setBudget(budget);
+      }
+      long long hits = 0;
+      chrono::steady_clock::time_point start = chrono::steady_clock::now();
+      for (int i = 0; i < ops; i++)
+      {
+         if (table.retrieve(topics[picks[i]].c_str(), matches, found))
+         {
+            hits++;
+         }
+         else
+         {
+            table.insert(websites[picks[i]]);
+         }
+      }
+      double seconds = secondsSince(start);
+      EvictionStats stats = table.getEvictionStats();
+      bool held = run < 0 || table.getSize() <= cap;
+      allHeld = allHeld && held;
+      cout << left << setw(10) << (run < 0 ? "none" :
+                                   EVICTION_POLICY_NAMES[run])
+           << right << fixed << setprecision(1) << setw(8)
+           << 100.0 * hits / ops << setprecision(0) << setw(12)
+           << seconds * 1e9 / ops << setw(12) << stats.evictions
+           << setprecision(1) << setw(17)
+           << (stats.evictions ? (double)stats.examined / stats.evictions : 0)
+           << (held ? "" : "  OVER BUDGET") << endl;
+   }
+
+   Table table(cap);
+   EvictionBudget budget;
+   budget.maxBytes = table.memoryReport().totalRequested() +
+                     (size_t)cap * 100;
+   table.setBudget(budget);
+   for (int i = 0; i < ops; i++)
+   {
+      if (!table.retrieve(topics[picks[i]].c_str(), matches, found))
+      {
+         table.insert(websites[picks[i]]);
+      }
+   }
+   size_t tracked = table.getEvictionStats().bytes;
+   size_t counted = table.memoryReport().totalRequested();
+   bool held = tracked == counted && tracked <= budget.maxBytes;
+   cout << "byte budget " << budget.maxBytes << ": holding " << tracked
+        << " bytes in " << table.getSize() << " websites, memoryReport says "
+        << counted << (held ? "" : "  MISMATCH") << endl;
+   return allHeld && held ? 0 : 1;
+}
+
+// benchAdversarial function
+// Description: Inserts keys distinct anagrams of one topic (all the same
+//              TopicSumHash, so all one chain in a plain Table) into a
+//              plain Table, a Table with a keyed hash seed, a BasicTable
+//              with the unkeyed FNV hash and a CuckooTable, then times
+//              lookups lookups one by one, half of them anagrams that were
+//              never inserted. Prints the insert cost and lookup latency
+//              percentiles of each.
+// Input: argc, argv
+// Output: 0 if every structure found exactly the inserted keys, 1 if not
+int benchAdversarial(int argc, char * argv[])
+{
+   int keys = intOption(argc, argv, "keys", 20000);
+   int lookups = intOption(argc, argv, "lookups", 20000);
+   string topic = "abcdefghijklmn"; // 14! anagrams, sorted to start with
+   vector<string> topics;
+   vector<Website> websites;
+   for (int i = 0; i < 2 * keys && next_permutation(topic.begin(),
+                                                    topic.end()); i++)
+   {
+      topics.push_back(topic);
+   }
+   shuffle(topics.begin(), topics.end(), mt19937(7));
+   keys = (int)topics.size() / 2; // second half are never inserted
+   for (int i = 0; i < keys; i++)
+   {
+      websites.push_back(makeWebsite(topics[i], "https://site/" +
+                                     to_string(i), i % 5 + 1));
+   }
+   mt19937 random(3);
+   vector<string> probes;
+   for (int i = 0; i < lookups; i++)
+   {
+      probes.push_back(topics[random() % topics.size()]);
+   }
+   cout << keys << " anagram topics, " << lookups << " lookups (half misses)"
+        << endl;
+   cout << "structure      insert ns     p50 ns     p99 ns   p99.9 ns"
+        << "     max ns" << endl;
+
+   vector<string> inserted(topics.begin(), topics.begin() + keys);
+   sort(inserted.begin(), inserted.end());
+   long long expected = 0;
+   for (int i = 0; i < lookups; i++)
+   {
+      expected += binary_search(inserted.begin(), inserted.end(), probes[i]);
+   }
+   long long found[4] = { 0, 0, 0, 0 };
+   for (int run = 0; run < 2; run++)
+   {
+      Table table(keys, run == 0 ? 0 : randomSeed(), randomSeed());
+      chrono::steady_clock::time_point start = chrono::steady_clock::now();
+      for (int i = 0; i < keys; i++)
+      {
+         table.insert(websites[i]);
+      }
+      double buildSeconds = secondsSince(start);
+      long long & hits = found[run];
+      printLatencies(run == 0 ? "Table" : "Table keyed", buildSeconds, keys,
+         probes, [&table, &hits](const string & probe)
+         {
+            const Website * top[1];
+            int count = 0;
+            hits += table.topK(probe.c_str(), 1, top, count);
+         });
+   }
+   {
+      BasicTable<Website, TopicKey, CStringHash, CStringEqual,
+                 PowerOfTwoGrowth> table;
+      chrono::steady_clock::time_point start = chrono::steady_clock::now();
+      for (int i = 0; i < keys; i++)
+      {
+         table.insert(websites[i]);
+      }
+      double buildSeconds = secondsSince(start);
+      printLatencies("BasicTable FNV", buildSeconds, keys, probes,
+         [&table, &found](const string & probe)
+         {
+            found[2] += table.find(probe.c_str()) != nullptr;
+         });
+   }
+   CuckooTopicTable table;
+   chrono::steady_clock::time_point start = chrono::steady_clock::now();
+   for (int i = 0; i < keys; i++)
+   {
+      table.insert(websites[i]);
+   }
+   double buildSeconds = secondsSince(start);
+   printLatencies("CuckooTable", buildSeconds, keys, probes,
+      [&table, &found](const string & probe)
+      {
+         found[3] += table.find(probe.c_str()) != nullptr;
+      });
+   cout << "cuckoo: " << table.getCapacity() << " slots, "
+        << table.getStashSize() << " stashed, " << table.getRehashCount()
+        << " rehashes, at most " << CuckooTopicTable::MAX_PROBES
+        << " probes per lookup" << endl;
+
+   bool allFound = true;
+   for (int i = 0; i < 4; i++)
+   {
+      allFound = allFound && found[i] == expected;
+   }
+   cout << "expected " << expected << " hits: "
+        << (allFound ? "all agree" : "MISMATCH") << endl;
+   return allFound ? 0 : 1;
+}
+
+// benchResize function
+// Description: Grows each structure from empty to sites websites (one topic
+//              each), timing every insert and, after each insert, a lookup
+//              of a random topic inserted earlier. The Table starts at its
+//              smallest capacity and resizes incrementally; the BasicTable
+//              rehashes everything at once each time it grows; the presized
+//              Table never resizes and is the floor. Prints the latency
+//              percentiles of each.
+// Input: argc, argv
+// Output: 0 if every lookup found its website, 1 if not
+int benchResize(int argc, char * argv[])
+{
+   int sites = intOption(argc, argv, "sites", 500000);
+   vector<Website> websites;
+   for (int i = 0; i < sites; i++)
+   {
+      websites.push_back(makeWebsite("topic-" + to_string(i),
+                                     "https://site/" + to_string(i),
+                                     i % 5 + 1));
+   }
+   mt19937 random(5);
+   vector<int> probes(sites);
+   for (int i = 0; i < sites; i++)
+   {
+      probes[i] = random() % (i + 1);
+   }
+   cout << sites << " inserts, each followed by a lookup" << endl;
+   cout << "structure                    p50 ns     p99 ns   p99.9 ns"
+        << "     max ns" << endl;
+
+   long long misses = 0;
+   uint64_t seed = randomSeed();
+   for (int run = 0; run < 3; run++)
+   {
+      vector<double> inserts(sites);
+      vector<double> lookups(sites);
+      Table grown(1, seed);
+      Table presized(sites, seed);
+      BasicTable<Website, TopicKey, CStringHash, CStringEqual, PrimeGrowth>
+         rehashed;
+      int resizes = 0;
+      for (int i = 0; i < sites; i++)
+      {
+         const Website * top[1];
+         int count = 0;
+         const char * probe = websites[probes[i]].getTopic();
+         chrono::steady_clock::time_point start = chrono::steady_clock::now();
+         if (run == 0)
+         {
+            bool resizing = grown.isResizing();
+            grown.insert(websites[i]);
+            resizes += !resizing && grown.isResizing();
+         }
+         else if (run == 1)
+         {
+            rehashed.insert(websites[i]);
+         }
+         else
+         {
+            presized.insert(websites[i]);
+         }
+         inserts[i] = secondsSince(start) * 1e9;
+         start = chrono::steady_clock::now();
+         if (run == 0)
+         {
+            grown.topK(probe, 1, top, count);
+         }
+         else if (run == 1)
+         {
+            count = rehashed.find(probe) != nullptr;
+         }
+         else
+         {
+            presized.topK(probe, 1, top, count);
+         }
+         lookups[i] = secondsSince(start) * 1e9;
+         misses += count != 1;
+      }
+      const char * name = run == 0 ? "Table incremental" :
+                          run == 1 ? "BasicTable rehash" : "Table presized";
+      printPercentiles(string(name) + " insert", inserts);
+      printPercentiles(string(name) + " lookup", lookups);
+      if (run == 0)
+      {
+         cout << "  " << resizes << " resizes to " << grown.getCapacity()
+              << " buckets" << endl;
+      }
+   }
+   if (misses > 0)
+   {
+      cout << misses << " lookups missed" << endl;
+   }
+   return misses == 0 ? 0 : 1;
+}
+
+// benchPerf function
+// Description: Runs inserts of sites websites over topics topics, then ops
+//              retrieves, topKs and edits of random topics and websites, and
+//              one removeOneStar, under a PerfStats, first with the default
+//              TopicSumHash and then with a keyed hash. Prints the counters
+//              per operation of each run. Where the counters cannot be
+//              opened the runs still print calls and wall time.
+// Input: argc, argv
+// Output: 0
+int benchPerf(int argc, char * argv[])
+{
+   int sites = intOption(argc, argv, "sites", 100000);
+   int topics = intOption(argc, argv, "topics", 5000);
+   int ops = intOption(argc, argv, "ops", 100000);
+   vector<Website> websites;
+   for (int i = 0; i < sites; i++)
+   {
+      websites.push_back(makeWebsite("topic-" + to_string(i % topics),
+                                     "https://site/" + to_string(i),
+                                     i % 5 + 1));
+   }
+   vector<string> names;
+   for (int i = 0; i < topics; i++)
+   {
+      names.push_back("topic-" + to_string(i));
+   }
+   Website * matches = new Website[sites / topics + 1];
+   for (int run = 0; run < 2; run++)
+   {
+      Table table(0, run == 0 ? 0 : randomSeed(), randomSeed());
+      PerfStats stats;
+      ScopedPerfStats scoped(&stats);
+      for (int i = 0; i < sites; i++)
+      {
+         table.insert(websites[i]);
+      }
+      mt19937 random(9);
+      for (int i = 0; i < ops; i++)
+      {
+         const Website * top[10];
+         int found = 0;
+         table.retrieve(names[random() % topics].c_str(), matches, found);
+         table.topK(names[random() % topics].c_str(), 10, top, found);
+      }
+      char review[] = "edited review";
+      for (int i = 0; i < ops / 10; i++)
+      {
+         int site = random() % sites;
+         table.edit(const_cast<char *>(websites[site].getTopic()),
+                    const_cast<char *>(websites[site].getURL()), review,
+                    random() % 5 + 1);
+      }
+      table.removeOneStar();
+      cout << (run == 0 ? "TopicSumHash" : "keyed hash") << ": " << sites
+           << " websites, " << topics << " topics, " << table.getCapacity()
+           << " buckets" << endl << stats << endl;
+   }
+   delete [] matches;
+   matches = nullptr;
+   return 0;
+}
+
+// benchLockFree function
+// Description: Builds a table of sites websites over topics topics, then has
+//              readers threads retrieve random topics for millis
+//              milliseconds, three ways: alone; next to one writer thread
+//              that edits ratings (which moves websites) and inserts new
+//              websites (which grows the table) as fast as it can; and
+//              next to the same writer with every call behind a
+//              shared_mutex, readers shared and the writer exclusive.
+//              Prints reads and writes per second, and reads per second
+//              of reader CPU time, which stays put when the readers only
+//              lose time to the writer because cores are shared. Lock free
+//              reads should keep close to the rate they have alone.
+// Input: argc, argv
+// Output: 0 if every retired object was deleted at the end, 1 if not
+int benchLockFree(int argc, char * argv[])
+{
+   int cores = (int)thread::hardware_concurrency();
+   int sites = intOption(argc, argv, "sites", 100000);
+   int topics = intOption(argc, argv, "topics", 10000);
+   int readers = intOption(argc, argv, "readers", cores > 2 ? cores - 1 : 2);
+   int millis = intOption(argc, argv, "millis", 1000);
+   vector<Website> websites;
+   for (int i = 0; i < sites; i++)
+   {
+      websites.push_back(makeWebsite("topic-" + to_string(i % topics),
+                                     "https://site/" + to_string(i),
+                                     i % 5 + 1));
+   }
+   vector<string> names;
+   for (int i = 0; i < topics; i++)
+   {
+      names.push_back("topic-" + to_string(i));
+   }
+   const char * runs[] = { "readers alone", "writer, lock free reads",
+                           "writer, shared_mutex" };
+   cout << sites << " websites, " << topics << " topics, " << readers
+        << " readers" << endl;
+   cout << "run                         reads/s    writes/s reads/cpu-s"
+        << endl;
+   for (int run = 0; run < 3; run++)
+   {
+      Table table(sites, randomSeed(), randomSeed()); // no pile ups
+      for (int i = 0; i < sites; i++)
+      {
+         table.insert(websites[i]);
+      }
+      shared_mutex tableLock;
+      atomic<bool> stop(false);
+      vector<long long> reads(readers, 0);
+      vector<double> cpuSeconds(readers, 0);
+      long long writes = 0;
+      vector<thread> threads;
+      for (int t = 0; t < readers; t++)
+      {
+         threads.push_back(thread([&, t]
+         {
+            mt19937 random(t + 1);
+            vector<Website> matches(sites / topics + 1);
+            int found = 0;
+            long long count = 0;
+            while (!stop.load(memory_order_relaxed))
+            {
+               const char * topic = names[random() % topics].c_str();
+               if (run == 2)
+               {
+                  shared_lock<shared_mutex> guard(tableLock);
+                  table.retrieve(topic, matches.data(), found);
+               }
+               else
+               {
+                  table.retrieve(topic, matches.data(), found);
+               }
+               count++;
+            }
+            reads[t] = count;
+            timespec cpu;
+            clock_gettime(CLOCK_THREAD_CPUTIME_ID, &cpu);
+            cpuSeconds[t] = cpu.tv_sec + cpu.tv_nsec / 1e9;
+         }));
+      }
+      if (run > 0)
+      {
+         threads.push_back(thread([&]
+         {
+            mt19937 random(99);
+            char review[] = "edited review";
+            long long count = 0;
+            while (!stop.load(memory_order_relaxed))
+            {
+               const Website & website = websites[random() % sites];
+               Website added = makeWebsite("new-" + to_string(count),
+                                           "https://new/" + to_string(count),
+                                           random() % 5 + 1);
+               unique_lock<shared_mutex> guard(tableLock, defer_lock);
+               if (run == 2)
+               {
+                  guard.lock();
+               }
+               if (count % 2 == 0)
+               {
+                  table.edit(const_cast<char *>(website.getTopic()),
+                             const_cast<char *>(website.getURL()), review,
+                             random() % 5 + 1);
+               }
+               else
+               {
+                  table.insert(added);
+               }
+               count++;
+            }
+            writes = count;
+         }));
+      }
+      this_thread::sleep_for(chrono::milliseconds(millis));
+      stop = true;
+      for (size_t t = 0; t < threads.size(); t++)
+      {
+         threads[t].join();
+      }
+      long long total = 0;
+      double cpu = 0;
+      for (int t = 0; t < readers; t++)
+      {
+         total += reads[t];
+         cpu += cpuSeconds[t];
+      }
+      cout << left << setw(25) << runs[run] << right << fixed
+           << setprecision(0) << setw(12) << total * 1000.0 / millis
+           << setw(12) << writes * 1000.0 / millis << setw(12)
+           << (cpu > 0 ? total / cpu : 0) << endl;
+   }
+   epochSynchronize();
+   cout << "retired objects not deleted: " << epochPending() << endl;
+   return epochPending() == 0 ? 0 : 1;
+}
+
+// printPercentiles function
+// Description: Sorts the latencies and prints the 50th, 99th and 99.9th
+//              percentiles and the maximum on one line.
+// Input: name - the row label
+//        nanos - one latency per operation, in nanoseconds (sorted here)
+// Output: None
+void printPercentiles(const string & name, vector<double> & nanos)
+{
+   sort(nanos.begin(), nanos.end());
+   size_t last = nanos.size() - 1;
+   cout << left << setw(25) << name << right << fixed << setprecision(0)
+        << setw(10) << nanos[last / 2] << setw(11) << nanos[last * 99 / 100]
+        << setw(11) << nanos[last * 999 / 1000] << setw(11) << nanos[last]
+        << endl;
+}
+
+// printLatencies function
+// Description: Times each lookup on its own and prints one row: insert cost
+//              and lookup latency percentiles.
+// Input: name - the structure, buildSeconds - time to insert keys keys
+//        probes - the keys to look up, lookup - does one lookup
+// Output: None
+template <class Lookup>
+void printLatencies(const char * name, double buildSeconds, int keys,
+                    const vector<string> & probes, Lookup lookup)
+{
+   vector<double> latencies(probes.size());
+   for (size_t i = 0; i < probes.size(); i++)
+   {
+      chrono::steady_clock::time_point start = chrono::steady_clock::now();
+      lookup(probes[i]);
+      latencies[i] = secondsSince(start) * 1e9;
+   }
+   sort(latencies.begin(), latencies.end());
+   size_t last = latencies.size() - 1;
+   cout << left << setw(15) << name << right << fixed << setprecision(0)
+        << setw(10) << buildSeconds * 1e9 / keys << setw(11)
+        << latencies[last / 2] << setw(11) << latencies[last * 99 / 100]
+        << setw(11) << latencies[last * 999 / 1000] << setw(11)
+        << latencies[last] << endl;
+}
+
+// benchBulk function
+// Description: Loads sites websites over topics topics, in random order and
+//              with dupes percent of them repeating an earlier URL of the
+//              same topic, into an empty keyed table three ways: insert one
+//              at a time, one insertBulk of everything, and insertBulk in
+//              chunks pieces (so later batches merge into full chains).
+//              Prints the time and websites per second of each and checks
+//              that the bulk tables hold the same websites in the same
+//              order per topic as the one built by insert. Then does it
+//              again with cross percent more repeating an earlier URL under
+//              another topic, which insert only rejects if the two topics
+//              share a chain when it runs. A big table rarely puts two
+//              topics in one chain, so last it also compares small growing
+//              batches full of such URLs (see bulkTrials).
+// Input: argc, argv
+// Output: 0 if every table matched, 1 if not
+int benchBulk(int argc, char * argv[])
+{
+   int sites = intOption(argc, argv, "sites", 1000000);
+   int topics = intOption(argc, argv, "topics", 100000);
+   int dupes = intOption(argc, argv, "dupes", 5);
+   int cross = intOption(argc, argv, "cross", 1);
+   int chunks = max(intOption(argc, argv, "chunks", 10), 1);
+   vector<string> names;
+   for (int i = 0; i < topics; i++)
+   {
+      names.push_back("topic-" + to_string(i));
+   }
+   uint64_t seed = randomSeed(); // no TopicSumHash pile ups
+   int differ = 0;
+   for (int pass = 0; pass < (cross > 0 ? 2 : 1); pass++)
+   {
+      int crossPercent = pass == 0 ? 0 : cross;
+      mt19937 random(11);
+      vector<Website> websites;
+      vector<int> topicOf;
+      for (int i = 0; i < sites; i++)
+      {
+         int topic = random() % topics;
+         int url = i;
+         int roll = random() % 100;
+         if (i > 0 && roll < dupes + crossPercent) // repeat an earlier one
+         {
+            int earlier = random() % i;
+            topic = roll < dupes ? topicOf[earlier] : random() % topics;
+            url = atoi(websites[earlier].getURL() + strlen("https://site/"));
+         }
+         topicOf.push_back(topic);
+         websites.push_back(makeWebsite("topic-" + to_string(topic),
+                                        "https://site/" + to_string(url),
+                                        random() % 5 + 1));
+      }
+      cout << (pass > 0 ? "\n" : "") << sites << " websites, " << topics
+           << " topics, " << dupes << "% repeated URLs, " << crossPercent
+           << "% repeated under another topic" << endl;
+      cout << "load                     seconds   websites/s   inserted"
+           << endl;
+      Table sequential(0, seed);
+      for (int run = 0; run < 3; run++)
+      {
+         Table bulk(0, seed);
+         Table & table = run == 0 ? sequential : bulk;
+         int inserted = 0;
+         chrono::steady_clock::time_point start = chrono::steady_clock::now();
+         if (run == 0)
+         {
+            for (int i = 0; i < sites; i++)
+            {
+               inserted += table.insert(websites[i]);
+            }
+         }
+         else
+         {
+            int pieces = run == 1 ? 1 : chunks;
+            for (int piece = 0; piece < pieces; piece++)
+            {
+               int first = (int)((long long)sites * piece / pieces);
+               int last = (int)((long long)sites * (piece + 1) / pieces);
+               inserted += table.insertBulk(websites.data() + first,
+                                            last - first);
+            }
+         }
+         double seconds = secondsSince(start);
+         string name = run == 0 ? "insert" : run == 1 ? "insertBulk" :
+                       "insertBulk x " + to_string(chunks);
+         cout << left << setw(22) << name << right << fixed
+              << setprecision(3) << setw(10) << seconds << setprecision(0)
+              << setw(13) << sites / seconds << setw(11) << inserted << endl;
+         if (run > 0)
+         {
+            int mismatched = sameRuns(sequential, table, names);
+            if (mismatched > 0 || table.getSize() != sequential.getSize())
+            {
+               cout << "  " << mismatched << " topics differ from insert"
+                    << endl;
+               differ++;
+            }
+         }
+      }
+   }
+   int trials = 200;
+   int failed = bulkTrials(seed, trials);
+   cout << "\nsmall growing batches with URLs under several topics: "
+        << failed << " of " << trials << " differ from insert" << endl;
+   return differ == 0 && failed == 0 ? 0 : 1;
+}
+
+// bulkTrials function
+// Description: Fills two small keyed tables with the same random websites
+//              by insert, then adds one batch to each, by insert and by
+//              insertBulk, and compares them. The batches mostly grow the
+//              table, and URLs are drawn from a pool small enough that many
+//              repeat under the same topic and under other topics.
+// Input: seed - hash seed of the tables, trials - batches to compare
+// Output: the number of trials whose tables differ
+int bulkTrials(uint64_t seed, int trials)
+{
+   const int TOPICS = 30;
+   vector<string> names;
+   for (int i = 0; i < TOPICS; i++)
+   {
+      names.push_back("topic-" + to_string(i));
+   }
+   int failed = 0;
+   for (int trial = 0; trial < trials; trial++)
+   {
+      mt19937 random(trial);
+      int before = random() % 200;
+      int count = 1 + random() % 400;
+      int urls = (before + count) / 2 + 1;
+      vector<Website> websites;
+      for (int i = 0; i < before + count; i++)
+      {
+         websites.push_back(makeWebsite(names[random() % TOPICS],
+            "https://site/" + to_string(random() % urls),
+            random() % 5 + 1));
+      }
+      Table sequential(0, seed);
+      Table bulk(0, seed);
+      for (int i = 0; i < before; i++)
+      {
+         sequential.insert(websites[i]);
+         bulk.insert(websites[i]);
+      }
+      int inserted = 0;
+      for (int i = before; i < before + count; i++)
+      {
+         inserted += sequential.insert(websites[i]);
+      }
+      bool same = bulk.insertBulk(websites.data() + before, count) ==
+                  inserted && bulk.getSize() == sequential.getSize() &&
+                  sameRuns(sequential, bulk, names) == 0;
+      failed += !same;
+   }
+   return failed;
+}
+
+// sameRuns function
+// Description: Compares every topic's websites, in order and with their
+//              text, between two tables.
+// Input: a, b - the tables, names - the topics
+// Output: the number of topics that differ
+int sameRuns(const Table & a, const Table & b, const vector<string> & names)
+{
+   int differ = 0;
+   vector<const Website *> topA(max(a.getSize(), 1));
+   vector<const Website *> topB(max(b.getSize(), 1));
+   for (size_t i = 0; i < names.size(); i++)
+   {
+      int countA = 0;
+      int countB = 0;
+      a.topK(names[i].c_str(), (int)topA.size(), topA.data(), countA);
+      b.topK(names[i].c_str(), (int)topB.size(), topB.data(), countB);
+      bool same = countA == countB;
+      for (int j = 0; same && j < countA; j++)
+      {
+         same = strcmp(topA[j]->getURL(), topB[j]->getURL()) == 0 &&
+                strcmp(topA[j]->getSummary(), topB[j]->getSummary()) == 0 &&
+                strcmp(topA[j]->getReview(), topB[j]->getReview()) == 0 &&
+                topA[j]->getRating() == topB[j]->getRating();
+      }
+      differ += !same;
+   }
+   return differ;
+}
+
+// benchCompact function
+// Description: Loads sites websites over topics topics into a Table and a
+//              CompactTable (same keyed hash), and prints the bytes each
+//              holds by kind, per website, and for the index and nodes
+//              alone (the per website overhead on top of the strings),
+//              then the time of lookups topK(10) of random topics. Checks
+//              that both give every topic the same websites in the same
+//              order after the load and again after edits, a removeOneStar
+//              and a compact().
+// Input: argc, argv
+// Output: 0 if the tables always matched, 1 if not
+int benchCompact(int argc, char * argv[])
+{
+   int sites = intOption(argc, argv, "sites", 1000000);
+   int topics = intOption(argc, argv, "topics", 50000);
+   int lookups = intOption(argc, argv, "lookups", 1000000);
+   mt19937 random(13);
+   vector<Website> websites;
+   for (int i = 0; i < sites; i++)
+   {
+      websites.push_back(makeWebsite("topic-" + to_string(random() % topics),
+                                     "https://site/" + to_string(i),
+                                     random() % 5 + 1));
+   }
+   vector<string> names;
+   for (int i = 0; i < topics; i++)
+   {
+      names.push_back("topic-" + to_string(i));
+   }
+   uint64_t seed = randomSeed();
+   Table table(0, seed);
+   CompactTable compact(0, seed);
+   double loadSeconds[2];
+   for (int run = 0; run < 2; run++)
+   {
+      chrono::steady_clock::time_point start = chrono::steady_clock::now();
+      for (int i = 0; i < sites; i++)
+      {
+         if (run == 0)
+         {
+            table.insert(websites[i]);
+         }
+         else
+         {
+            compact.insert(websites[i]);
+         }
+      }
+      loadSeconds[run] = secondsSince(start);
+   }
+   MemoryReport reports[2] = { table.memoryReport(), compact.memoryReport() };
+   cout << sites << " websites, " << topics << " topics" << endl;
+   cout << "usable bytes          Table  CompactTable" << endl;
+   for (int i = 0; i < MEM_KINDS; i++)
+   {
+      cout << left << setw(14) << MEMORY_KIND_NAMES[i] << right << setw(12)
+           << reports[0].usable[i] << setw(14) << reports[1].usable[i]
+           << endl;
+   }
+   cout << left << setw(14) << "total" << right << setw(12)
+        << reports[0].totalUsable() << setw(14) << reports[1].totalUsable()
+        << endl;
+   cout << left << setw(14) << "heap blocks" << right << setw(12)
+        << reports[0].blocks << setw(14) << reports[1].blocks << endl;
+   cout << fixed << setprecision(1);
+   cout << left << setw(14) << "per website" << right << setw(12)
+        << reports[0].bytesPerEntry() << setw(14)
+        << reports[1].bytesPerEntry() << endl;
+   cout << left << setw(14) << "  index+nodes" << right;
+   for (int run = 0; run < 2; run++)
+   {
+      cout << setw(run == 0 ? 12 : 14)
+           << (double)(reports[run].usable[MEM_INDEX] +
+                       reports[run].usable[MEM_NODES]) / sites;
+   }
+   cout << endl;
+   cout << left << setw(14) << "load seconds" << right << setprecision(3)
+        << setw(12) << loadSeconds[0] << setw(14) << loadSeconds[1] << endl;
+
+   vector<int> probes(lookups);
+   for (int i = 0; i < lookups; i++)
+   {
+      probes[i] = random() % topics;
+   }
+   double lookupSeconds[2];
+   long long ratingTotal[2] = { 0, 0 };
+   for (int run = 0; run < 2; run++)
+   {
+      const Website * top[10];
+      CompactSite best[10];
+      int found = 0;
+      chrono::steady_clock::time_point start = chrono::steady_clock::now();
+      for (int i = 0; i < lookups; i++)
+      {
+         const char * topic = names[probes[i]].c_str();
+         if (run == 0)
+         {
+            table.topK(topic, 10, top, found);
+            for (int j = 0; j < found; j++)
+            {
+               ratingTotal[run] += top[j]->getRating();
+            }
+         }
+         else
+         {
+            compact.topK(topic, 10, best, found);
+            for (int j = 0; j < found; j++)
+            {
+               ratingTotal[run] += best[j].getRating();
+            }
+         }
+      }
+      lookupSeconds[run] = secondsSince(start);
+   }
+   cout << left << setw(14) << "topK(10) ns" << right << setprecision(0)
+        << setw(12) << lookupSeconds[0] * 1e9 / lookups << setw(14)
+        << lookupSeconds[1] * 1e9 / lookups << endl;
+   cout.unsetf(ios::fixed);
+
+   int differ = sameSites(table, compact, names);
+   char review[] = "edited review";
+   for (int i = 0; i < sites; i += 7)
+   {
+      char * topic = const_cast<char *>(websites[i].getTopic());
+      char * url = const_cast<char *>(websites[i].getURL());
+      table.edit(topic, url, review, i % 5 + 1);
+      compact.edit(topic, url, review, i % 5 + 1);
+   }
+   differ += sameSites(table, compact, names);
+   table.removeOneStar();
+   compact.removeOneStar();
+   differ += sameSites(table, compact, names);
+   compact.compact();
+   differ += sameSites(table, compact, names);
+   cout << "after edits, removeOneStar and compact(): "
+        << compact.memoryReport().totalUsable() << " bytes, "
+        << compact.getSize() << " websites" << endl;
+   if (differ > 0 || ratingTotal[0] != ratingTotal[1])
+   {
+      cout << differ << " topic comparisons differ" << endl;
+   }
+   return differ == 0 && ratingTotal[0] == ratingTotal[1] ? 0 : 1;
+}
+
+// sameSites function
+// Description: Compares every topic's websites, in order and with their
+//              reviews, between a Table and a CompactTable.
+// Input: table, compact - the tables, names - the topics
+// Output: the number of topics that differ
+int sameSites(const Table & table, const CompactTable & compact,
+              const vector<string> & names)
+{
+   int differ = 0;
+   vector<const Website *> top(max(table.getSize(), 1));
+   vector<CompactSite> sites(top.size());
+   for (size_t i = 0; i < names.size(); i++)
+   {
+      int countTable = 0;
+      int countCompact = 0;
+      table.topK(names[i].c_str(), (int)top.size(), top.data(), countTable);
+      compact.topK(names[i].c_str(), (int)sites.size(), sites.data(),
+                   countCompact);
+      bool same = countTable == countCompact;
+      for (int j = 0; same && j < countTable; j++)
+      {
+         same = strcmp(top[j]->getURL(), sites[j].getURL()) == 0 &&
+                strcmp(top[j]->getReview(), sites[j].getReview()) == 0 &&
+                top[j]->getRating() == sites[j].getRating();
+      }
+      differ += !same;
+   }
+   return differ;
+}
+
+// benchMapped function
+// Description: Loads sites websites over topics topics into a MappedTable
+//              in a temporary file and into a CompactTable, and times the
+//              load, the checkpoint and opening the file again. Checks that
+//              the reopened table gives every topic the same websites as
+//              the CompactTable, again after edits, a removeOneStar and a
+//              compact() and another reopen. Last, a child process writes
+//              to the file and exits without a checkpoint, and the file
+//              must then be refused.
+// Input: argc, argv
+// Output: 0 if every check passed, 1 if not
+int benchMapped(int argc, char * argv[])
+{
+   int sites = intOption(argc, argv, "sites", 200000);
+   int topics = intOption(argc, argv, "topics", 20000);
+   string path = "/tmp/bench_mapped_" + to_string(getpid()) + ".tbl";
+   unlink(path.c_str());
+   mt19937 random(17);
+   vector<Website> websites;
+   for (int i = 0; i < sites; i++)
+   {
+      websites.push_back(makeWebsite("topic-" + to_string(random() % topics),
+                                     "https://site/" + to_string(i),
+                                     random() % 5 + 1));
+   }
+   vector<string> names;
+   for (int i = 0; i < topics; i++)
+   {
+      names.push_back("topic-" + to_string(i));
+   }
+   uint64_t seed = randomSeed();
+   CompactTable compact(0, seed);
+   for (int i = 0; i < sites; i++)
+   {
+      compact.insert(websites[i]);
+   }
+   int failed = 0;
+   MappedTable mapped;
+   if (!mapped.open(path.c_str(), seed))
+   {
+      cout << "cannot open " << path << ": " << mapped.getError() << endl;
+      return 1;
+   }
+   chrono::steady_clock::time_point start = chrono::steady_clock::now();
+   for (int i = 0; i < sites; i++)
+   {
+      mapped.insert(websites[i]);
+   }
+   double loadSeconds = secondsSince(start);
+   start = chrono::steady_clock::now();
+   failed += !mapped.checkpoint();
+   double checkpointSeconds = secondsSince(start);
+   mapped.close();
+   start = chrono::steady_clock::now();
+   failed += !mapped.open(path.c_str());
+   double openSeconds = secondsSince(start);
+   cout << sites << " websites, " << topics << " topics, "
+        << mapped.getFileBytes() << " byte file" << endl;
+   cout << "load " << loadSeconds << " s, checkpoint " << checkpointSeconds
+        << " s, reopen " << openSeconds * 1e6 << " us" << endl;
+   int differ = sameMapped(compact, mapped, names);
+
+   char review[] = "edited review";
+   for (int i = 0; i < sites; i += 7)
+   {
+      compact.edit(websites[i].getTopic(), websites[i].getURL(), review,
+                   i % 5 + 1);
+      mapped.edit(websites[i].getTopic(), websites[i].getURL(), review,
+                  i % 5 + 1);
+   }
+   differ += sameMapped(compact, mapped, names);
+   compact.removeOneStar();
+   mapped.removeOneStar();
+   compact.compact();
+   failed += !mapped.compact();
+   mapped.close();
+   failed += !mapped.open(path.c_str());
+   differ += sameMapped(compact, mapped, names);
+   cout << "after edits, removeOneStar, compact() and a reopen: "
+        << mapped.getFileBytes() << " byte file, " << mapped.getSize()
+        << " websites" << endl;
+   mapped.close();
+
+   pid_t child = fork();
+   if (child == 0) // write, then die without a checkpoint
+   {
+      MappedTable crashed;
+      crashed.open(path.c_str());
+      crashed.insert(makeWebsite("topic-0", "https://site/crash", 5));
+      _exit(0);
+   }
+   waitpid(child, nullptr, 0);
+   bool refused = !mapped.open(path.c_str());
+   cout << "after a crash before a checkpoint: "
+        << (refused ? string("refused, ") + mapped.getError() :
+                      string("opened")) << endl;
+   failed += !refused;
+   mapped.close();
+   unlink(path.c_str());
+   if (differ > 0 || failed > 0)
+   {
+      cout << differ << " topic comparisons differ, " << failed
+           << " operations failed" << endl;
+   }
+   return differ == 0 && failed == 0 ? 0 : 1;
+}
+
+// sameMapped function
+// Description: Compares every topic's websites, in order and with their
+//              reviews, between a CompactTable and a MappedTable.
+// Input: compact, mapped - the tables, names - the topics
+// Output: the number of topics that differ
+int sameMapped(const CompactTable & compact, const MappedTable & mapped,
+               const vector<string> & names)
+{
+   int differ = 0;
+   vector<CompactSite> expected(max(compact.getSize(), 1));
+   vector<CompactSite> found(expected.size());
+   for (size_t i = 0; i < names.size(); i++)
+   {
+      int countCompact = 0;
+      int countMapped = 0;
+      compact.topK(names[i].c_str(), (int)expected.size(), expected.data(),
+                   countCompact);
+      mapped.topK(names[i].c_str(), (int)found.size(), found.data(),
+                  countMapped);
+      bool same = countCompact == countMapped;
+      for (int j = 0; same && j < countCompact; j++)
+      {
+         same = strcmp(expected[j].getURL(), found[j].getURL()) == 0 &&
+                strcmp(expected[j].getReview(), found[j].getReview()) == 0 &&
+                expected[j].getRating() == found[j].getRating();
+      }
+      differ += !same;
+   }
+   return differ;
+}
+
+// benchAsync function
+// Description: Writes a table of sites websites over topics topics to a
+//              file with exportAsync, then loads the file back with
+//              loadAsync, running the executor's loop by hand and looking a
+//              topic up on every turn, as an event loop serving requests
+//              would. Checks that the loaded table matches both the
+//              original and one loadFromFile built from the same file, and
+//              that loadAsync fails on a read error (a directory opens but
+//              cannot be read) and on a missing file.
+// Input: argc, argv
+// Output: 0 if the tables matched and both failures were reported, 1 if not
+int benchAsync(int argc, char * argv[])
+{
+   int sites = intOption(argc, argv, "sites", 200000);
+   int topics = intOption(argc, argv, "topics", 20000);
+   uint64_t seed = randomSeed();
+   mt19937 random(13);
+   vector<string> names;
+   for (int i = 0; i < topics; i++)
+   {
+      names.push_back("topic-" + to_string(i));
+   }
+   Table source(0, seed);
+   for (int i = 0; i < sites; i++)
+   {
+      source.insert(makeWebsite(names[random() % topics],
+                                "https://site/" + to_string(i),
+                                random() % 5 + 1));
+   }
+   string path = "/tmp/bench_async_" + to_string(getpid()) + ".txt";
+   IoExecutor executor;
+   int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+   if (fd < 0)
+   {
+      cout << "cannot create " << path << endl;
+      return 1;
+   }
+   chrono::steady_clock::time_point start = chrono::steady_clock::now();
+   Task<int> exported = exportAsync(source, executor, fd);
+   int written = executor.run(exported);
+   double exportSeconds = secondsSince(start);
+   close(fd);
+
+   Table loaded(0, seed);
+   start = chrono::steady_clock::now();
+   Task<int> loading = loadAsync(loaded, executor, path.c_str());
+   long long turns = 0;
+   long long hits = 0;
+   loading.start();
+   while (!loading.done())
+   {
+      executor.waitReady();
+      executor.runReady();
+      const Website * top[10];
+      int found = 0;
+      hits += loaded.topK(names[random() % topics].c_str(), 10, top, found);
+      turns++;
+   }
+   int inserted = loading.result();
+   double loadSeconds = secondsSince(start);
+
+   Table fromFile(0, seed);
+   start = chrono::steady_clock::now();
+   fromFile.loadFromFile(path.c_str());
+   double fileSeconds = secondsSince(start);
+   remove(path.c_str());
+
+   cout << sites << " websites, " << topics << " topics" << endl;
+   cout << "step                     seconds   websites" << endl;
+   cout << fixed << setprecision(3) << left << setw(22) << "exportAsync"
+        << right << setw(10) << exportSeconds << setw(11) << written << endl;
+   cout << left << setw(22) << "loadAsync" << right << setw(10)
+        << loadSeconds << setw(11) << inserted << endl;
+   cout << left << setw(22) << "loadFromFile" << right << setw(10)
+        << fileSeconds << setw(11) << fromFile.getSize() << endl;
+   cout << "loop turns while loading: " << turns << ", lookups that found "
+        << "their topic: " << hits << endl;
+   int differ = sameRuns(source, loaded, names) +
+                sameRuns(fromFile, loaded, names);
+   bool sizes = written == source.getSize() &&
+                inserted == source.getSize() &&
+                loaded.getSize() == source.getSize() &&
+                fromFile.getSize() == source.getSize();
+
+   Table unused;
+   Task<int> unreadable = loadAsync(unused, executor, "/");
+   bool readFailed = executor.run(unreadable) == -1;
+   Task<int> missing = loadAsync(unused, executor, path.c_str());
+   bool openFailed = executor.run(missing) == -1;
+   cout << "read error reported: " << (readFailed ? "yes" : "no")
+        << ", missing file reported: " << (openFailed ? "yes" : "no")
+        << endl;
+   if (differ > 0 || !sizes)
+   {
+      cout << differ << " topic comparisons differ"
+           << (sizes ? "" : ", sizes differ") << endl;
+   }
+   return differ == 0 && sizes && readFailed && openFailed ? 0 : 1;
+}
@@ -0,0 +1,456 @@
+/******************************************************************************
+# Program Desc.:      This program is a website bookmarking program. The program
+#                     implements a hash table using chaining (pointer array of
+#                     linked lists) to store website information.
+# File:               columnar.cpp
+# File Description:   Implementation of exportColumnar and the ColumnarFile
+#                     reader.
+# Input:              Columnar file (ColumnarFile)
+# Output:             Columnar file (exportColumnar)
+#******************************************************************************/
+#include "columnar.h"
+
+#include <string>
+#include <unordered_map>
+#include <fstream>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+const uint64_t COLUMNAR_ALIGN = 64; // section alignment
+
+// alignUp
+// Description: Rounds a file offset up to the next section boundary.
+static uint64_t alignUp(uint64_t offset)
+{
+   return (offset + COLUMNAR_ALIGN - 1) / COLUMNAR_ALIGN * COLUMNAR_ALIGN;
+}
+
+// appendString
+// Description: Adds a '\0' terminated string to the heap and its start to
+//              an offsets column.
+// Input: heap, offsets - the column, text - the string
+// Output: None
+static void appendString(string & heap, vector<uint64_t> & offsets,
+                         const char * text)
+{
+   offsets.push_back(heap.size());
+   heap.append(text, strlen(text) + 1);
+}
+
+// writeSection
+// Description: Pads the file to the section's offset, then writes it.
+// Input: out - the file, offset - where the section starts, data, bytes
+// Output: None
+static void writeSection(ofstream & out, uint64_t offset, const void * data,
+                         uint64_t bytes)
+{
+   static const char zeros[COLUMNAR_ALIGN] = {};
+   uint64_t at = (uint64_t)out.tellp();
+   out.write(zeros, offset - at);
+   out.write((const char *)data, bytes);
+}
+
+// exportColumnar
+// Description: Walks the snapshot once, building each column in memory
+//              (topics dictionary encoded in first seen order), then writes
+//              the header and the columns in the layout documented in
+//              columnar.h.
+// Input: snapshot - the websites to export, filename - the file to write
+// Output: true if the file was written, false if it could not be
+bool exportColumnar(const Table::Snapshot & snapshot, const char * filename)
+{
+   unordered_map<string, uint32_t> topicIndex;
+   vector<uint64_t> topicOffsets;
+   vector<uint32_t> topicIds;
+   vector<int32_t> ratings;
+   vector<uint64_t> urlOffsets;
+   vector<uint64_t> summaryOffsets;
+   vector<uint64_t> reviewOffsets;
+   string heap;
+   for (Table::const_iterator it = snapshot.begin(); it != snapshot.end();
+        ++it)
+   {
+      pair<unordered_map<string, uint32_t>::iterator, bool> topic =
+         topicIndex.insert(make_pair(string(it->getTopic()),
+                                     (uint32_t)topicIndex.size()));
+      if (topic.second) // first website of this topic
+      {
+         appendString(heap, topicOffsets, it->getTopic());
+      }
+      topicIds.push_back(topic.first->second);
+      ratings.push_back(it->getRating());
+      appendString(heap, urlOffsets, it->getURL());
+      appendString(heap, summaryOffsets, it->getSummary());
+      appendString(heap, reviewOffsets, it->getReview());
+   }
+   topicOffsets.push_back(heap.size()); // end of the last string
+   urlOffsets.push_back(heap.size());
+   summaryOffsets.push_back(heap.size());
+   reviewOffsets.push_back(heap.size());
+
+   ColumnarHeader header;
+   memset(&header, 0, sizeof(header));
+   memcpy(header.magic, COLUMNAR_MAGIC, sizeof(header.magic));
+   header.byteOrder = COLUMNAR_BYTE_ORDER;
+   header.version = COLUMNAR_VERSION;
+   header.rowCount = ratings.size();
+   header.topicCount = topicOffsets.size() - 1;
+   header.heapBytes = heap.size();
+   header.topicOffsets = alignUp(sizeof(header));
+   header.topicIds = alignUp(header.topicOffsets +
+                             topicOffsets.size() * sizeof(uint64_t));
+   header.ratings = alignUp(header.topicIds +
+                            topicIds.size() * sizeof(uint32_t));
+   header.urlOffsets = alignUp(header.ratings +
+                               ratings.size() * sizeof(int32_t));
+   header.summaryOffsets = alignUp(header.urlOffsets +
+                                   urlOffsets.size() * sizeof(uint64_t));
+   header.reviewOffsets = alignUp(header.summaryOffsets +
+                                  summaryOffsets.size() * sizeof(uint64_t));
+   header.heap = alignUp(header.reviewOffsets +
+                         reviewOffsets.size() * sizeof(uint64_t));
+   header.fileBytes = header.heap + heap.size();
+
+   ofstream out(filename, ios::binary | ios::trunc);
+   if (!out)
+   {
+      return false;
+   }
+   out.write((const char *)&header, sizeof(header));
+   writeSection(out, header.topicOffsets, topicOffsets.data(),
+                topicOffsets.size() * sizeof(uint64_t));
+   writeSection(out, header.topicIds, topicIds.data(),
+                topicIds.size() * sizeof(uint32_t));
+   writeSection(out, header.ratings, ratings.data(),
+                ratings.size() * sizeof(int32_t));
+   writeSection(out, header.urlOffsets, urlOffsets.data(),
+                urlOffsets.size() * sizeof(uint64_t));
+   writeSection(out, header.summaryOffsets, summaryOffsets.data(),
+                summaryOffsets.size() * sizeof(uint64_t));
+   writeSection(out, header.reviewOffsets, reviewOffsets.data(),
+                reviewOffsets.size() * sizeof(uint64_t));
+   writeSection(out, header.heap, heap.data(), heap.size());
+   return bool(out);
+}
+
+// exportColumnar (table)
+// Description: Exports an O(1) snapshot of the table, so the file is a
+//              consistent point in time copy.
+bool exportColumnar(const Table & table, const char * filename)
+{
+   return exportColumnar(table.snapshot(), filename);
+}
+
+// COLUMNAR FILE
+
+// Constructor
+ColumnarFile::ColumnarFile()
+{
+   base = nullptr;
+   length = 0;
+   header = nullptr;
+}
+
+// Destructor
+ColumnarFile::~ColumnarFile()
+{
+   close();
+}
+
+// open
+// Description: Maps a columnar file read only and checks it (see
+//              validate). The columns are then read in place; pages are
+//              loaded by the OS as scans touch them.
+// Input: filename - the file
+// Output: true if the file is open, false if it could not be opened or is
+//         not a valid columnar file
+bool ColumnarFile::open(const char * filename)
+{
+   close();
+   int fd = ::open(filename, O_RDONLY);
+   if (fd < 0)
+   {
+      return false;
+   }
+   struct stat info;
+   if (fstat(fd, &info) != 0 || info.st_size < (off_t)sizeof(ColumnarHeader))
+   {
+      ::close(fd);
+      return false;
+   }
+   void * mapping = mmap(nullptr, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+   ::close(fd); // the mapping keeps the file
+   if (mapping == MAP_FAILED)
+   {
+      return false;
+   }
+   base = (const char *)mapping;
+   length = info.st_size;
+   if (!validate())
+   {
+      close();
+      return false;
+   }
+   return true;
+}
+
+// close
+// Description: Unmaps the file, if one is open.
+void ColumnarFile::close()
+{
+   if (base)
+   {
+      munmap((void *)base, length);
+   }
+   base = nullptr;
+   length = 0;
+   header = nullptr;
+}
+
+// sectionFits
+// Description: True if a section of count items of size bytes starting at
+//              offset is aligned and inside a file of length bytes.
+static bool sectionFits(uint64_t offset, uint64_t count, uint64_t size,
+                        uint64_t length)
+{
+   return offset % COLUMNAR_ALIGN == 0 && offset <= length &&
+          count <= (length - offset) / size;
+}
+
+// offsetsFit
+// Description: True if a string offsets column only points into the heap,
+//              never goes backwards, and every string ends in '\0'.
+static bool offsetsFit(const uint64_t * offsets, uint64_t count,
+                       const char * heap, uint64_t heapBytes)
+{
+   if (offsets[count] > heapBytes)
+   {
+      return false;
+   }
+   for (uint64_t i = 0; i < count; i++)
+   {
+      if (offsets[i] >= offsets[i + 1] || offsets[i + 1] > heapBytes ||
+          heap[offsets[i + 1] - 1] != '\0')
+      {
+         return false;
+      }
+   }
+   return true;
+}
+
+// validate
+// Description: Checks the header, that every section lies inside the file,
+//              that every string offset stays in the heap and every topic id
+//              names a topic. Done once here so the accessors and scans need
+//              no checks of their own. Sets the column pointers.
+// Input: None
+// Output: true if the file is a valid columnar file
+bool ColumnarFile::validate()
+{
+   header = (const ColumnarHeader *)base;
+   if (memcmp(header->magic, COLUMNAR_MAGIC, sizeof(header->magic)) != 0 ||
+       header->byteOrder != COLUMNAR_BYTE_ORDER ||
+       header->version != COLUMNAR_VERSION || header->fileBytes != length ||
+       header->rowCount > INT32_MAX || header->topicCount > INT32_MAX)
+   {
+      return false;
+   }
+   uint64_t rows = header->rowCount;
+   if (!sectionFits(header->topicOffsets, header->topicCount + 1,
+                    sizeof(uint64_t), length) ||
+       !sectionFits(header->topicIds, rows, sizeof(uint32_t), length) ||
+       !sectionFits(header->ratings, rows, sizeof(int32_t), length) ||
+       !sectionFits(header->urlOffsets, rows + 1, sizeof(uint64_t), length) ||
+       !sectionFits(header->summaryOffsets, rows + 1, sizeof(uint64_t),
+                    length) ||
+       !sectionFits(header->reviewOffsets, rows + 1, sizeof(uint64_t),
+                    length) ||
+       !sectionFits(header->heap, header->heapBytes, 1, length))
+   {
+      return false;
+   }
+   topicOffsets = (const uint64_t *)(base + header->topicOffsets);
+   topicIds = (const uint32_t *)(base + header->topicIds);
+   ratings = (const int32_t *)(base + header->ratings);
+   urlOffsets = (const uint64_t *)(base + header->urlOffsets);
+   summaryOffsets = (const uint64_t *)(base + header->summaryOffsets);
+   reviewOffsets = (const uint64_t *)(base + header->reviewOffsets);
+   heap = base + header->heap;
+   if (!offsetsFit(topicOffsets, header->topicCount, heap, header->heapBytes) ||
+       !offsetsFit(urlOffsets, rows, heap, header->heapBytes) ||
+       !offsetsFit(summaryOffsets, rows, heap, header->heapBytes) ||
+       !offsetsFit(reviewOffsets, rows, heap, header->heapBytes))
+   {
+      return false;
+   }
+   for (uint64_t i = 0; i < rows; i++)
+   {
+      if (topicIds[i] >= header->topicCount)
+      {
+         return false;
+      }
+   }
+   return true;
+}
+
+// getRowCount
+// Description: Returns the number of websites, 0 if nothing is open.
+int ColumnarFile::getRowCount() const
+{
+   return header ? (int)header->rowCount : 0;
+}
+
+// getTopicCount
+// Description: Returns the number of distinct topics, 0 if nothing is open.
+int ColumnarFile::getTopicCount() const
+{
+   return header ? (int)header->topicCount : 0;
+}
+
+// topic
+// Description: Returns the topic with a topic id (0 .. getTopicCount() - 1).
+const char * ColumnarFile::topic(int topicId) const
+{
+   return heap + topicOffsets[topicId];
+}
+
+// topicId
+// Description: Returns the topic id of a row (0 .. getRowCount() - 1).
+int ColumnarFile::topicId(int row) const
+{
+   return (int)topicIds[row];
+}
+
+// rating
+// Description: Returns the rating of a row.
+int ColumnarFile::rating(int row) const
+{
+   return ratings[row];
+}
+
+// url
+// Description: Returns the URL of a row.
+const char * ColumnarFile::url(int row) const
+{
+   return heap + urlOffsets[row];
+}
+
+// summary
+// Description: Returns the summary of a row.
+const char * ColumnarFile::summary(int row) const
+{
+   return heap + summaryOffsets[row];
+}
+
+// review
+// Description: Returns the review of a row.
+const char * ColumnarFile::review(int row) const
+{
+   return heap + reviewOffsets[row];
+}
+
+// topicIdColumn
+// Description: Returns the whole topic id column, for custom scans.
+const uint32_t * ColumnarFile::topicIdColumn() const
+{
+   return topicIds;
+}
+
+// ratingColumn
+// Description: Returns the whole rating column, for custom scans.
+const int32_t * ColumnarFile::ratingColumn() const
+{
+   return ratings;
+}
+
+// ratingHistogram
+// Description: Counts the websites with each rating from 0 to maxRating;
+//              ratings outside that range are not counted. Reads only the
+//              rating column. Four sub-histograms are filled in turn so
+//              neighbouring rows with the same rating do not wait on each
+//              other's increment, then added together.
+// Input: maxRating - the highest rating to count
+// Output: counts[rating] for rating 0 .. maxRating
+vector<long long> ColumnarFile::ratingHistogram(int maxRating) const
+{
+   int buckets = maxRating + 1 > 0 ? maxRating + 1 : 0;
+   vector<long long> partial(4 * (buckets + 1), 0); // + 1: out of range
+   int rows = getRowCount();
+   int row = 0;
+   for (; row + 4 <= rows; row += 4)
+   {
+      for (int lane = 0; lane < 4; lane++)
+      {
+         uint32_t value = (uint32_t)ratings[row + lane]; // negative is huge
+         partial[lane * (buckets + 1) +
+                 (value < (uint32_t)buckets ? value : buckets)]++;
+      }
+   }
+   for (; row < rows; row++)
+   {
+      uint32_t value = (uint32_t)ratings[row];
+      partial[value < (uint32_t)buckets ? value : buckets]++;
+   }
+   vector<long long> counts(buckets, 0);
+   for (int lane = 0; lane < 4; lane++)
+   {
+      for (int i = 0; i < buckets; i++)
+      {
+         counts[i] += partial[lane * (buckets + 1) + i];
+      }
+   }
+   return counts;
+}
+
+// topicCounts
+// Description: Counts the websites of each topic. Reads only the topic id
+//              column.
+// Input: None
+// Output: counts[topicId]
+vector<long long> ColumnarFile::topicCounts() const
+{
+   vector<long long> counts(getTopicCount(), 0);
+   int rows = getRowCount();
+   for (int row = 0; row < rows; row++)
+   {
+      counts[topicIds[row]]++;
+   }
+   return counts;
+}
+
+// topicRatingTotals
+// Description: Adds up the ratings of each topic's websites; divided by
+//              topicCounts that gives the average rating per topic. Reads
+//              the topic id and rating columns.
+// Input: None
+// Output: totals[topicId]
+vector<long long> ColumnarFile::topicRatingTotals() const
+{
+   vector<long long> totals(getTopicCount(), 0);
+   int rows = getRowCount();
+   for (int row = 0; row < rows; row++)
+   {
+      totals[topicIds[row]] += ratings[row];
+   }
+   return totals;
+}
+
+// countRatingAtLeast
+// Description: Counts the websites rated minRating or better. A branch free
+//              reduction over the rating column, which the compiler turns
+//              into SIMD compares when optimizing.
+// Input: minRating
+// Output: the count
+long long ColumnarFile::countRatingAtLeast(int minRating) const
+{
+   long long count = 0;
+   int rows = getRowCount();
+   for (int row = 0; row < rows; row++)
+   {
+      count += ratings[row] >= minRating;
+   }
+   return count;
+}
@@ -0,0 +1,113 @@
+/******************************************************************************
+# Program Desc.:      This program is a website bookmarking program. The program
+#                     implements a hash table using chaining (pointer array of
+#                     linked lists) to store website information.
+# File:               columnar.h
+# File Description:   Columnar export of a Table and a memory mapped reader
+#                     for it. Each field of the websites is stored as its own
+#                     contiguous array, so analytics scans (rating histograms,
+#                     per topic counts) read only the columns they need, and
+#                     straight out of the page cache with no parsing.
+#
+#                     File layout (host byte order, which the byte order
+#                     mark records; every section starts on a 64 byte
+#                     boundary, offsets are from the start of the file):
+#                        ColumnarHeader
+#                        topic offsets   uint64[topicCount + 1] into heap
+#                        topic ids       uint32[rowCount], index of topic
+#                        ratings         int32[rowCount]
+#                        URL offsets     uint64[rowCount + 1] into heap
+#                        summary offsets uint64[rowCount + 1] into heap
+#                        review offsets  uint64[rowCount + 1] into heap
+#                        heap            char[heapBytes], '\0' terminated
+#                                        strings
+#                     String i of a column runs from offsets[i] to
+#                     offsets[i + 1] - 1 (the '\0'). Topics are numbered in
+#                     the order they are first seen; rows are in table
+#                     (bucket, chain) order.
+# Input:              None
+# Output:             None
+#******************************************************************************/
+#ifndef COLUMNAR_H
+#define COLUMNAR_H
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+#include "table.h"
+
+using namespace std;
+
+const char COLUMNAR_MAGIC[8] = { 'B', 'M', 'K', 'C', 'O', 'L', 'S', '\0' };
+const uint32_t COLUMNAR_BYTE_ORDER = 0x01020304; // reads back swapped if not
+const uint32_t COLUMNAR_VERSION = 1;
+
+// ColumnarHeader
+// First 128 bytes of a columnar file.
+struct ColumnarHeader
+{
+   char magic[8]; // COLUMNAR_MAGIC
+   uint32_t byteOrder; // COLUMNAR_BYTE_ORDER as written
+   uint32_t version; // COLUMNAR_VERSION
+   uint64_t rowCount; // websites
+   uint64_t topicCount; // distinct topics
+   uint64_t fileBytes; // size of the whole file
+   uint64_t topicOffsets; // section offsets
+   uint64_t topicIds;
+   uint64_t ratings;
+   uint64_t urlOffsets;
+   uint64_t summaryOffsets;
+   uint64_t reviewOffsets;
+   uint64_t heap;
+   uint64_t heapBytes; // bytes of strings in the heap
+   uint64_t reserved[3]; // 0
+};
+static_assert(sizeof(ColumnarHeader) == 128, "columnar header layout");
+
+// write a snapshot (or the table right now) as a columnar file
+bool exportColumnar(const Table::Snapshot & snapshot, const char * filename);
+bool exportColumnar(const Table & table, const char * filename);
+
+class ColumnarFile
+{
+public:
+   ColumnarFile(); // nothing open
+   ~ColumnarFile(); // unmaps the file
+   ColumnarFile(const ColumnarFile &) = delete;
+
+   bool open(const char * filename); // map and check a columnar file
+   void close(); // unmap it
+
+   int getRowCount() const;
+   int getTopicCount() const;
+   const char * topic(int topicId) const; // topic string of a topic id
+   int topicId(int row) const;
+   int rating(int row) const;
+   const char * url(int row) const;
+   const char * summary(int row) const;
+   const char * review(int row) const;
+   const uint32_t * topicIdColumn() const; // rowCount topic ids
+   const int32_t * ratingColumn() const; // rowCount ratings
+
+   // column scans
+   vector<long long> ratingHistogram(int maxRating) const; // [0..maxRating]
+   vector<long long> topicCounts() const; // websites per topic id
+   vector<long long> topicRatingTotals() const; // rating sum per topic id
+   long long countRatingAtLeast(int minRating) const;
+
+private:
+   const char * base; // the mapping, nullptr if nothing is open
+   size_t length;
+   const ColumnarHeader * header;
+   const uint64_t * topicOffsets;
+   const uint32_t * topicIds;
+   const int32_t * ratings;
+   const uint64_t * urlOffsets;
+   const uint64_t * summaryOffsets;
+   const uint64_t * reviewOffsets;
+   const char * heap;
+
+   bool validate(); // check every section and offset against the file
+};
+
+#endif
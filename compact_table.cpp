@@ -0,0 +1,613 @@
+/******************************************************************************
+# Program Desc.:      This program is a website bookmarking program. The program
+#                     implements a hash table using chaining (pointer array of
+#                     linked lists) to store website information.
+# File:               compact_table.cpp
+# File Description:   Implementation of CompactTable: topics chained by 32 bit
+#                     index from the buckets, each topic's websites chained
+#                     by 32 bit index in rating order, and every string in a
+#                     pool (see compact_table.h).
+# Input:              None
+# Output:             None
+#******************************************************************************/
+#include "compact_table.h"
+#include "record_parser.h"
+
+// COMPACT SITE
+
+// Constructor
+// Description: An empty view, for arrays passed to topK.
+CompactSite::CompactSite() : topic(""), url(""), summary(""), rating(0)
+{
+}
+
+// getters
+const char * CompactSite::getTopic() const
+{
+   return topic;
+}
+
+const char * CompactSite::getURL() const
+{
+   return url;
+}
+
+const char * CompactSite::getSummary() const
+{
+   return summary;
+}
+
+const char * CompactSite::getReview() const
+{
+   return summary + strlen(summary) + 1; // stored right after the summary
+}
+
+int CompactSite::getRating() const
+{
+   return rating;
+}
+
+// toWebsite
+// Description: Copies the website out of the table's pools.
+// Input: None
+// Output: the website
+Website CompactSite::toWebsite() const
+{
+   Website website;
+   // Website's setters copy their argument but do not take const char *
+   website.setTopic(const_cast<char *>(topic));
+   website.setURL(const_cast<char *>(url));
+   website.setSummary(const_cast<char *>(summary));
+   website.setReview(const_cast<char *>(getReview()));
+   website.setRating(rating);
+   return website;
+}
+
+// COMPACT TABLE
+
+const uint32_t CompactTable::NONE; // passed by reference to vector::assign
+
+// Constructor
+// Description: Makes an empty table with at least capacity buckets, rounded
+//              up to the next prime of PrimeGrowth. Topics are hashed with
+//              TopicSumHash, like Table, or with KeyedStringHash if
+//              hashSeed is not 0.
+// Input: capacity - the smallest number of buckets wanted
+//        hashSeed - the hash key, 0 for TopicSumHash
+CompactTable::CompactTable(int capacity, uint64_t hashSeed)
+{
+   size_t buckets = capacity > INIT_CAP ?
+                    PrimeGrowth::nextCapacity(capacity - 1) : INIT_CAP;
+   growth.reset(buckets);
+   this->buckets.assign(buckets, NONE);
+   this->hashSeed = hashSeed;
+   freeEntry = NONE;
+   size = 0;
+   deadBytes = 0;
+}
+
+// insert
+// Description: Inserts a website. It goes into its topic's list after
+//              every website rated the same or higher, so the list stays in
+//              rating order with ties in insertion order, like a Table run.
+//              A website whose URL is already in its topic is not inserted;
+//              unlike Table, which also rejects a URL of another topic that
+//              shares the chain, only the topic's own websites are compared.
+//              Once there are more topics than buckets the table grows.
+// Input: website - the website to be inserted
+// Output: true if it was inserted, false if it already exists or a pool or
+//         the entry array has no 32 bit offset left for it
+bool CompactTable::insert(const Website & website)
+{
+   const char * name = website.getTopic() ? website.getTopic() : "";
+   const char * url = website.getURL() ? website.getURL() : "";
+   const char * summary = website.getSummary() ? website.getSummary() : "";
+   const char * review = website.getReview() ? website.getReview() : "";
+   uint32_t topic = findTopic(name);
+   if (topic != NONE && findEntry(topic, url, nullptr) != NONE)
+   {
+      return false;
+   }
+   size_t nameLength = strlen(name);
+   size_t urlLength = strlen(url);
+   size_t summaryLength = strlen(summary);
+   size_t reviewLength = strlen(review);
+   size_t keyBytes = urlLength + 1 + (topic == NONE ? nameLength + 1 : 0);
+   if (!fits(keys, keyBytes) ||
+       !fits(text, summaryLength + reviewLength + 2) ||
+       (freeEntry == NONE && entries.size() >= NONE) ||
+       (topic == NONE && topics.size() >= NONE))
+   {
+      return false;
+   }
+   if (topic == NONE) // new topic, at the head of its bucket's chain
+   {
+      uint32_t bucket = bucketOf(name);
+      CompactTopic added;
+      added.name = append(keys, name, nameLength);
+      added.next = buckets[bucket];
+      added.first = NONE;
+      topic = (uint32_t)topics.size();
+      topics.push_back(added);
+      buckets[bucket] = topic;
+   }
+   CompactEntry entry;
+   entry.next = NONE;
+   entry.url = append(keys, url, urlLength);
+   entry.text = append(text, summary, summaryLength).offset;
+   append(text, review, reviewLength);
+   entry.rating = website.getRating();
+   uint32_t index = freeEntry;
+   if (index != NONE) // reuse a removed entry
+   {
+      freeEntry = entries[index].next;
+      entries[index] = entry;
+   }
+   else
+   {
+      index = (uint32_t)entries.size();
+      entries.push_back(entry);
+   }
+   linkSorted(topic, index);
+   size++;
+   if (topics.size() > buckets.size()) // more than one topic per chain
+   {
+      grow();
+   }
+   return true;
+}
+
+// retrieve
+// Description: Copies every website of a topic into all_matches, best
+//              rated first.
+// Input: topic - the topic, all_matches - room for all of its websites
+//        num_found - passed back: the number copied
+// Output: true if the topic has any websites, false if not
+bool CompactTable::retrieve(const char * topic, Website all_matches[],
+                            int & num_found) const
+{
+   num_found = 0;
+   uint32_t found = findTopic(topic);
+   if (found == NONE)
+   {
+      return false;
+   }
+   for (uint32_t entry = topics[found].first; entry != NONE;
+        entry = entries[entry].next)
+   {
+      CompactSite site;
+      siteAt(found, entry, site);
+      all_matches[num_found] = site.toWebsite();
+      num_found++;
+   }
+   return num_found > 0;
+}
+
+// topK
+// Description: Views of the k best rated websites of a topic, best first.
+//              Nothing is copied: the list is already in rating order.
+// Input: topic, k - the most to pass back, top - room for k views
+//        num_found - passed back: the number of views filled in
+// Output: true if the topic has any websites, false if not
+bool CompactTable::topK(const char * topic, int k, CompactSite top[],
+                        int & num_found) const
+{
+   num_found = 0;
+   uint32_t found = findTopic(topic);
+   if (found == NONE)
+   {
+      return false;
+   }
+   for (uint32_t entry = topics[found].first; entry != NONE && num_found < k;
+        entry = entries[entry].next)
+   {
+      siteAt(found, entry, top[num_found]);
+      num_found++;
+   }
+   return num_found > 0;
+}
+
+// edit
+// Description: Gives a website a new review and rating. The summary and new
+//              review are appended to the text pool (they are stored side
+//              by side) and the old ones become dead bytes. If the rating
+//              changes the website moves after every other website of the
+//              topic rated the same or higher, like Table::edit.
+// Input: topic, url - the website, newReview, newRating
+// Output: true if the website was edited, false if it does not exist or
+//         the text pool is full
+bool CompactTable::edit(const char * topic, const char * url,
+                        const char * newReview, int newRating)
+{
+   uint32_t found = findTopic(topic);
+   if (found == NONE)
+   {
+      return false;
+   }
+   uint32_t before = NONE;
+   uint32_t entry = findEntry(found, url, &before);
+   if (entry == NONE)
+   {
+      return false;
+   }
+   string summary = &text[entries[entry].text]; // the pool may move
+   size_t reviewLength = strlen(newReview);
+   if (!fits(text, summary.size() + reviewLength + 2))
+   {
+      return false;
+   }
+   deadBytes += textBytes(entry);
+   entries[entry].text = append(text, summary.c_str(), summary.size()).offset;
+   append(text, newReview, reviewLength);
+   if (entries[entry].rating != newRating)
+   {
+      if (before == NONE) // unlink, then link at the new rating
+      {
+         topics[found].first = entries[entry].next;
+      }
+      else
+      {
+         entries[before].next = entries[entry].next;
+      }
+      entries[entry].rating = newRating;
+      linkSorted(found, entry);
+   }
+   return true;
+}
+
+// removeOneStar
+// Description: Removes every website with a rating of 1. Their entries go
+//              on the free list for later inserts and their strings become
+//              dead bytes; once more than half of the pool bytes are dead,
+//              compact() rebuilds the table without them.
+// Input: None
+// Output: true if something was removed, false if not
+bool CompactTable::removeOneStar()
+{
+   bool removed = false;
+   for (size_t topic = 0; topic < topics.size(); topic++)
+   {
+      uint32_t before = NONE;
+      uint32_t entry = topics[topic].first;
+      while (entry != NONE)
+      {
+         uint32_t next = entries[entry].next;
+         if (entries[entry].rating == 1)
+         {
+            if (before == NONE)
+            {
+               topics[topic].first = next;
+            }
+            else
+            {
+               entries[before].next = next;
+            }
+            deadBytes += entries[entry].url.length + 1 + textBytes(entry);
+            entries[entry].next = freeEntry;
+            freeEntry = entry;
+            size--;
+            removed = true;
+         }
+         else
+         {
+            before = entry;
+         }
+         entry = next;
+      }
+   }
+   if (deadBytes > (keys.size() + text.size()) / 2)
+   {
+      compact();
+   }
+   return removed;
+}
+
+// compact
+// Description: Rebuilds the buckets, topics, entries and pools with only the
+//              live topics (those with websites left) and websites, copied
+//              topic by topic. Dead bytes and removed entries are dropped,
+//              every topic's websites end up next to each other in rating
+//              order, and the arrays are trimmed to their size.
+// Input: None
+// Output: None
+void CompactTable::compact()
+{
+   vector<uint32_t> newBuckets(buckets.size(), NONE);
+   vector<CompactTopic> newTopics;
+   vector<CompactEntry> newEntries;
+   vector<char> newKeys;
+   vector<char> newText;
+   newEntries.reserve(size);
+   for (size_t topic = 0; topic < topics.size(); topic++)
+   {
+      if (topics[topic].first == NONE)
+      {
+         continue;
+      }
+      const char * name = &keys[topics[topic].name.offset];
+      uint32_t bucket = bucketOf(name);
+      CompactTopic copy;
+      copy.name = append(newKeys, name, topics[topic].name.length);
+      copy.next = newBuckets[bucket];
+      copy.first = NONE;
+      uint32_t last = NONE;
+      for (uint32_t entry = topics[topic].first; entry != NONE;
+           entry = entries[entry].next)
+      {
+         CompactEntry moved = entries[entry];
+         const char * summary = &text[moved.text];
+         const char * review = summary + strlen(summary) + 1;
+         moved.next = NONE;
+         moved.url = append(newKeys, &keys[moved.url.offset], moved.url.length);
+         moved.text = append(newText, summary, strlen(summary)).offset;
+         append(newText, review, strlen(review));
+         uint32_t index = (uint32_t)newEntries.size();
+         newEntries.push_back(moved);
+         if (last == NONE)
+         {
+            copy.first = index;
+         }
+         else
+         {
+            newEntries[last].next = index;
+         }
+         last = index;
+      }
+      newBuckets[bucket] = (uint32_t)newTopics.size();
+      newTopics.push_back(copy);
+   }
+   buckets.swap(newBuckets);
+   topics.swap(newTopics);
+   entries.swap(newEntries);
+   keys.swap(newKeys);
+   text.swap(newText);
+   topics.shrink_to_fit();
+   entries.shrink_to_fit();
+   keys.shrink_to_fit();
+   text.shrink_to_fit();
+   freeEntry = NONE;
+   deadBytes = 0;
+}
+
+// loadFromFile
+// Description: Loads websites from a file in the input.txt format with
+//              RecordParser. Bad records are skipped and reported to cerr.
+// Input: filename - the name of the file to be loaded
+// Output: true if the file was read, false if it could not be opened
+bool CompactTable::loadFromFile(const char * filename)
+{
+   RecordParser parser;
+   if (!parser.parseFile(filename, [this](const Website & website)
+   {
+      insert(website);
+   }))
+   {
+      return false;
+   }
+   parser.reportErrors(cerr, filename);
+   return true;
+}
+
+// getSize
+// Description: Returns the number of websites.
+int CompactTable::getSize() const
+{
+   return size;
+}
+
+// getCapacity
+// Description: Returns the number of buckets.
+int CompactTable::getCapacity() const
+{
+   return (int)buckets.size();
+}
+
+// getTopicCount
+// Description: Returns the number of topics, including those whose
+//              websites have all been removed (until compact()).
+int CompactTable::getTopicCount() const
+{
+   return (int)topics.size();
+}
+
+// memoryReport
+// Description: Bytes held, by kind, in the same form as
+//              Table::memoryReport(): buckets and topics are the index,
+//              entries are the nodes, the key pool the keys and the text
+//              pool the text. Requested bytes are the arrays' sizes,
+//              dead bytes included; usable bytes are what the allocator
+//              gave for their capacity, so spare capacity shows as slack.
+// Input: None
+// Output: the report
+MemoryReport CompactTable::memoryReport() const
+{
+   MemoryReport report;
+   report.requested[MEM_INDEX] = buckets.size() * sizeof(uint32_t) +
+                                 topics.size() * sizeof(CompactTopic);
+   report.usable[MEM_INDEX] =
+      usableSize(buckets.data(), buckets.capacity() * sizeof(uint32_t)) +
+      usableSize(topics.data(), topics.capacity() * sizeof(CompactTopic));
+   report.requested[MEM_NODES] = entries.size() * sizeof(CompactEntry);
+   report.usable[MEM_NODES] =
+      usableSize(entries.data(), entries.capacity() * sizeof(CompactEntry));
+   report.requested[MEM_KEYS] = keys.size();
+   report.usable[MEM_KEYS] = usableSize(keys.data(), keys.capacity());
+   report.requested[MEM_TEXT] = text.size();
+   report.usable[MEM_TEXT] = usableSize(text.data(), text.capacity());
+   report.blocks = !buckets.empty() + !topics.empty() + !entries.empty() +
+                   !keys.empty() + !text.empty();
+   report.entries = size;
+   return report;
+}
+
+// getDeadBytes
+// Description: Returns the pool bytes left behind by removed and edited
+//              websites, which compact() gives back.
+size_t CompactTable::getDeadBytes() const
+{
+   return deadBytes;
+}
+
+// bucketOf
+// Description: Hashes a topic like Table does (TopicSumHash, or
+//              KeyedStringHash with a seed) and maps it to a bucket with
+//              the PrimeGrowth fast modulo.
+// Input: topic - the topic
+// Output: the bucket index
+uint32_t CompactTable::bucketOf(const char * topic) const
+{
+   if (hashSeed)
+   {
+      return (uint32_t)growth.index(KeyedStringHash(hashSeed,
+                                                    ~hashSeed)(topic));
+   }
+   return (uint32_t)growth.index(TopicSumHash()(topic));
+}
+
+// findTopic
+// Description: Walks the topic's bucket chain for it.
+// Input: topic - the topic
+// Output: its index in topics, NONE if it is not there
+uint32_t CompactTable::findTopic(const char * topic) const
+{
+   size_t length = strlen(topic);
+   uint32_t curr = buckets[bucketOf(topic)];
+   while (curr != NONE && !equals(keys, topics[curr].name, topic, length))
+   {
+      curr = topics[curr].next;
+   }
+   return curr;
+}
+
+// findEntry
+// Description: Walks a topic's websites for a URL.
+// Input: topic - its index, url - the URL
+//        before - if not nullptr, passed back: the entry before the one
+//                 found, NONE if it is the topic's first
+// Output: the entry, NONE if the topic has no website with that URL
+uint32_t CompactTable::findEntry(uint32_t topic, const char * url,
+                                 uint32_t * before) const
+{
+   size_t length = strlen(url);
+   uint32_t previous = NONE;
+   uint32_t curr = topics[topic].first;
+   while (curr != NONE && !equals(keys, entries[curr].url, url, length))
+   {
+      previous = curr;
+      curr = entries[curr].next;
+   }
+   if (before)
+   {
+      *before = previous;
+   }
+   return curr;
+}
+
+// linkSorted
+// Description: Links an entry into its topic's list after every website
+//              rated the same or higher.
+// Input: topic - its index, entry - the entry, not linked yet
+// Output: None
+void CompactTable::linkSorted(uint32_t topic, uint32_t entry)
+{
+   int rating = entries[entry].rating;
+   uint32_t previous = NONE;
+   uint32_t curr = topics[topic].first;
+   while (curr != NONE && entries[curr].rating >= rating)
+   {
+      previous = curr;
+      curr = entries[curr].next;
+   }
+   entries[entry].next = curr;
+   if (previous == NONE)
+   {
+      topics[topic].first = entry;
+   }
+   else
+   {
+      entries[previous].next = entry;
+   }
+}
+
+// grow
+// Description: Moves to the next PrimeGrowth capacity and relinks every
+//              topic into its new bucket. Only the small topic records
+//              move; the websites stay where they are.
+// Input: None
+// Output: None
+void CompactTable::grow()
+{
+   size_t capacity = PrimeGrowth::nextCapacity(buckets.size());
+   if (capacity <= buckets.size()) // already the largest prime
+   {
+      return;
+   }
+   growth.reset(capacity);
+   buckets.assign(capacity, NONE);
+   for (size_t topic = 0; topic < topics.size(); topic++)
+   {
+      uint32_t bucket = bucketOf(&keys[topics[topic].name.offset]);
+      topics[topic].next = buckets[bucket];
+      buckets[bucket] = (uint32_t)topic;
+   }
+}
+
+// siteAt
+// Description: Points a view at one website.
+// Input: topic, entry - the website's indices
+//        site - passed back: the view
+// Output: None
+void CompactTable::siteAt(uint32_t topic, uint32_t entry,
+                          CompactSite & site) const
+{
+   site.topic = &keys[topics[topic].name.offset];
+   site.url = &keys[entries[entry].url.offset];
+   site.summary = &text[entries[entry].text];
+   site.rating = entries[entry].rating;
+}
+
+// textBytes
+// Description: Bytes an entry's summary and review take in the text pool.
+// Input: entry - the entry
+// Output: the bytes, both '\0's included
+size_t CompactTable::textBytes(uint32_t entry) const
+{
+   const char * summary = &text[entries[entry].text];
+   size_t summaryBytes = strlen(summary) + 1;
+   return summaryBytes + strlen(summary + summaryBytes) + 1;
+}
+
+// fits
+// Description: Checks that bytes more can go into a pool and still start
+//              at a 32 bit offset with a 32 bit length.
+// Input: pool - keys or text, bytes - the bytes to be appended
+// Output: true if they fit
+bool CompactTable::fits(const vector<char> & pool, size_t bytes)
+{
+   return pool.size() + bytes <= UINT32_MAX;
+}
+
+// append
+// Description: Copies a string and a '\0' to the end of a pool.
+// Input: pool - keys or text, chars - the characters, length - how many
+// Output: where it went
+CompactString CompactTable::append(vector<char> & pool, const char * chars,
+                                   size_t length)
+{
+   CompactString added = { (uint32_t)pool.size(), (uint32_t)length };
+   pool.insert(pool.end(), chars, chars + length);
+   pool.push_back('\0');
+   return added;
+}
+
+// equals
+// Description: Compares a pool string with another string of known length,
+//              lengths first, so most mismatches never touch the pool.
+// Input: pool, stored - the pool string, other - the string, length - its
+// Output: true if they hold the same characters
+bool CompactTable::equals(const vector<char> & pool, CompactString stored,
+                          const char * other, size_t length)
+{
+   return stored.length == length &&
+          memcmp(&pool[stored.offset], other, length) == 0;
+}
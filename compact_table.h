@@ -0,0 +1,159 @@
+/******************************************************************************
+# Program Desc.:      This program is a website bookmarking program. The program
+#                     implements a hash table using chaining (pointer array of
+#                     linked lists) to store website information.
+# File:               compact_table.h
+# File Description:   CompactTable, the bookmark table in a compact layout for
+#                     very large collections. Table spends two pointers per
+#                     chain node, a Website of four pointers and an int, and
+#                     six heap blocks per website. CompactTable keeps its
+#                     websites in one contiguous array whose entries link to
+#                     each other by 32 bit index, and its strings in two
+#                     pools (keys: topics and URLs; text: summaries and
+#                     reviews) referenced by 32 bit offset and length, so a
+#                     website costs a 20 byte entry plus its characters, and
+#                     the whole table is a handful of blocks.
+#
+#                     Layout:
+#                        buckets   uint32[capacity], first topic of the
+#                                  bucket's chain
+#                        topics    CompactTopic[]: name, next topic in
+#                                  the bucket, first website
+#                        entries   CompactEntry[]: next website of the same
+#                                  topic, URL, text, rating
+#                        keys      char[], '\0' terminated topics and URLs
+#                        text      char[], summary then review of each
+#                                  website, both '\0' terminated
+#                     A topic's websites form one list, highest rating
+#                     first, ties in insertion order, like a Table run.
+#                     Edits and removals leave their old strings and entries
+#                     behind; compact() (run by removeOneStar once more than
+#                     half the pool bytes are dead) rebuilds everything
+#                     without them. Indices and offsets are 32 bit, so each
+#                     pool holds at most 4 GiB and the table at most
+#                     2^32 - 1 websites. Not thread safe: one thread at a
+#                     time, or any number of readers with no writer.
+# Input:              None
+# Output:             None
+#******************************************************************************/
+#ifndef COMPACT_TABLE_H
+#define COMPACT_TABLE_H
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+#include "website.h"
+#include "basic_table.h"
+#include "memory_stats.h"
+
+using namespace std;
+
+// CompactString
+// A string in one of a CompactTable's pools. The '\0' after it is not
+// counted in length, but is kept so the string can be handed out as is.
+struct CompactString
+{
+   uint32_t offset; // first character in the pool
+   uint32_t length; // characters, without the '\0'
+};
+
+// CompactTopic
+// One topic and the head of its websites. Also MappedTable's file record.
+struct CompactTopic
+{
+   CompactString name; // in keys
+   uint32_t next; // next topic in the same bucket, UINT32_MAX at the end
+   uint32_t first; // best rated website, UINT32_MAX if it has none left
+};
+static_assert(sizeof(CompactTopic) == 16, "compact topic layout");
+
+// CompactEntry
+// One website. Also MappedTable's file record.
+struct CompactEntry
+{
+   uint32_t next; // next website of the topic, UINT32_MAX at the end
+   CompactString url; // in keys
+   uint32_t text; // summary, then review, '\0' terminated, in text
+   int32_t rating;
+};
+static_assert(sizeof(CompactEntry) == 20, "compact entry layout");
+
+// CompactSite
+// Read only view of one website of a CompactTable, with the getters of
+// Website. Its pointers go into the table's pools, so it is only valid
+// until the next write to the table.
+class CompactSite
+{
+public:
+   CompactSite();
+   const char * getTopic() const;
+   const char * getURL() const;
+   const char * getSummary() const;
+   const char * getReview() const;
+   int getRating() const;
+   Website toWebsite() const; // a copy that owns its strings
+
+private:
+   friend class CompactTable;
+   friend class MappedTable;
+   const char * topic;
+   const char * url;
+   const char * summary; // the review follows it in the text pool
+   int rating;
+};
+
+class CompactTable
+{
+public:
+   explicit CompactTable(int capacity = 0,
+                         uint64_t hashSeed = 0); // at least capacity buckets
+
+   bool insert(const Website& website); // add website to the table
+   bool retrieve(const char * topic, Website all_matches[],
+                 int& num_found) const; // copies of a topic's websites
+   bool topK(const char * topic, int k, CompactSite top[],
+             int& num_found) const; // k best rated websites for a topic
+   bool edit(const char * topic, const char * url, const char * newReview,
+             int newRating); // edit a website review and rating
+   bool removeOneStar(); // remove all websites with a rating of 1
+   void compact(); // rebuild without removed websites and old strings
+   bool loadFromFile(const char * filename); // load test data from file
+   int getSize() const; // number of websites
+   int getCapacity() const; // number of buckets
+   int getTopicCount() const; // topics, including emptied ones
+   MemoryReport memoryReport() const; // bytes held, by kind
+   size_t getDeadBytes() const; // pool bytes of removed or edited websites
+
+private:
+   const static uint32_t NONE = UINT32_MAX; // no topic or entry
+   const static int INIT_CAP = 11; // smallest capacity
+
+   vector<uint32_t> buckets; // first topic of each chain, NONE if empty
+   PrimeGrowth growth; // fast modulo constants for the capacity
+   uint64_t hashSeed; // 0 for TopicSumHash, else KeyedStringHash key
+   vector<CompactTopic> topics;
+   vector<CompactEntry> entries; // live ones and removed ones on the free list
+   vector<char> keys; // topic and URL strings
+   vector<char> text; // summary and review strings
+   uint32_t freeEntry; // first removed entry, linked by next, or NONE
+   int size; // number of websites
+   size_t deadBytes; // pool bytes nothing refers to any more
+
+   uint32_t bucketOf(const char * topic) const; // bucket index
+   uint32_t findTopic(const char * topic) const; // topic index or NONE
+   uint32_t findEntry(uint32_t topic, const char * url,
+                      uint32_t * before) const; // entry and its previous
+   void linkSorted(uint32_t topic, uint32_t entry); // by rating
+   void grow(); // next capacity, rehash the topics
+   void siteAt(uint32_t topic, uint32_t entry,
+               CompactSite & site) const; // view of one website
+   size_t textBytes(uint32_t entry) const; // summary and review, '\0's
+   static bool fits(const vector<char> & pool,
+                    size_t bytes); // 32 bit offsets still reach
+   static CompactString append(vector<char> & pool, const char * chars,
+                               size_t length); // copy in with a '\0'
+   static bool equals(const vector<char> & pool, CompactString stored,
+                      const char * other, size_t length); // same chars
+};
+
+#endif
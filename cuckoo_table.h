@@ -0,0 +1,569 @@
+/******************************************************************************
+# Program Desc.:      This program is a website bookmarking program. The program
+#                     implements a hash table using chaining (pointer array of
+#                     linked lists) to store website information.
+# File:               cuckoo_table.h
+# File Description:   Header only cuckoo hash table (CuckooTable) with the
+#                     same interface as BasicTable, for lookups whose worst
+#                     case is bounded no matter what keys are inserted. Every
+#                     key lives in one of two buckets of SLOTS slots, picked
+#                     by a keyed hash, or in a small stash, so a lookup looks
+#                     at no more than MAX_PROBES values. An insert that finds
+#                     both buckets full moves a resident to its other bucket
+#                     (a cuckoo "kick"), up to MAX_KICKS times, then falls back
+#                     to the stash; when the stash is full too the table
+#                     rehashes everything under a new seed, growing if it is
+#                     more than half full. Growth doubles, so inserts are
+#                     amortized O(1).
+# Input:              None
+# Output:             None
+#******************************************************************************/
+#ifndef CUCKOO_TABLE_H
+#define CUCKOO_TABLE_H
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "basic_table.h"
+
+using namespace std;
+
+// CuckooTable
+// Cuckoo hash table with unique keys:
+//    Value        - stored type (copied into the table)
+//    KeyExtractor - functor returning the key of a Value
+//    Hash         - keyed hash functor with reseed() (KeyedStringHash)
+//    Equal        - functor comparing two keys
+// Each slot keeps an 8 bit tag from the hash next to the value pointer, so
+// most slots are rejected without comparing keys. Buckets are 64 bytes.
+template <class Value, class KeyExtractor, class Hash = KeyedStringHash,
+          class Equal = CStringEqual>
+class CuckooTable
+{
+public:
+   typedef typename KeyExtractor::key_type Key;
+   const static int SLOTS = 4; // values per bucket
+   const static int STASH = 8; // values that fit in neither bucket
+   const static int MAX_PROBES = 2 * SLOTS + STASH; // slots a lookup checks
+   const static int MAX_KICKS = 128; // moves before trying the stash
+
+   CuckooTable(); // constructor
+   CuckooTable(const CuckooTable& aTable); // copy constructor
+   CuckooTable(CuckooTable&& aTable); // move constructor
+   ~CuckooTable(); // destructor
+   const CuckooTable& operator= (const CuckooTable& aTable);
+   const CuckooTable& operator= (CuckooTable&& aTable);
+
+   bool insert(const Value& value); // false if the key already exists
+   const Value * find(const Key& key) const; // nullptr if not found
+   Value * find(const Key& key); // nullptr if not found
+   bool erase(const Key& key); // false if not found
+   template <class Visitor>
+   void forEach(Visitor visit) const; // call visit(value) on every value
+   size_t getSize() const; // number of values
+   size_t getCapacity() const; // number of slots, stash not included
+   int getStashSize() const; // values in the stash right now
+   long long getRehashCount() const; // full rehashes so far
+
+private:
+   struct alignas(64) Bucket
+   {
+      uint8_t tags[SLOTS]; // 0 for an empty slot
+      Value * values[SLOTS];
+   };
+   struct Slot // where a key hashes to
+   {
+      size_t first; // bucket
+      size_t second; // other bucket, never the same as first
+      uint8_t tag; // never 0
+   };
+   Bucket * buckets; // bucketCount buckets
+   size_t bucketCount; // a power of two
+   size_t size; // number of values
+   Value * stash[STASH];
+   int stashSize;
+   uint64_t random; // xorshift state for picking kick victims
+   long long rehashes;
+   KeyExtractor keyOf;
+   Hash hasher;
+   Equal equal;
+
+   Slot slotOf(const Key& key) const; // buckets and tag of a key
+   bool place(Value *& value); // put a value in, false if it did not fit
+   bool putInBucket(size_t bucket, Value * value, uint8_t tag);
+   void rehash(Value * homeless); // rebuild under a new seed
+   void drainStash(); // move stash values into free bucket slots
+   uint64_t nextRandom(); // xorshift64
+   void allocate(size_t count); // empty array of count buckets
+   void copy(const CuckooTable& aTable); // deep copy
+   void destroy(); // free every value and the array
+};
+
+// Constructor
+// Description: Makes an empty table of 16 buckets with a random seed.
+template <class V, class K, class H, class E>
+CuckooTable<V, K, H, E>::CuckooTable()
+{
+   allocate(16);
+   size = 0;
+   stashSize = 0;
+   random = randomSeed() | 1;
+   rehashes = 0;
+}
+
+// Copy constructor
+template <class V, class K, class H, class E>
+CuckooTable<V, K, H, E>::CuckooTable(const CuckooTable & aTable)
+{
+   copy(aTable);
+}
+
+// Move constructor
+// Description: Takes the buckets of the table passed in, which is left
+//              empty.
+template <class V, class K, class H, class E>
+CuckooTable<V, K, H, E>::CuckooTable(CuckooTable && aTable)
+{
+   buckets = nullptr;
+   bucketCount = 0;
+   size = 0;
+   stashSize = 0;
+   *this = std::move(aTable);
+}
+
+// Destructor
+template <class V, class K, class H, class E>
+CuckooTable<V, K, H, E>::~CuckooTable()
+{
+   destroy();
+}
+
+// assignment operator overload
+template <class V, class K, class H, class E>
+const CuckooTable<V, K, H, E> &
+CuckooTable<V, K, H, E>::operator=(const CuckooTable & aTable)
+{
+   if (this != &aTable)
+   {
+      destroy();
+      copy(aTable);
+   }
+   return *this;
+}
+
+// move assignment operator overload
+template <class V, class K, class H, class E>
+const CuckooTable<V, K, H, E> &
+CuckooTable<V, K, H, E>::operator=(CuckooTable && aTable)
+{
+   if (this != &aTable)
+   {
+      destroy();
+      buckets = aTable.buckets;
+      bucketCount = aTable.bucketCount;
+      size = aTable.size;
+      stashSize = aTable.stashSize;
+      for (int i = 0; i < stashSize; i++)
+      {
+         stash[i] = aTable.stash[i];
+      }
+      random = aTable.random;
+      rehashes = aTable.rehashes;
+      hasher = aTable.hasher;
+      aTable.allocate(16);
+      aTable.size = 0;
+      aTable.stashSize = 0;
+   }
+   return *this;
+}
+
+// slotOf
+// Description: Hashes the key once: the low bits pick the first bucket,
+//              the high 32 bits the second and the top byte the tag.
+template <class V, class K, class H, class E>
+inline typename CuckooTable<V, K, H, E>::Slot
+CuckooTable<V, K, H, E>::slotOf(const Key & key) const
+{
+   uint64_t hash = hasher(key);
+   size_t mask = bucketCount - 1;
+   Slot slot;
+   slot.first = (size_t)hash & mask;
+   slot.second = (size_t)(hash >> 32) & mask;
+   if (slot.second == slot.first)
+   {
+      slot.second = (slot.first + 1) & mask;
+   }
+   slot.tag = (uint8_t)(hash >> 56) | 1;
+   return slot;
+}
+
+// find (const)
+// Description: Looks in the key's two buckets, then the stash. At most
+//              MAX_PROBES values are looked at.
+// Input: key - the key to look for
+// Output: pointer to the value in the table, nullptr if not found
+template <class V, class K, class H, class E>
+const V * CuckooTable<V, K, H, E>::find(const Key & key) const
+{
+   Slot slot = slotOf(key);
+   const Bucket * pair[2] = { &buckets[slot.first], &buckets[slot.second] };
+   for (int b = 0; b < 2; b++)
+   {
+      for (int i = 0; i < SLOTS; i++)
+      {
+         if (pair[b]->tags[i] == slot.tag &&
+             equal(keyOf(*pair[b]->values[i]), key))
+         {
+            return pair[b]->values[i];
+         }
+      }
+   }
+   for (int i = 0; i < stashSize; i++)
+   {
+      if (equal(keyOf(*stash[i]), key))
+      {
+         return stash[i];
+      }
+   }
+   return nullptr;
+}
+
+// find
+// Description: Same as find (const), but the value can be changed. Changing
+//              the part of the value the key comes from is not allowed.
+template <class V, class K, class H, class E>
+V * CuckooTable<V, K, H, E>::find(const Key & key)
+{
+   return const_cast<V *>(static_cast<const CuckooTable &>(*this).find(key));
+}
+
+// insert
+// Description: Adds a copy of value unless a value with the same key is
+//              already there. Past 90% full the table doubles first.
+// Input: value - the value to insert
+// Output: true if inserted, false if the key already exists
+template <class V, class K, class H, class E>
+bool CuckooTable<V, K, H, E>::insert(const V & value)
+{
+   if (find(keyOf(value)))
+   {
+      return false;
+   }
+   V * newValue = new V(value);
+   size++;
+   if (size * 10 > bucketCount * SLOTS * 9) // keep kicks short
+   {
+      rehash(newValue);
+   }
+   else if (!place(newValue))
+   {
+      rehash(newValue); // place left the value it could not fit in newValue
+   }
+   return true;
+}
+
+// putInBucket
+// Description: Puts the value in a free slot of the bucket, if there is one.
+template <class V, class K, class H, class E>
+inline bool CuckooTable<V, K, H, E>::putInBucket(size_t bucket, V * value,
+                                                 uint8_t tag)
+{
+   for (int i = 0; i < SLOTS; i++)
+   {
+      if (buckets[bucket].tags[i] == 0)
+      {
+         buckets[bucket].tags[i] = tag;
+         buckets[bucket].values[i] = value;
+         return true;
+      }
+   }
+   return false;
+}
+
+// place
+// Description: Puts a value not yet in the table into one of its buckets.
+//              If both are full a random resident of one of them is kicked
+//              out to make room and placed in its own other bucket, and so
+//              on for up to MAX_KICKS moves; then the stash is used.
+// Input: value - the value; if it returns false, set to the value left
+//                without a place (not always the one passed in)
+// Output: false if the stash was full too (the caller must rehash)
+template <class V, class K, class H, class E>
+bool CuckooTable<V, K, H, E>::place(V *& value)
+{
+   Slot slot = slotOf(keyOf(*value));
+   if (putInBucket(slot.first, value, slot.tag) ||
+       putInBucket(slot.second, value, slot.tag))
+   {
+      return true;
+   }
+   size_t bucket = nextRandom() & 1 ? slot.second : slot.first;
+   uint8_t tag = slot.tag;
+   for (int kick = 0; kick < MAX_KICKS; kick++)
+   {
+      int victim = (int)(nextRandom() % SLOTS);
+      V * evicted = buckets[bucket].values[victim];
+      buckets[bucket].values[victim] = value;
+      buckets[bucket].tags[victim] = tag;
+      value = evicted;
+      slot = slotOf(keyOf(*value));
+      tag = slot.tag;
+      bucket = slot.first == bucket ? slot.second : slot.first;
+      if (putInBucket(bucket, value, tag))
+      {
+         return true;
+      }
+   }
+   if (stashSize < STASH)
+   {
+      stash[stashSize++] = value;
+      return true;
+   }
+   return false;
+}
+
+// rehash
+// Description: Takes every value out, picks a new seed and puts them back,
+//              doubling the buckets first if the table is more than half
+//              full, and again whenever a value does not fit.
+// Input: homeless - a value that is counted in size but is in no slot
+// Output: None
+template <class V, class K, class H, class E>
+void CuckooTable<V, K, H, E>::rehash(V * homeless)
+{
+   vector<V *> values;
+   values.reserve(size);
+   values.push_back(homeless);
+   for (size_t b = 0; b < bucketCount; b++)
+   {
+      for (int i = 0; i < SLOTS; i++)
+      {
+         if (buckets[b].tags[i] != 0)
+         {
+            values.push_back(buckets[b].values[i]);
+         }
+      }
+   }
+   for (int i = 0; i < stashSize; i++)
+   {
+      values.push_back(stash[i]);
+   }
+   size_t count = bucketCount;
+   if (size * 2 > bucketCount * SLOTS)
+   {
+      count *= 2;
+   }
+   bool placed = false;
+   while (!placed)
+   {
+      rehashes++;
+      delete [] buckets;
+      allocate(count);
+      stashSize = 0;
+      hasher.reseed();
+      placed = true;
+      for (size_t i = 0; placed && i < values.size(); i++)
+      {
+         V * value = values[i];
+         placed = place(value);
+      }
+      count *= 2; // only used if this size did not work out
+   }
+}
+
+// erase
+// Description: Removes the value with the key passed in. A freed bucket
+//              slot may take a value back out of the stash.
+// Input: key - the key to remove
+// Output: true if something was removed, false if not found
+template <class V, class K, class H, class E>
+bool CuckooTable<V, K, H, E>::erase(const Key & key)
+{
+   Slot slot = slotOf(key);
+   size_t pair[2] = { slot.first, slot.second };
+   for (int b = 0; b < 2; b++)
+   {
+      Bucket & bucket = buckets[pair[b]];
+      for (int i = 0; i < SLOTS; i++)
+      {
+         if (bucket.tags[i] == slot.tag && equal(keyOf(*bucket.values[i]),
+                                                 key))
+         {
+            delete bucket.values[i];
+            bucket.tags[i] = 0;
+            bucket.values[i] = nullptr;
+            size--;
+            drainStash();
+            return true;
+         }
+      }
+   }
+   for (int i = 0; i < stashSize; i++)
+   {
+      if (equal(keyOf(*stash[i]), key))
+      {
+         delete stash[i];
+         stash[i] = stash[--stashSize];
+         size--;
+         return true;
+      }
+   }
+   return false;
+}
+
+// drainStash
+// Description: Moves stash values whose buckets have a free slot back into
+//              the buckets, without kicking anything.
+template <class V, class K, class H, class E>
+void CuckooTable<V, K, H, E>::drainStash()
+{
+   for (int i = 0; i < stashSize; )
+   {
+      Slot slot = slotOf(keyOf(*stash[i]));
+      if (putInBucket(slot.first, stash[i], slot.tag) ||
+          putInBucket(slot.second, stash[i], slot.tag))
+      {
+         stash[i] = stash[--stashSize];
+      }
+      else
+      {
+         i++;
+      }
+   }
+}
+
+// forEach
+// Description: Calls visit on every value, bucket by bucket, then the
+//              stash.
+// Input: visit - functor taking const Value &
+// Output: None
+template <class V, class K, class H, class E>
+template <class Visitor>
+void CuckooTable<V, K, H, E>::forEach(Visitor visit) const
+{
+   for (size_t b = 0; b < bucketCount; b++)
+   {
+      for (int i = 0; i < SLOTS; i++)
+      {
+         if (buckets[b].tags[i] != 0)
+         {
+            visit(static_cast<const V &>(*buckets[b].values[i]));
+         }
+      }
+   }
+   for (int i = 0; i < stashSize; i++)
+   {
+      visit(static_cast<const V &>(*stash[i]));
+   }
+}
+
+// getSize
+template <class V, class K, class H, class E>
+size_t CuckooTable<V, K, H, E>::getSize() const
+{
+   return size;
+}
+
+// getCapacity
+template <class V, class K, class H, class E>
+size_t CuckooTable<V, K, H, E>::getCapacity() const
+{
+   return bucketCount * SLOTS;
+}
+
+// getStashSize
+template <class V, class K, class H, class E>
+int CuckooTable<V, K, H, E>::getStashSize() const
+{
+   return stashSize;
+}
+
+// getRehashCount
+template <class V, class K, class H, class E>
+long long CuckooTable<V, K, H, E>::getRehashCount() const
+{
+   return rehashes;
+}
+
+// nextRandom
+// Description: xorshift64, for picking which resident to kick out.
+template <class V, class K, class H, class E>
+inline uint64_t CuckooTable<V, K, H, E>::nextRandom()
+{
+   random ^= random << 13;
+   random ^= random >> 7;
+   random ^= random << 17;
+   return random;
+}
+
+// allocate
+// Description: Allocates count empty buckets.
+template <class V, class K, class H, class E>
+void CuckooTable<V, K, H, E>::allocate(size_t count)
+{
+   buckets = new Bucket[count]();
+   bucketCount = count;
+}
+
+// copy
+// Description: Deep copies the table passed in, slot for slot and with the
+//              same seed, so it finds every key where the original does.
+template <class V, class K, class H, class E>
+void CuckooTable<V, K, H, E>::copy(const CuckooTable & aTable)
+{
+   allocate(aTable.bucketCount);
+   for (size_t b = 0; b < bucketCount; b++)
+   {
+      for (int i = 0; i < SLOTS; i++)
+      {
+         buckets[b].tags[i] = aTable.buckets[b].tags[i];
+         buckets[b].values[i] = aTable.buckets[b].tags[i] ?
+                                new V(*aTable.buckets[b].values[i]) : nullptr;
+      }
+   }
+   stashSize = aTable.stashSize;
+   for (int i = 0; i < stashSize; i++)
+   {
+      stash[i] = new V(*aTable.stash[i]);
+   }
+   size = aTable.size;
+   random = aTable.random;
+   rehashes = aTable.rehashes;
+   hasher = aTable.hasher;
+}
+
+// destroy
+// Description: Deletes every value and the bucket array.
+template <class V, class K, class H, class E>
+void CuckooTable<V, K, H, E>::destroy()
+{
+   if (buckets)
+   {
+      for (size_t b = 0; b < bucketCount; b++)
+      {
+         for (int i = 0; i < SLOTS; i++)
+         {
+            if (buckets[b].tags[i] != 0)
+            {
+               delete buckets[b].values[i];
+            }
+         }
+      }
+      delete [] buckets;
+      buckets = nullptr;
+   }
+   for (int i = 0; i < stashSize; i++)
+   {
+      delete stash[i];
+   }
+   stashSize = 0;
+   size = 0;
+}
+
+// COMMON INSTANTIATIONS
+
+// websites keyed by topic or URL, bounded lookups under a random seed
+typedef CuckooTable<Website, TopicKey> CuckooTopicTable;
+typedef CuckooTable<Website, UrlKey> CuckooUrlTable;
+
+#endif
@@ -0,0 +1,266 @@
+/******************************************************************************
+# Program Desc.:      This program is a website bookmarking program. The program
+#                     implements a hash table using chaining (pointer array of
+#                     linked lists) to store website information.
+# File:               epoch.cpp
+# File Description:   Implementation of epoch based reclamation. There is a
+#                     global epoch and one record per thread that has ever
+#                     read. A reader copies the global epoch into its record
+#                     on entry and clears it on exit. The epoch can only
+#                     move on once every reader inside is in the current
+#                     one, so after it has moved twice since an object was
+#                     retired, no reader that could have seen it is left.
+# Input:              None
+# Output:             None
+#******************************************************************************/
+#include "epoch.h"
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <deque>
+#include <cstdint>
+
+// EpochRecord
+// One reader thread's state. Records are never freed; a thread that exits
+// leaves its record for the next new thread.
+struct alignas(64) EpochRecord
+{
+   atomic<uint64_t> state{0}; // epoch * 2 + 1 while inside, 0 outside
+   atomic<bool> taken{false}; // owned by a live thread
+   int depth = 0; // guards held, only touched by the owner
+   EpochRecord * next = nullptr; // next record, set before it is published
+};
+
+// Retired
+// An object waiting for the readers of its epoch to leave.
+struct Retired
+{
+   void * object;
+   void (*destroy)(void * object);
+   uint64_t epoch; // global epoch when it was retired
+};
+
+// LocalRecord
+// The calling thread's record, given back when the thread exits.
+struct LocalRecord
+{
+   EpochRecord * record = nullptr;
+   ~LocalRecord()
+   {
+      if (record)
+      {
+         record->state.store(0, memory_order_release);
+         record->taken.store(false, memory_order_release);
+      }
+   }
+};
+
+const static int RECLAIM_EVERY = 64; // retires between reclaim attempts
+
+static atomic<uint64_t> globalEpoch{1};
+static atomic<EpochRecord *> records{nullptr};
+static thread_local LocalRecord localRecord;
+
+// RetiredList
+// Objects waiting to be deleted, oldest epoch first. Only writers and
+// reclaim use it.
+struct RetiredList
+{
+   mutex lock;
+   deque<Retired> objects;
+   int sinceReclaim = 0; // retires since the last reclaim attempt
+};
+
+// retiredList
+// Description: The retired objects. Made on first use and never destroyed,
+//              so objects retired by other static destructors at exit are
+//              still safe to hand over.
+// Input: None
+// Output: the list
+static RetiredList & retiredList()
+{
+   static RetiredList * list = new RetiredList();
+   return *list;
+}
+
+// claimRecord
+// Description: Gives the calling thread a record: one a thread that has
+//              exited left behind, or a new one pushed on the list. Only
+//              compare and swap, no lock, and only on a thread's first
+//              guard.
+// Input: None
+// Output: the record
+static EpochRecord * claimRecord()
+{
+   for (EpochRecord * record = records.load(memory_order_acquire); record;
+        record = record->next)
+   {
+      bool free = false;
+      if (!record->taken.load(memory_order_relaxed) &&
+          record->taken.compare_exchange_strong(free, true))
+      {
+         localRecord.record = record;
+         return record;
+      }
+   }
+   EpochRecord * record = new EpochRecord();
+   record->taken.store(true, memory_order_relaxed);
+   EpochRecord * head = records.load(memory_order_relaxed);
+   do
+   {
+      record->next = head;
+   } while (!records.compare_exchange_weak(head, record,
+                                           memory_order_release,
+                                           memory_order_relaxed));
+   localRecord.record = record;
+   return record;
+}
+
+// EPOCH GUARD
+
+// Constructor
+// Description: Publishes the current epoch in the thread's record. The
+//              exchange is sequentially consistent, so it is ordered
+//              before every load the reader makes next: a writer that sees
+//              the record outside (or in an older epoch) knows the reader
+//              has not loaded anything it unlinked since.
+EpochGuard::EpochGuard()
+{
+   EpochRecord * record = localRecord.record;
+   if (!record)
+   {
+      record = claimRecord();
+   }
+   if (record->depth++ == 0)
+   {
+      record->state.exchange(globalEpoch.load(memory_order_relaxed) * 2 + 1,
+                             memory_order_seq_cst);
+   }
+}
+
+// Destructor
+// Description: Marks the thread outside once its outermost guard ends.
+EpochGuard::~EpochGuard()
+{
+   EpochRecord * record = localRecord.record;
+   if (--record->depth == 0)
+   {
+      record->state.store(0, memory_order_release);
+   }
+}
+
+// tryAdvance
+// Description: Moves the global epoch on by one if every reader inside a
+//              guard has entered in the current epoch.
+// Input: None
+// Output: true if the epoch moved (here or on another thread)
+static bool tryAdvance()
+{
+   uint64_t epoch = globalEpoch.load(memory_order_seq_cst);
+   for (EpochRecord * record = records.load(memory_order_acquire); record;
+        record = record->next)
+   {
+      uint64_t state = record->state.load(memory_order_seq_cst);
+      if ((state & 1) && state / 2 != epoch) // inside, in an older epoch
+      {
+         return false;
+      }
+   }
+   globalEpoch.compare_exchange_strong(epoch, epoch + 1);
+   return true;
+}
+
+// epochRetire
+// Description: Queues an unlinked object under the current epoch, and
+//              every RECLAIM_EVERY retires tries to delete what is safe.
+//              An object is never queued under an older epoch than the one
+//              before it (a later one only makes it wait longer), so the
+//              queue stays in epoch order.
+// Input: object - the object, destroy - deletes it
+// Output: None
+void epochRetire(void * object, void (*destroy)(void * object))
+{
+   Retired retired = { object, destroy, // read after the unlinking store
+                       globalEpoch.load(memory_order_seq_cst) };
+   RetiredList & list = retiredList();
+   bool reclaim = false;
+   {
+      lock_guard<mutex> guard(list.lock);
+      if (!list.objects.empty() && list.objects.back().epoch > retired.epoch)
+      {
+         retired.epoch = list.objects.back().epoch;
+      }
+      list.objects.push_back(retired);
+      if (++list.sinceReclaim >= RECLAIM_EVERY)
+      {
+         list.sinceReclaim = 0;
+         reclaim = true;
+      }
+   }
+   if (reclaim)
+   {
+      epochReclaim();
+   }
+}
+
+// epochReclaim
+// Description: Tries to move the epoch on twice, then deletes every object
+//              retired two or more epochs ago. With no reader inside that
+//              is everything retired so far. Objects are deleted outside
+//              the list's lock, since deleting one may retire others.
+// Input: None
+// Output: None
+void epochReclaim()
+{
+   tryAdvance();
+   tryAdvance();
+   uint64_t epoch = globalEpoch.load(memory_order_acquire);
+   vector<Retired> ready;
+   RetiredList & list = retiredList();
+   {
+      lock_guard<mutex> guard(list.lock);
+      while (!list.objects.empty() && list.objects.front().epoch + 2 <= epoch)
+      {
+         ready.push_back(list.objects.front());
+         list.objects.pop_front();
+      }
+   }
+   for (size_t i = 0; i < ready.size(); i++)
+   {
+      ready[i].destroy(ready[i].object);
+   }
+}
+
+// epochSynchronize
+// Description: Waits until every reader inside a guard when it was called
+//              has left, then deletes everything retired before the call,
+//              including what those deletions retire. Must not be called
+//              while holding a guard, which would wait for itself.
+// Input: None
+// Output: None
+void epochSynchronize()
+{
+   while (epochPending() > 0)
+   {
+      uint64_t target = globalEpoch.load(memory_order_acquire) + 2;
+      while (globalEpoch.load(memory_order_acquire) < target)
+      {
+         if (!tryAdvance())
+         {
+            this_thread::yield();
+         }
+      }
+      epochReclaim();
+   }
+}
+
+// epochPending
+// Description: Returns how many objects are retired but not deleted yet.
+size_t epochPending()
+{
+   RetiredList & list = retiredList();
+   lock_guard<mutex> guard(list.lock);
+   return list.objects.size();
+}
@@ -0,0 +1,58 @@
+/******************************************************************************
+# Program Desc.:      This program is a website bookmarking program. The program
+#                     implements a hash table using chaining (pointer array of
+#                     linked lists) to store website information.
+# File:               epoch.h
+# File Description:   Epoch based reclamation, so readers can walk shared
+#                     structures without a lock while a writer changes them.
+#                     A reader holds an EpochGuard for as long as it uses
+#                     what it read. A writer unlinks an object (one atomic
+#                     pointer store) and hands it to epochRetire instead of
+#                     deleting it; it is deleted once every reader that was
+#                     inside a guard when it was retired has left. Entering
+#                     and leaving a guard are one exchange and one store on
+#                     the thread's own record: readers never take a lock or
+#                     write a shared cache line.
+# Input:              None
+# Output:             None
+#******************************************************************************/
+#ifndef EPOCH_H
+#define EPOCH_H
+#include <cstddef>
+
+using namespace std;
+
+// EpochGuard
+// Marks the calling thread as a reader until the end of the scope. Nothing
+// retired while it is held is deleted before it ends. Guards nest (only
+// the outermost one counts), so a reader can call functions that take
+// their own.
+class EpochGuard
+{
+public:
+   EpochGuard(); // enter the current epoch
+   ~EpochGuard(); // leave it
+   EpochGuard(const EpochGuard &) = delete;
+   const EpochGuard & operator= (const EpochGuard &) = delete;
+};
+
+// epochRetire
+// Deletes object with destroy once no reader can still be looking at it.
+// The object must already be unreachable for new readers. Thread safe;
+// destroy may retire more objects.
+void epochRetire(void * object, void (*destroy)(void * object));
+
+template <class T>
+void epochRetire(T * object)
+{
+   epochRetire(object, [](void * retired)
+   {
+      delete static_cast<T *>(retired);
+   });
+}
+
+void epochReclaim(); // delete what is safe to delete now (never waits)
+void epochSynchronize(); // wait for every reader now inside, then reclaim
+size_t epochPending(); // objects retired but not deleted yet
+
+#endif
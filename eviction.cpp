@@ -0,0 +1,37 @@
+/******************************************************************************
+# Program Desc.:      This program is a website bookmarking program. The program
+#                     implements a hash table using chaining (pointer array of
+#                     linked lists) to store website information.
+# File:               eviction.cpp
+# File Description:   Eviction policy scoring. Table does the sampling and
+#                     the CLOCK sweep itself, since both walk its chains.
+# Input:              None
+# Output:             None
+#******************************************************************************/
+#include "eviction.h"
+
+const char * const EVICTION_POLICY_NAMES[EVICT_POLICIES] = { "lru", "clock",
+                                                             "rating",
+                                                             "hybrid" };
+
+// evictionScore
+// Description: Ranks a sampled website for eviction; of the websites
+//              sampled the one with the highest score is evicted.
+//              EVICT_LOWEST_RATING puts the rating first (every star is worth
+//              more than any age difference) and the age second.
+// Input: policy - a sampling policy (not EVICT_CLOCK)
+//        rating - the website's rating
+//        age - writes to the table since the website was last used
+// Output: the score
+double evictionScore(EvictionPolicy policy, int rating, uint32_t age)
+{
+   switch (policy)
+   {
+      case EVICT_LOWEST_RATING:
+         return -(double)rating * 4294967296.0 + age;
+      case EVICT_HYBRID:
+         return (age + 1.0) / (rating > 1 ? rating : 1);
+      default: // EVICT_LRU
+         return age;
+   }
+}
@@ -0,0 +1,64 @@
+/******************************************************************************
+# Program Desc.:      This program is a website bookmarking program. The program
+#                     implements a hash table using chaining (pointer array of
+#                     linked lists) to store website information.
+# File:               eviction.h
+# File Description:   Memory budget for a Table used as a bounded cache. A
+#                     budget caps the number of websites and/or the bytes the
+#                     table holds (as Table::memoryReport counts them); an
+#                     insert or edit that goes over evicts websites chosen by
+#                     the policy until the table fits again.
+#
+#                     Access tracking is approximate so reads stay cheap and
+#                     safe for concurrent readers: each node keeps a
+#                     "last used" tick and a CLOCK "referenced" bit, both
+#                     relaxed atomics written only when they change. The
+#                     tick advances on writes, not reads, so recency is
+#                     measured in inserts and edits.
+# Input:              None
+# Output:             None
+#******************************************************************************/
+#ifndef EVICTION_H
+#define EVICTION_H
+#include <cstddef>
+#include <cstdint>
+
+using namespace std;
+
+// EvictionPolicy
+// How the website to evict is picked.
+enum EvictionPolicy
+{
+   EVICT_LRU, // least recently used of a sample of chains
+   EVICT_CLOCK, // CLOCK sweep over the buckets: used websites get a second
+                // chance, the first one not used since the last pass goes
+   EVICT_LOWEST_RATING, // lowest rated of a sample, least recent on ties
+   EVICT_HYBRID, // highest age / rating of a sample: old and poorly rated
+                 // websites go first, a 5 star website lasts 5 times longer
+   EVICT_POLICIES
+};
+extern const char * const EVICTION_POLICY_NAMES[EVICT_POLICIES];
+
+// EvictionBudget
+// Limits of a table (see Table::setBudget). 0 means no limit.
+struct EvictionBudget
+{
+   int maxEntries = 0; // most websites
+   size_t maxBytes = 0; // most bytes, bucket array included
+   EvictionPolicy policy = EVICT_LRU;
+   int samples = 5; // chains looked at per eviction (not CLOCK)
+};
+
+// EvictionStats
+// Counters of a table's budget since it was set.
+struct EvictionStats
+{
+   long long evictions = 0; // websites evicted
+   long long examined = 0; // websites looked at to pick them
+   size_t bytes = 0; // bytes held right now
+};
+
+// score of a candidate under a sampling policy, the highest is evicted
+double evictionScore(EvictionPolicy policy, int rating, uint32_t age);
+
+#endif
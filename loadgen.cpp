@@ -0,0 +1,318 @@
+/******************************************************************************
+# Program Desc.:      This program is a website bookmarking program. The program
+#                     implements a hash table using chaining (pointer array of
+#                     linked lists) to store website information.
+# File:               loadgen.cpp
+# File Description:   Load generator for the query server. Fills the server
+#                     with synthetic websites, then runs a number of client
+#                     connections, each sending pipelined GET/EDIT requests,
+#                     and reports throughput (QPS) and latency percentiles.
+# Input:              Command line options (see usage)
+# Output:             Throughput and latency summary
+#******************************************************************************/
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <random>
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+#include <unistd.h>
+using namespace std;
+
+#include "protocol.h"
+
+// Options for a run
+struct LoadOptions
+{
+   const char * unixPath = nullptr;
+   int port = DEFAULT_PORT;
+   int conns = 4; // client connections, one thread each
+   int requests = 10000; // requests per connection
+   int pipeline = 16; // requests in flight per connection
+   int writePercent = 10; // percent of requests that are EDITs
+   int topics = 100; // distinct topics loaded before the run
+   int sitesPerTopic = 10; // websites per topic loaded before the run
+   unsigned seed = 1;
+};
+
+// LineReader
+// Buffered line reader over a blocking socket.
+class LineReader
+{
+public:
+   LineReader(int aFd) : fd(aFd), start(0) {}
+   bool readLine(string &line); // false on EOF or error
+
+private:
+   int fd;
+   string buffer;
+   size_t start; // first unread byte in buffer
+};
+
+// Function Prototypes
+bool parseOptions(int argc, char * argv[], LoadOptions &options);
+bool populate(const LoadOptions &options);
+void runClient(const LoadOptions &options, int clientNum,
+               vector<long long> &latencies, long long &errors);
+bool readResponse(LineReader &reader, string &status);
+
+int main(int argc, char * argv[])
+{
+   LoadOptions options;
+   if (!parseOptions(argc, argv, options))
+   {
+      cerr << "Usage: loadgen [--unix path | --port n] [--conns n] "
+           << "[--requests n] [--pipeline n] [--writes percent] "
+           << "[--topics n] [--sites n] [--seed n]" << endl;
+      return 1;
+   }
+   if (!populate(options))
+   {
+      cerr << "Could not load websites into the server" << endl;
+      return 1;
+   }
+
+   vector<vector<long long> > latencies(options.conns);
+   vector<long long> errors(options.conns, 0);
+   vector<thread> clients;
+   chrono::steady_clock::time_point start = chrono::steady_clock::now();
+   for (int i = 0; i < options.conns; i++)
+   {
+      clients.push_back(thread(runClient, cref(options), i,
+                               ref(latencies[i]), ref(errors[i])));
+   }
+   for (int i = 0; i < options.conns; i++)
+   {
+      clients[i].join();
+   }
+   double seconds = chrono::duration<double>(
+      chrono::steady_clock::now() - start).count();
+
+   vector<long long> all;
+   long long totalErrors = 0;
+   for (int i = 0; i < options.conns; i++)
+   {
+      all.insert(all.end(), latencies[i].begin(), latencies[i].end());
+      totalErrors += errors[i];
+   }
+   if (all.empty())
+   {
+      cerr << "No responses" << endl;
+      return 1;
+   }
+   sort(all.begin(), all.end());
+   double percentiles[] = { 50, 90, 99, 99.9 };
+   const char * labels[] = { "p50", "p90", "p99", "p99.9" };
+   cout << "requests: " << all.size() << " errors: " << totalErrors << endl;
+   cout << fixed << setprecision(0) << "QPS: " << all.size() / seconds
+        << endl << setprecision(1);
+   for (int i = 0; i < 4; i++)
+   {
+      size_t index = (size_t)(percentiles[i] / 100 * (all.size() - 1));
+      cout << labels[i] << ": " << all[index] / 1000.0 << " us"
+           << endl;
+   }
+   cout << "max: " << all.back() / 1000.0 << " us" << endl;
+   return totalErrors == 0 ? 0 : 1;
+}
+
+// parseOptions function
+// Description: Reads the command line into options.
+// Input: argc, argv, options to fill
+// Output: false if an option is unknown or missing its value
+bool parseOptions(int argc, char * argv[], LoadOptions &options)
+{
+   for (int i = 1; i < argc; i++)
+   {
+      if (i + 1 >= argc)
+      {
+         return false;
+      }
+      const char * value = argv[i + 1];
+      if (strcmp(argv[i], "--unix") == 0)
+         options.unixPath = value;
+      else if (strcmp(argv[i], "--port") == 0)
+         options.port = atoi(value);
+      else if (strcmp(argv[i], "--conns") == 0)
+         options.conns = max(1, atoi(value));
+      else if (strcmp(argv[i], "--requests") == 0)
+         options.requests = max(1, atoi(value));
+      else if (strcmp(argv[i], "--pipeline") == 0)
+         options.pipeline = max(1, atoi(value));
+      else if (strcmp(argv[i], "--writes") == 0)
+         options.writePercent = atoi(value);
+      else if (strcmp(argv[i], "--topics") == 0)
+         options.topics = max(1, atoi(value));
+      else if (strcmp(argv[i], "--sites") == 0)
+         options.sitesPerTopic = max(1, atoi(value));
+      else if (strcmp(argv[i], "--seed") == 0)
+         options.seed = (unsigned)atoi(value);
+      else
+         return false;
+      i++;
+   }
+   return true;
+}
+
+// populate function
+// Description: Adds topics * sitesPerTopic websites to the server on one
+//              connection, pipelining all of them. Websites that already
+//              exist (from an earlier run) count as loaded.
+// Input: options
+// Output: false if the server could not be reached or an ADD failed
+bool populate(const LoadOptions &options)
+{
+   int fd = openClient(options.unixPath, options.port);
+   if (fd < 0)
+   {
+      return false;
+   }
+   string requests;
+   int count = options.topics * options.sitesPerTopic;
+   for (int i = 0; i < count; i++)
+   {
+      int topic = i % options.topics;
+      requests += "ADD\ttopic-" + to_string(topic) + "\thttps://site/" +
+                  to_string(i) + "\tsynthetic summary\tsynthetic review\t" +
+                  to_string(i % 5 + 1) + "\n";
+   }
+   bool ok = write(fd, requests.data(), requests.size()) ==
+             (ssize_t)requests.size();
+   LineReader reader(fd);
+   for (int i = 0; ok && i < count; i++)
+   {
+      string status;
+      ok = readResponse(reader, status) && status != "ERR";
+   }
+   close(fd);
+   return ok;
+}
+
+// runClient function
+// Description: Sends options.requests requests on its own connection, in
+//              rounds of options.pipeline requests written at once, and
+//              records each request's latency (from when its round was sent
+//              until its response was read) in nanoseconds.
+// Input: options, clientNum (seeds the random mix), latencies, errors
+// Output: None
+void runClient(const LoadOptions &options, int clientNum,
+               vector<long long> &latencies, long long &errors)
+{
+   int fd = openClient(options.unixPath, options.port);
+   if (fd < 0)
+   {
+      errors += options.requests;
+      return;
+   }
+   mt19937 random(options.seed * 7919 + clientNum);
+   uniform_int_distribution<int> topicDist(0, options.topics - 1);
+   uniform_int_distribution<int> siteDist(0, options.sitesPerTopic - 1);
+   uniform_int_distribution<int> percentDist(0, 99);
+   LineReader reader(fd);
+   latencies.reserve(options.requests);
+
+   int sent = 0;
+   while (sent < options.requests)
+   {
+      int round = min(options.pipeline, options.requests - sent);
+      string requests;
+      for (int i = 0; i < round; i++)
+      {
+         int topic = topicDist(random);
+         if (percentDist(random) < options.writePercent)
+         {
+            int site = topic + siteDist(random) * options.topics;
+            requests += "EDIT\ttopic-" + to_string(topic) + "\thttps://site/" +
+                        to_string(site) + "\tedited review\t" +
+                        to_string(percentDist(random) % 5 + 1) + "\n";
+         }
+         else
+         {
+            requests += "GET\ttopic-" + to_string(topic) + "\n";
+         }
+      }
+      chrono::steady_clock::time_point start = chrono::steady_clock::now();
+      if (write(fd, requests.data(), requests.size()) !=
+          (ssize_t)requests.size())
+      {
+         errors += options.requests - sent;
+         break;
+      }
+      for (int i = 0; i < round; i++)
+      {
+         string status;
+         if (!readResponse(reader, status))
+         {
+            errors += options.requests - sent;
+            close(fd);
+            return;
+         }
+         if (status == "ERR")
+         {
+            errors++;
+         }
+         latencies.push_back(chrono::duration_cast<chrono::nanoseconds>(
+            chrono::steady_clock::now() - start).count());
+      }
+      sent += round;
+   }
+   close(fd);
+}
+
+// readResponse function
+// Description: Reads one response: the status line, plus the website lines
+//              that follow an OK to a GET (GET is the only command whose OK
+//              count is followed by lines; PURGE is never sent here).
+// Input: reader, status to be passed back
+// Output: false if the connection ended
+bool readResponse(LineReader &reader, string &status)
+{
+   string line;
+   if (!reader.readLine(line))
+   {
+      return false;
+   }
+   size_t space = line.find(' ');
+   status = line.substr(0, space);
+   int lines = space == string::npos ? 0 : atoi(line.c_str() + space + 1);
+   for (int i = 0; i < lines; i++)
+   {
+      if (!reader.readLine(line))
+      {
+         return false;
+      }
+   }
+   return true;
+}
+
+// readLine
+// Description: Passes back the next line without its newline, reading from
+//              the socket only when the buffer has no complete line.
+// Input: line to be passed back
+// Output: false on EOF or error
+bool LineReader::readLine(string &line)
+{
+   while (true)
+   {
+      size_t newline = buffer.find('\n', start);
+      if (newline != string::npos)
+      {
+         line.assign(buffer, start, newline - start);
+         start = newline + 1;
+         return true;
+      }
+      buffer.erase(0, start);
+      start = 0;
+      char chunk[16384];
+      ssize_t got = read(fd, chunk, sizeof(chunk));
+      if (got <= 0)
+      {
+         return false;
+      }
+      buffer.append(chunk, got);
+   }
+}
@@ -0,0 +1,975 @@
+/******************************************************************************
+# Program Desc.:      This program is a website bookmarking program. The program
+#                     implements a hash table using chaining (pointer array of
+#                     linked lists) to store website information.
+# File:               mapped_table.cpp
+# File Description:   Implementation of MappedTable. Every record is reached
+#                     through base plus its region's offset, never through a
+#                     saved pointer, since growing the file can move the
+#                     mapping.
+# Input:              Mapped table file
+# Output:             Mapped table file
+#******************************************************************************/
+#include "mapped_table.h"
+
+#include <iostream>
+#include <vector>
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "record_parser.h"
+
+const uint64_t MAPPED_ALIGN = 64; // region alignment
+
+// record sizes of the regions, 1 for the string pools
+static const uint64_t RECORD_BYTES[MAP_REGIONS] = { sizeof(uint32_t),
+   sizeof(CompactTopic), sizeof(CompactEntry), 1, 1 };
+
+// alignUp
+// Description: Rounds a region size up to the next region boundary.
+static uint64_t alignUp(uint64_t bytes)
+{
+   return (bytes + MAPPED_ALIGN - 1) / MAPPED_ALIGN * MAPPED_ALIGN;
+}
+
+const uint32_t MappedTable::NONE; // passed by reference to vector and max
+const uint64_t MappedTable::MIN_REGION;
+
+// Constructor
+// Description: Makes a table with no file open.
+MappedTable::MappedTable()
+{
+   base = nullptr;
+   length = 0;
+   fd = -1;
+}
+
+// Destructor
+// Description: Checkpoints and unmaps the file, if one is open.
+MappedTable::~MappedTable()
+{
+   close();
+}
+
+// open
+// Description: Opens a table file read write, locked so no other
+//              MappedTable can open it, and maps it. A missing or empty file
+//              becomes a new empty table hashed with hashSeed (0 for
+//              TopicSumHash). An existing file keeps the seed it was made
+//              with, and is only checked at the header (see validate): a
+//              clean file is the last checkpoint, so the records are
+//              trusted and none are read until used.
+// Input: filename - the file, hashSeed - the hash key of a new table
+// Output: true if the table is open, false if not (getError says why)
+bool MappedTable::open(const char * filename, uint64_t hashSeed)
+{
+   close();
+   error.clear();
+   fd = ::open(filename, O_RDWR | O_CREAT, 0644);
+   if (fd < 0)
+   {
+      error = string("cannot open: ") + strerror(errno);
+      return false;
+   }
+   if (flock(fd, LOCK_EX | LOCK_NB) != 0)
+   {
+      error = "in use by another MappedTable";
+      release();
+      return false;
+   }
+   struct stat info;
+   if (fstat(fd, &info) != 0)
+   {
+      error = string("cannot stat: ") + strerror(errno);
+      release();
+      return false;
+   }
+   bool opened = false;
+   if (info.st_size == 0)
+   {
+      opened = create(hashSeed);
+   }
+   else
+   {
+      void * mapping = mmap(nullptr, info.st_size, PROT_READ | PROT_WRITE,
+                            MAP_SHARED, fd, 0);
+      if (mapping == MAP_FAILED)
+      {
+         error = string("cannot map: ") + strerror(errno);
+      }
+      else
+      {
+         base = (char *)mapping;
+         length = info.st_size;
+         opened = validate();
+      }
+   }
+   if (!opened)
+   {
+      release();
+      return false;
+   }
+   growth.reset(count(MAP_BUCKETS));
+   return true;
+}
+
+// checkpoint
+// Description: Writes every changed page of the mapping to the file, and
+//              only then marks the header clean and writes it, so a clean
+//              file on disk is always a whole table.
+// Input: None
+// Output: true if the file is clean on disk, false if no file is open or a
+//         write failed (the file then stays dirty)
+bool MappedTable::checkpoint()
+{
+   if (!base)
+   {
+      return false;
+   }
+   if (header()->state == MAPPED_CLEAN)
+   {
+      return true;
+   }
+   if (msync(base, length, MS_SYNC) != 0)
+   {
+      return false;
+   }
+   header()->state = MAPPED_CLEAN;
+   return msync(base, sizeof(MappedHeader), MS_SYNC) == 0;
+}
+
+// close
+// Description: Checkpoints and unmaps the file, if one is open.
+void MappedTable::close()
+{
+   if (base)
+   {
+      checkpoint();
+   }
+   release();
+}
+
+// isOpen
+// Description: Returns true if a file is open.
+bool MappedTable::isOpen() const
+{
+   return base != nullptr;
+}
+
+// getError
+// Description: Returns why the last open failed, "" if it did not.
+const char * MappedTable::getError() const
+{
+   return error.c_str();
+}
+
+// insert
+// Description: Inserts a website, like CompactTable::insert: after every
+//              website of its topic rated the same or higher, and not if
+//              its URL is already in its topic. The regions it appends to
+//              are made room in first, which may grow the file.
+// Input: website - the website to be inserted
+// Output: true if it was inserted, false if no file is open, it already
+//         exists, a 32 bit offset or index has no room left for it or the
+//         file could not grow
+bool MappedTable::insert(const Website & website)
+{
+   if (!base)
+   {
+      return false;
+   }
+   const char * name = website.getTopic() ? website.getTopic() : "";
+   const char * url = website.getURL() ? website.getURL() : "";
+   const char * summary = website.getSummary() ? website.getSummary() : "";
+   const char * review = website.getReview() ? website.getReview() : "";
+   uint32_t topic = findTopic(name);
+   if (topic != NONE && findEntry(topic, url, nullptr) != NONE)
+   {
+      return false;
+   }
+   size_t nameLength = strlen(name);
+   size_t urlLength = strlen(url);
+   size_t summaryLength = strlen(summary);
+   size_t reviewLength = strlen(review);
+   size_t keyBytes = urlLength + 1 + (topic == NONE ? nameLength + 1 : 0);
+   size_t textBytes = summaryLength + reviewLength + 2;
+   bool newEntry = header()->freeEntry == NONE;
+   if (header()->regions[MAP_KEYS].bytes + keyBytes > UINT32_MAX ||
+       header()->regions[MAP_TEXT].bytes + textBytes > UINT32_MAX ||
+       (newEntry && count(MAP_ENTRIES) >= NONE) ||
+       (topic == NONE && count(MAP_TOPICS) >= NONE))
+   {
+      return false;
+   }
+   markDirty();
+   if (!reserve(MAP_KEYS, keyBytes) || !reserve(MAP_TEXT, textBytes) ||
+       (newEntry && !reserve(MAP_ENTRIES, sizeof(CompactEntry))) ||
+       (topic == NONE && !reserve(MAP_TOPICS, sizeof(CompactTopic))))
+   {
+      return false;
+   }
+   if (topic == NONE) // new topic, at the head of its bucket's chain
+   {
+      uint32_t bucket = bucketOf(name);
+      CompactTopic added;
+      added.name = append(MAP_KEYS, name, nameLength);
+      added.next = buckets()[bucket];
+      added.first = NONE;
+      topic = count(MAP_TOPICS);
+      topics()[topic] = added;
+      header()->regions[MAP_TOPICS].bytes += sizeof(CompactTopic);
+      buckets()[bucket] = topic;
+   }
+   CompactEntry entry;
+   entry.next = NONE;
+   entry.url = append(MAP_KEYS, url, urlLength);
+   entry.text = append(MAP_TEXT, summary, summaryLength).offset;
+   append(MAP_TEXT, review, reviewLength);
+   entry.rating = website.getRating();
+   uint32_t index = header()->freeEntry;
+   if (index != NONE) // reuse a removed entry
+   {
+      header()->freeEntry = entries()[index].next;
+   }
+   else
+   {
+      index = count(MAP_ENTRIES);
+      header()->regions[MAP_ENTRIES].bytes += sizeof(CompactEntry);
+   }
+   entries()[index] = entry;
+   linkSorted(topic, index);
+   header()->size++;
+   if (count(MAP_TOPICS) > count(MAP_BUCKETS)) // more than one topic a chain
+   {
+      grow();
+   }
+   return true;
+}
+
+// retrieve
+// Description: Copies every website of a topic into all_matches, best
+//              rated first.
+// Input: topic - the topic, all_matches - room for all of its websites
+//        num_found - passed back: the number copied
+// Output: true if the topic has any websites, false if not
+bool MappedTable::retrieve(const char * topic, Website all_matches[],
+                           int & num_found) const
+{
+   num_found = 0;
+   uint32_t found = findTopic(topic);
+   if (found == NONE)
+   {
+      return false;
+   }
+   for (uint32_t entry = topics()[found].first; entry != NONE;
+        entry = entries()[entry].next)
+   {
+      CompactSite site;
+      siteAt(found, entry, site);
+      all_matches[num_found] = site.toWebsite();
+      num_found++;
+   }
+   return num_found > 0;
+}
+
+// topK
+// Description: Views of the k best rated websites of a topic, best first,
+//              pointing straight into the mapping. They are valid until
+//              the next write or close.
+// Input: topic, k - the most to pass back, top - room for k views
+//        num_found - passed back: the number of views filled in
+// Output: true if the topic has any websites, false if not
+bool MappedTable::topK(const char * topic, int k, CompactSite top[],
+                       int & num_found) const
+{
+   num_found = 0;
+   uint32_t found = findTopic(topic);
+   if (found == NONE)
+   {
+      return false;
+   }
+   for (uint32_t entry = topics()[found].first;
+        entry != NONE && num_found < k; entry = entries()[entry].next)
+   {
+      siteAt(found, entry, top[num_found]);
+      num_found++;
+   }
+   return num_found > 0;
+}
+
+// edit
+// Description: Gives a website a new review and rating, like
+//              CompactTable::edit: the summary and new review are appended
+//              to the text pool and the old ones become dead bytes.
+// Input: topic, url - the website, newReview, newRating
+// Output: true if the website was edited, false if it does not exist, the
+//         text pool is full or the file could not grow
+bool MappedTable::edit(const char * topic, const char * url,
+                       const char * newReview, int newRating)
+{
+   uint32_t found = findTopic(topic);
+   if (found == NONE)
+   {
+      return false;
+   }
+   uint32_t before = NONE;
+   uint32_t entry = findEntry(found, url, &before);
+   if (entry == NONE)
+   {
+      return false;
+   }
+   // copies, since growing the file may move the mapping they point into
+   string summary = text() + entries()[entry].text;
+   string review = newReview;
+   size_t bytes = summary.size() + review.size() + 2;
+   if (header()->regions[MAP_TEXT].bytes + bytes > UINT32_MAX)
+   {
+      return false;
+   }
+   markDirty();
+   if (!reserve(MAP_TEXT, bytes))
+   {
+      return false;
+   }
+   header()->deadBytes += textBytes(entry);
+   entries()[entry].text =
+      append(MAP_TEXT, summary.c_str(), summary.size()).offset;
+   append(MAP_TEXT, review.c_str(), review.size());
+   if (entries()[entry].rating != newRating)
+   {
+      if (before == NONE) // unlink, then link at the new rating
+      {
+         topics()[found].first = entries()[entry].next;
+      }
+      else
+      {
+         entries()[before].next = entries()[entry].next;
+      }
+      entries()[entry].rating = newRating;
+      linkSorted(found, entry);
+   }
+   return true;
+}
+
+// removeOneStar
+// Description: Removes every website with a rating of 1, like
+//              CompactTable::removeOneStar: entries go on the free list,
+//              strings become dead bytes, and once more than half of the
+//              pool bytes are dead the file is compacted.
+// Input: None
+// Output: true if something was removed, false if not
+bool MappedTable::removeOneStar()
+{
+   if (!base)
+   {
+      return false;
+   }
+   bool removed = false;
+   uint32_t topicCount = count(MAP_TOPICS);
+   for (uint32_t topic = 0; topic < topicCount; topic++)
+   {
+      uint32_t before = NONE;
+      uint32_t entry = topics()[topic].first;
+      while (entry != NONE)
+      {
+         uint32_t next = entries()[entry].next;
+         if (entries()[entry].rating == 1)
+         {
+            if (!removed)
+            {
+               markDirty();
+               removed = true;
+            }
+            if (before == NONE)
+            {
+               topics()[topic].first = next;
+            }
+            else
+            {
+               entries()[before].next = next;
+            }
+            header()->deadBytes += entries()[entry].url.length + 1 +
+                                   textBytes(entry);
+            entries()[entry].next = header()->freeEntry;
+            header()->freeEntry = entry;
+            header()->size--;
+         }
+         else
+         {
+            before = entry;
+         }
+         entry = next;
+      }
+   }
+   if (header()->deadBytes > (header()->regions[MAP_KEYS].bytes +
+                              header()->regions[MAP_TEXT].bytes) / 2)
+   {
+      compact();
+   }
+   return removed;
+}
+
+// compact
+// Description: Rewrites the file with only the live topics and websites,
+//              like CompactTable::compact, each region trimmed to its size
+//              (or MIN_REGION). The new regions are built in memory, copied
+//              over the old ones and the file is shrunk.
+// Input: None
+// Output: true if the file was rewritten, false if no file is open
+bool MappedTable::compact()
+{
+   if (!base)
+   {
+      return false;
+   }
+   vector<uint32_t> newBuckets(count(MAP_BUCKETS), NONE);
+   vector<CompactTopic> newTopics;
+   vector<CompactEntry> newEntries;
+   vector<char> newKeys;
+   vector<char> newText;
+   newEntries.reserve(header()->size);
+   uint32_t topicCount = count(MAP_TOPICS);
+   for (uint32_t topic = 0; topic < topicCount; topic++)
+   {
+      if (topics()[topic].first == NONE)
+      {
+         continue;
+      }
+      const char * name = keys() + topics()[topic].name.offset;
+      uint32_t bucket = bucketOf(name);
+      CompactTopic copy;
+      copy.name = { (uint32_t)newKeys.size(), topics()[topic].name.length };
+      newKeys.insert(newKeys.end(), name, name + copy.name.length + 1);
+      copy.next = newBuckets[bucket];
+      copy.first = NONE;
+      uint32_t last = NONE;
+      for (uint32_t entry = topics()[topic].first; entry != NONE;
+           entry = entries()[entry].next)
+      {
+         CompactEntry moved = entries()[entry];
+         const char * url = keys() + moved.url.offset;
+         const char * summary = text() + moved.text;
+         moved.next = NONE;
+         moved.url.offset = (uint32_t)newKeys.size();
+         newKeys.insert(newKeys.end(), url, url + moved.url.length + 1);
+         moved.text = (uint32_t)newText.size();
+         newText.insert(newText.end(), summary, summary + textBytes(entry));
+         uint32_t index = (uint32_t)newEntries.size();
+         newEntries.push_back(moved);
+         if (last == NONE)
+         {
+            copy.first = index;
+         }
+         else
+         {
+            newEntries[last].next = index;
+         }
+         last = index;
+      }
+      newBuckets[bucket] = (uint32_t)newTopics.size();
+      newTopics.push_back(copy);
+   }
+   markDirty();
+   const void * data[MAP_REGIONS] = { newBuckets.data(), newTopics.data(),
+      newEntries.data(), newKeys.data(), newText.data() };
+   const uint64_t bytes[MAP_REGIONS] = {
+      newBuckets.size() * sizeof(uint32_t),
+      newTopics.size() * sizeof(CompactTopic),
+      newEntries.size() * sizeof(CompactEntry), newKeys.size(),
+      newText.size() };
+   uint64_t offset = sizeof(MappedHeader);
+   for (int kind = 0; kind < MAP_REGIONS; kind++) // never past the old end
+   {
+      MappedRegion & region = header()->regions[kind];
+      region.offset = offset;
+      region.bytes = bytes[kind];
+      region.capacity = max(MIN_REGION, alignUp(bytes[kind]));
+      memcpy(base + offset, data[kind], bytes[kind]);
+      offset += region.capacity;
+   }
+   header()->freeEntry = NONE;
+   header()->deadBytes = 0;
+   if (resize(offset)) // else the file keeps its old length
+   {
+      header()->fileBytes = offset;
+   }
+   return true;
+}
+
+// loadFromFile
+// Description: Loads websites from a file in the input.txt format with
+//              RecordParser. Bad records are skipped and reported to cerr.
+// Input: filename - the name of the file to be loaded
+// Output: true if the file was read, false if it could not be opened
+bool MappedTable::loadFromFile(const char * filename)
+{
+   RecordParser parser;
+   if (!parser.parseFile(filename, [this](const Website & website)
+   {
+      insert(website);
+   }))
+   {
+      return false;
+   }
+   parser.reportErrors(cerr, filename);
+   return true;
+}
+
+// getSize
+// Description: Returns the number of websites, 0 if no file is open.
+int MappedTable::getSize() const
+{
+   return base ? (int)header()->size : 0;
+}
+
+// getCapacity
+// Description: Returns the number of buckets, 0 if no file is open.
+int MappedTable::getCapacity() const
+{
+   return base ? (int)count(MAP_BUCKETS) : 0;
+}
+
+// getTopicCount
+// Description: Returns the number of topics, including those whose
+//              websites have all been removed (until compact()).
+int MappedTable::getTopicCount() const
+{
+   return base ? (int)count(MAP_TOPICS) : 0;
+}
+
+// getFileBytes
+// Description: Returns the size of the file, 0 if no file is open.
+size_t MappedTable::getFileBytes() const
+{
+   return length;
+}
+
+// getDeadBytes
+// Description: Returns the pool bytes left behind by removed and edited
+//              websites, which compact() gives back.
+size_t MappedTable::getDeadBytes() const
+{
+   return base ? header()->deadBytes : 0;
+}
+
+// create
+// Description: Lays out an empty table in the open, empty file: every
+//              region MIN_REGION bytes, INIT_CAP empty buckets. It is
+//              checkpointed before it is used, so a file cut short while
+//              being made has no magic and is never opened.
+// Input: hashSeed - the hash key, 0 for TopicSumHash
+// Output: true if it was made, false if the file could not be sized or
+//         mapped
+bool MappedTable::create(uint64_t hashSeed)
+{
+   uint64_t fileBytes = sizeof(MappedHeader) + MAP_REGIONS * MIN_REGION;
+   if (!resize(fileBytes))
+   {
+      error = string("cannot make the file: ") + strerror(errno);
+      return false;
+   }
+   MappedHeader * made = header(); // the new file is all zeros
+   memcpy(made->magic, MAPPED_MAGIC, sizeof(MAPPED_MAGIC));
+   made->byteOrder = MAPPED_BYTE_ORDER;
+   made->version = MAPPED_VERSION;
+   made->state = MAPPED_DIRTY;
+   made->freeEntry = NONE;
+   made->hashSeed = hashSeed;
+   made->fileBytes = fileBytes;
+   for (int kind = 0; kind < MAP_REGIONS; kind++)
+   {
+      made->regions[kind].offset = sizeof(MappedHeader) + kind * MIN_REGION;
+      made->regions[kind].capacity = MIN_REGION;
+   }
+   made->regions[MAP_BUCKETS].bytes = INIT_CAP * sizeof(uint32_t);
+   memset(buckets(), 0xFF, INIT_CAP * sizeof(uint32_t)); // all NONE
+   if (!checkpoint())
+   {
+      error = string("cannot write the file: ") + strerror(errno);
+      return false;
+   }
+   return true;
+}
+
+// release
+// Description: Unmaps and closes the file, which drops its lock, without a
+//              checkpoint.
+void MappedTable::release()
+{
+   if (base)
+   {
+      munmap(base, length);
+   }
+   if (fd >= 0)
+   {
+      ::close(fd);
+   }
+   base = nullptr;
+   length = 0;
+   fd = -1;
+}
+
+// validate
+// Description: Checks the header of a mapped file: magic, byte order,
+//              version, size, that it is clean, and that the regions are
+//              aligned, in order, inside the file and whole records, and
+//              the counts and free list fit them. The records themselves
+//              are not walked; a clean header vouches for them.
+// Input: None
+// Output: true if the file can be used, false if not (error says why)
+bool MappedTable::validate()
+{
+   const MappedHeader * checked = header();
+   if (length < sizeof(MappedHeader) ||
+       memcmp(checked->magic, MAPPED_MAGIC, sizeof(MAPPED_MAGIC)) != 0)
+   {
+      error = "not a mapped table file";
+      return false;
+   }
+   if (checked->byteOrder != MAPPED_BYTE_ORDER ||
+       checked->version != MAPPED_VERSION)
+   {
+      error = "written with another byte order or version";
+      return false;
+   }
+   if (checked->state != MAPPED_CLEAN)
+   {
+      error = "not checkpointed after its last write, so it may be half "
+              "written";
+      return false;
+   }
+   uint64_t end = sizeof(MappedHeader);
+   for (int kind = 0; kind < MAP_REGIONS; kind++)
+   {
+      const MappedRegion & region = checked->regions[kind];
+      if (region.offset % MAPPED_ALIGN != 0 || region.offset < end ||
+          region.offset > length || region.capacity > length - region.offset ||
+          region.bytes > region.capacity ||
+          region.bytes % RECORD_BYTES[kind] != 0 ||
+          region.bytes / RECORD_BYTES[kind] > UINT32_MAX)
+      {
+         error = "regions do not fit the file";
+         return false;
+      }
+      end = region.offset + region.capacity;
+   }
+   if (checked->fileBytes != length || count(MAP_BUCKETS) == 0 ||
+       checked->size > count(MAP_ENTRIES) ||
+       (checked->freeEntry != NONE &&
+        checked->freeEntry >= count(MAP_ENTRIES)))
+   {
+      error = "header does not match the file";
+      return false;
+   }
+   return true;
+}
+
+// resize
+// Description: Sets the file to bytes long and maps all of it, moving the
+//              mapping if it has to. On failure the mapping stays as it
+//              was, and so does the file unless it cannot even be cut back
+//              (open() then refuses it, as it no longer matches its
+//              header).
+// Input: bytes - the new size
+// Output: true if it was resized, false if not
+bool MappedTable::resize(size_t bytes)
+{
+   if (ftruncate(fd, bytes) != 0)
+   {
+      return false;
+   }
+   void * mapping = base ? mremap(base, length, bytes, MREMAP_MAYMOVE) :
+                           mmap(nullptr, bytes, PROT_READ | PROT_WRITE,
+                                MAP_SHARED, fd, 0);
+   if (mapping == MAP_FAILED)
+   {
+      if (ftruncate(fd, length) != 0)
+      {
+         error = string("cannot cut the file back: ") + strerror(errno);
+      }
+      return false;
+   }
+   base = (char *)mapping;
+   length = bytes;
+   return true;
+}
+
+// reserve
+// Description: Makes sure bytes more fit in a region, doubling it (or more)
+//              if they do not.
+// Input: kind - the region, bytes - the bytes to be appended
+// Output: true if they fit, false if the file could not grow
+bool MappedTable::reserve(MappedRegionKind kind, uint64_t bytes)
+{
+   const MappedRegion & region = header()->regions[kind];
+   if (bytes <= region.capacity - region.bytes)
+   {
+      return true;
+   }
+   uint64_t capacities[MAP_REGIONS];
+   for (int i = 0; i < MAP_REGIONS; i++)
+   {
+      capacities[i] = header()->regions[i].capacity;
+   }
+   capacities[kind] = max(region.capacity * 2, alignUp(region.bytes + bytes));
+   return relayout(capacities);
+}
+
+// relayout
+// Description: Grows the file to fit regions of the new capacities, none
+//              smaller than now, and moves each region up to its new
+//              offset, last region first so none is overwritten before it
+//              has moved.
+// Input: capacities - the new capacity of each region
+// Output: true if the regions moved, false if the file could not grow
+bool MappedTable::relayout(const uint64_t capacities[MAP_REGIONS])
+{
+   MappedRegion regions[MAP_REGIONS];
+   uint64_t offset = sizeof(MappedHeader);
+   for (int kind = 0; kind < MAP_REGIONS; kind++)
+   {
+      regions[kind] = header()->regions[kind];
+      regions[kind].offset = offset;
+      regions[kind].capacity = capacities[kind];
+      offset += capacities[kind];
+   }
+   if (!resize(offset))
+   {
+      return false;
+   }
+   for (int kind = MAP_REGIONS - 1; kind >= 0; kind--)
+   {
+      memmove(base + regions[kind].offset,
+              base + header()->regions[kind].offset, regions[kind].bytes);
+   }
+   memcpy(header()->regions, regions, sizeof(regions));
+   header()->fileBytes = offset;
+   return true;
+}
+
+// markDirty
+// Description: Marks the header dirty and writes it to the file before the
+//              first write after a checkpoint, so a crash before the next
+//              checkpoint leaves a file open() refuses rather than one it
+//              would trust half written.
+// Input: None
+// Output: None
+void MappedTable::markDirty()
+{
+   if (header()->state != MAPPED_DIRTY)
+   {
+      header()->state = MAPPED_DIRTY;
+      msync(base, sizeof(MappedHeader), MS_SYNC);
+   }
+}
+
+// header, buckets, topics, entries, keys, text
+// Description: Where the header and each region are in the mapping now.
+MappedHeader * MappedTable::header() const
+{
+   return (MappedHeader *)base;
+}
+
+uint32_t * MappedTable::buckets() const
+{
+   return (uint32_t *)(base + header()->regions[MAP_BUCKETS].offset);
+}
+
+CompactTopic * MappedTable::topics() const
+{
+   return (CompactTopic *)(base + header()->regions[MAP_TOPICS].offset);
+}
+
+CompactEntry * MappedTable::entries() const
+{
+   return (CompactEntry *)(base + header()->regions[MAP_ENTRIES].offset);
+}
+
+char * MappedTable::keys() const
+{
+   return base + header()->regions[MAP_KEYS].offset;
+}
+
+char * MappedTable::text() const
+{
+   return base + header()->regions[MAP_TEXT].offset;
+}
+
+// count
+// Description: Returns the records used in a region (bytes for a pool).
+uint32_t MappedTable::count(MappedRegionKind kind) const
+{
+   return (uint32_t)(header()->regions[kind].bytes / RECORD_BYTES[kind]);
+}
+
+// bucketOf
+// Description: Hashes a topic like CompactTable does, with the file's seed.
+// Input: topic - the topic
+// Output: the bucket index
+uint32_t MappedTable::bucketOf(const char * topic) const
+{
+   uint64_t hashSeed = header()->hashSeed;
+   if (hashSeed)
+   {
+      return (uint32_t)growth.index(KeyedStringHash(hashSeed,
+                                                    ~hashSeed)(topic));
+   }
+   return (uint32_t)growth.index(TopicSumHash()(topic));
+}
+
+// findTopic
+// Description: Walks the topic's bucket chain for it.
+// Input: topic - the topic
+// Output: its index in topics, NONE if it is not there or no file is open
+uint32_t MappedTable::findTopic(const char * topic) const
+{
+   if (!base)
+   {
+      return NONE;
+   }
+   size_t length = strlen(topic);
+   uint32_t curr = buckets()[bucketOf(topic)];
+   while (curr != NONE && !equals(topics()[curr].name, topic, length))
+   {
+      curr = topics()[curr].next;
+   }
+   return curr;
+}
+
+// findEntry
+// Description: Walks a topic's websites for a URL.
+// Input: topic - its index, url - the URL
+//        before - if not nullptr, passed back: the entry before the one
+//                 found, NONE if it is the topic's first
+// Output: the entry, NONE if the topic has no website with that URL
+uint32_t MappedTable::findEntry(uint32_t topic, const char * url,
+                                uint32_t * before) const
+{
+   size_t length = strlen(url);
+   uint32_t previous = NONE;
+   uint32_t curr = topics()[topic].first;
+   while (curr != NONE && !equals(entries()[curr].url, url, length))
+   {
+      previous = curr;
+      curr = entries()[curr].next;
+   }
+   if (before)
+   {
+      *before = previous;
+   }
+   return curr;
+}
+
+// linkSorted
+// Description: Links an entry into its topic's list after every website
+//              rated the same or higher.
+// Input: topic - its index, entry - the entry, not linked yet
+// Output: None
+void MappedTable::linkSorted(uint32_t topic, uint32_t entry)
+{
+   CompactEntry * all = entries();
+   int rating = all[entry].rating;
+   uint32_t previous = NONE;
+   uint32_t curr = topics()[topic].first;
+   while (curr != NONE && all[curr].rating >= rating)
+   {
+      previous = curr;
+      curr = all[curr].next;
+   }
+   all[entry].next = curr;
+   if (previous == NONE)
+   {
+      topics()[topic].first = entry;
+   }
+   else
+   {
+      all[previous].next = entry;
+   }
+}
+
+// grow
+// Description: Moves to the next PrimeGrowth capacity and relinks every
+//              topic into its new bucket. If the file cannot grow the
+//              buckets stay as they are, only with longer chains.
+// Input: None
+// Output: None
+void MappedTable::grow()
+{
+   uint32_t old = count(MAP_BUCKETS);
+   uint32_t capacity = (uint32_t)PrimeGrowth::nextCapacity(old);
+   if (capacity <= old ||
+       !reserve(MAP_BUCKETS, (uint64_t)(capacity - old) * sizeof(uint32_t)))
+   {
+      return;
+   }
+   header()->regions[MAP_BUCKETS].bytes = capacity * sizeof(uint32_t);
+   growth.reset(capacity);
+   memset(buckets(), 0xFF, capacity * sizeof(uint32_t)); // all NONE
+   uint32_t topicCount = count(MAP_TOPICS);
+   for (uint32_t topic = 0; topic < topicCount; topic++)
+   {
+      uint32_t bucket = bucketOf(keys() + topics()[topic].name.offset);
+      topics()[topic].next = buckets()[bucket];
+      buckets()[bucket] = topic;
+   }
+}
+
+// siteAt
+// Description: Points a view at one website in the mapping.
+// Input: topic, entry - the website's indices
+//        site - passed back: the view
+// Output: None
+void MappedTable::siteAt(uint32_t topic, uint32_t entry,
+                         CompactSite & site) const
+{
+   site.topic = keys() + topics()[topic].name.offset;
+   site.url = keys() + entries()[entry].url.offset;
+   site.summary = text() + entries()[entry].text;
+   site.rating = entries()[entry].rating;
+}
+
+// textBytes
+// Description: Bytes an entry's summary and review take in the text pool.
+// Input: entry - the entry
+// Output: the bytes, both '\0's included
+size_t MappedTable::textBytes(uint32_t entry) const
+{
+   const char * summary = text() + entries()[entry].text;
+   size_t summaryBytes = strlen(summary) + 1;
+   return summaryBytes + strlen(summary + summaryBytes) + 1;
+}
+
+// append
+// Description: Copies a string and a '\0' to the end of a pool, which must
+//              already have room for them (see reserve).
+// Input: pool - MAP_KEYS or MAP_TEXT, chars - the characters,
+//        length - how many
+// Output: where it went
+CompactString MappedTable::append(MappedRegionKind pool, const char * chars,
+                                  size_t length)
+{
+   MappedRegion & region = header()->regions[pool];
+   CompactString added = { (uint32_t)region.bytes, (uint32_t)length };
+   char * at = base + region.offset + region.bytes;
+   memcpy(at, chars, length);
+   at[length] = '\0';
+   region.bytes += length + 1;
+   return added;
+}
+
+// equals
+// Description: Compares a key pool string with another string of known
+//              length, lengths first.
+// Input: stored - the pool string, other - the string, length - its
+// Output: true if they hold the same characters
+bool MappedTable::equals(CompactString stored, const char * other,
+                         size_t length) const
+{
+   return stored.length == length &&
+          memcmp(keys() + stored.offset, other, length) == 0;
+}
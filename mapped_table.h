@@ -0,0 +1,171 @@
+/******************************************************************************
+# Program Desc.:      This program is a website bookmarking program. The program
+#                     implements a hash table using chaining (pointer array of
+#                     linked lists) to store website information.
+# File:               mapped_table.h
+# File Description:   MappedTable, a bookmark table that lives in a memory
+#                     mapped file. It keeps CompactTable's layout (buckets,
+#                     CompactTopic and CompactEntry records linked by 32 bit
+#                     index, and two string pools referenced by 32 bit
+#                     offset), which has no pointers in it, so the records
+#                     are read and written in place in the mapping: the page
+#                     cache holds the data, opening a table is a map and a
+#                     header check whatever its size, and collections larger
+#                     than RAM are paged in and out by the OS.
+#
+#                     File layout (host byte order, which the byte order
+#                     mark records; offsets are from the start of the file,
+#                     every region starts on a 64 byte boundary):
+#                        MappedHeader
+#                        buckets   uint32[], first topic of each chain
+#                        topics    CompactTopic[]
+#                        entries   CompactEntry[]
+#                        keys      char[], '\0' terminated topics and URLs
+#                        text      char[], summary then review of each
+#                                  website, both '\0' terminated
+#                     Each region has room past its used bytes; a region
+#                     that runs out doubles, and the file grows with it (the
+#                     regions after it move up).
+#
+#                     Consistency: the header's state is MAPPED_CLEAN only
+#                     while the file matches the last checkpoint. The first
+#                     write after a checkpoint sets MAPPED_DIRTY and syncs
+#                     the header before any record changes; checkpoint()
+#                     syncs every page and then the header, set back to
+#                     MAPPED_CLEAN. open() refuses a dirty file, since a
+#                     crash may have left it half written. close() and the
+#                     destructor checkpoint. One MappedTable at a time may
+#                     have a file open (flock). Not thread safe.
+# Input:              Mapped table file
+# Output:             Mapped table file
+#******************************************************************************/
+#ifndef MAPPED_TABLE_H
+#define MAPPED_TABLE_H
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+#include "website.h"
+#include "basic_table.h"
+#include "compact_table.h"
+
+using namespace std;
+
+const char MAPPED_MAGIC[8] = { 'B', 'M', 'K', 'M', 'A', 'P', 'T', '\0' };
+const uint32_t MAPPED_BYTE_ORDER = 0x01020304; // reads back swapped if not
+const uint32_t MAPPED_VERSION = 1;
+const uint32_t MAPPED_CLEAN = 1; // the file is the last checkpoint
+const uint32_t MAPPED_DIRTY = 2; // written since the last checkpoint
+
+// MappedRegionKind
+// The regions of a mapped table file, in file order.
+enum MappedRegionKind
+{
+   MAP_BUCKETS,
+   MAP_TOPICS,
+   MAP_ENTRIES,
+   MAP_KEYS,
+   MAP_TEXT,
+   MAP_REGIONS
+};
+
+// MappedRegion
+// Where a region is and how much of it is used.
+struct MappedRegion
+{
+   uint64_t offset; // from the start of the file
+   uint64_t bytes; // used
+   uint64_t capacity; // room before the next region
+};
+
+// MappedHeader
+// First 256 bytes of a mapped table file.
+struct MappedHeader
+{
+   char magic[8]; // MAPPED_MAGIC
+   uint32_t byteOrder; // MAPPED_BYTE_ORDER as written
+   uint32_t version; // MAPPED_VERSION
+   uint32_t state; // MAPPED_CLEAN or MAPPED_DIRTY
+   uint32_t freeEntry; // first removed entry, UINT32_MAX if none
+   uint64_t hashSeed; // 0 for TopicSumHash, else KeyedStringHash key
+   uint64_t fileBytes; // size of the whole file
+   uint64_t size; // websites
+   uint64_t deadBytes; // pool bytes of removed or edited websites
+   MappedRegion regions[MAP_REGIONS];
+   uint64_t reserved[10]; // 0
+};
+static_assert(sizeof(MappedHeader) == 256, "mapped header layout");
+
+class MappedTable
+{
+public:
+   MappedTable(); // nothing open
+   ~MappedTable(); // checkpoints and unmaps the file
+   MappedTable(const MappedTable &) = delete;
+
+   bool open(const char * filename,
+             uint64_t hashSeed = 0); // map a table file, made if missing
+   bool checkpoint(); // make the file on disk match the table, then clean
+   void close(); // checkpoint and unmap
+   bool isOpen() const;
+   const char * getError() const; // why the last open failed
+
+   bool insert(const Website& website); // add website to the table
+   bool retrieve(const char * topic, Website all_matches[],
+                 int& num_found) const; // copies of a topic's websites
+   bool topK(const char * topic, int k, CompactSite top[],
+             int& num_found) const; // k best rated websites for a topic
+   bool edit(const char * topic, const char * url, const char * newReview,
+             int newRating); // edit a website review and rating
+   bool removeOneStar(); // remove all websites with a rating of 1
+   bool compact(); // rewrite without removed websites and old strings
+   bool loadFromFile(const char * filename); // load test data from file
+   int getSize() const; // number of websites
+   int getCapacity() const; // number of buckets
+   int getTopicCount() const; // topics, including emptied ones
+   size_t getFileBytes() const; // size of the file
+   size_t getDeadBytes() const; // pool bytes of removed or edited websites
+
+private:
+   const static uint32_t NONE = UINT32_MAX; // no topic or entry
+   const static int INIT_CAP = 11; // buckets of a new file
+   const static uint64_t MIN_REGION = 4096; // bytes of a new region
+
+   char * base; // the mapping, nullptr if nothing is open
+   size_t length; // bytes mapped, the file's size
+   int fd; // the open file, holding its lock, -1 if none
+   PrimeGrowth growth; // fast modulo constants for the capacity
+   string error;
+
+   bool create(uint64_t hashSeed); // lay out an empty table in the file
+   void release(); // unmap and close the file, no checkpoint
+   bool validate(); // check the header and regions against the file
+   bool resize(size_t bytes); // grow or shrink the file and the mapping
+   bool reserve(MappedRegionKind kind, uint64_t bytes); // room to append
+   bool relayout(const uint64_t capacities[MAP_REGIONS]); // move regions
+   void markDirty(); // before the first write after a checkpoint
+
+   MappedHeader * header() const;
+   uint32_t * buckets() const;
+   CompactTopic * topics() const;
+   CompactEntry * entries() const;
+   char * keys() const;
+   char * text() const;
+   uint32_t count(MappedRegionKind kind) const; // records used in a region
+
+   uint32_t bucketOf(const char * topic) const; // bucket index
+   uint32_t findTopic(const char * topic) const; // topic index or NONE
+   uint32_t findEntry(uint32_t topic, const char * url,
+                      uint32_t * before) const; // entry and its previous
+   void linkSorted(uint32_t topic, uint32_t entry); // by rating
+   void grow(); // next capacity, rehash the topics
+   void siteAt(uint32_t topic, uint32_t entry,
+               CompactSite & site) const; // view of one website
+   size_t textBytes(uint32_t entry) const; // summary and review, '\0's
+   CompactString append(MappedRegionKind pool, const char * chars,
+                        size_t length); // copy in with a '\0', reserved
+   bool equals(CompactString stored, const char * other,
+               size_t length) const; // same chars as a key
+};
+
+#endif
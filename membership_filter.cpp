@@ -0,0 +1,145 @@
+/******************************************************************************
+# Program Desc.:      This program is a website bookmarking program. The program
+#                     implements a hash table using chaining (pointer array of
+#                     linked lists) to store website information.
+# File:               membership_filter.cpp
+# File Description:   Implementation file for the MembershipFilter class.
+# Input:              None
+# Output:             None
+#******************************************************************************/
+#include "membership_filter.h"
+
+#include <cstring>
+#include <atomic>
+
+// Constructor
+// Description: Allocates SLOTS_PER_KEY counters per expected key, rounded up
+//              to whole blocks. With 10 counters and 4 probes per key about
+//              3% of absent keys get a "maybe". More keys than expected still
+//              works, the false "maybe" rate just goes up.
+// Input: expectedKeys - number of distinct keys the filter should hold
+MembershipFilter::MembershipFilter(int expectedKeys)
+{
+   if (expectedKeys < 1)
+   {
+      expectedKeys = 1;
+   }
+   long long slots = (long long)expectedKeys * SLOTS_PER_KEY;
+   blocks.resize((size_t)((slots + 63) / 64));
+   clear();
+}
+
+// hash
+// Description: FNV-1a over the key with the seed mixed into the start value,
+//              then a final mix so the high bits (which pick the block) and
+//              low bits (which pick the counters) are both well spread. Use
+//              different seeds to keep different kinds of keys apart in one
+//              filter.
+// Input: key - the key, seed - the kind of key
+// Output: the hash to pass to add, remove and mayContain
+uint64_t MembershipFilter::hash(const char * key, uint64_t seed)
+{
+   uint64_t hash = UINT64_C(14695981039346656037) ^ seed;
+   for (int i = 0; key[i] != '\0'; i++)
+   {
+      hash ^= (unsigned char)key[i];
+      hash *= UINT64_C(1099511628211);
+   }
+   hash ^= hash >> 33;
+   hash *= UINT64_C(0xFF51AFD7ED558CCD);
+   hash ^= hash >> 33;
+   return hash;
+}
+
+// blockOf
+// Description: Maps the high 32 bits of the hash onto the blocks with a
+//              multiply and shift instead of a modulo.
+// Input: hash - hash of the key
+// Output: the block
+const MembershipFilter::Block & MembershipFilter::blockOf(uint64_t hash) const
+{
+   return blocks[((hash >> 32) * blocks.size()) >> 32];
+}
+
+MembershipFilter::Block & MembershipFilter::blockOf(uint64_t hash)
+{
+   return blocks[((hash >> 32) * blocks.size()) >> 32];
+}
+
+// add
+// Description: Bumps the key's PROBES counters, each picked by 6 bits of the
+//              low half of the hash. A counter that reaches STUCK stays there,
+//              since it no longer knows how many keys it counts. Counters
+//              are written with relaxed atomic stores, so lock free readers
+//              can call mayContain while the one writer adds and removes.
+// Input: hash - hash of the key
+// Output: None
+void MembershipFilter::add(uint64_t hash)
+{
+   Block & block = blockOf(hash);
+   for (int i = 0; i < PROBES; i++)
+   {
+      atomic_ref<uint8_t> counter(block.counters[(hash >> (6 * i)) & 63]);
+      uint8_t value = counter.load(memory_order_relaxed);
+      if (value != STUCK)
+      {
+         counter.store(value + 1, memory_order_relaxed);
+      }
+   }
+}
+
+// remove
+// Description: Undoes one add of the key. Removing a key that was never
+//              added would make other keys look absent, so only remove what
+//              was added.
+// Input: hash - hash of the key
+// Output: None
+void MembershipFilter::remove(uint64_t hash)
+{
+   Block & block = blockOf(hash);
+   for (int i = 0; i < PROBES; i++)
+   {
+      atomic_ref<uint8_t> counter(block.counters[(hash >> (6 * i)) & 63]);
+      uint8_t value = counter.load(memory_order_relaxed);
+      if (value != STUCK && value != 0)
+      {
+         counter.store(value - 1, memory_order_relaxed);
+      }
+   }
+}
+
+// mayContain
+// Description: Checks the key's counters, all in one cache line.
+// Input: hash - hash of the key
+// Output: false if the key is definitely not in the filter, true if it may be
+bool MembershipFilter::mayContain(uint64_t hash) const
+{
+   const Block & block = blockOf(hash);
+   for (int i = 0; i < PROBES; i++)
+   {
+      uint8_t & counter = const_cast<uint8_t &>(
+         block.counters[(hash >> (6 * i)) & 63]);
+      if (atomic_ref<uint8_t>(counter).load(memory_order_relaxed) == 0)
+      {
+         return false;
+      }
+   }
+   return true;
+}
+
+// clear
+// Description: Sets every counter back to 0.
+void MembershipFilter::clear()
+{
+   if (!blocks.empty())
+   {
+      memset(blocks.data(), 0, blocks.size() * sizeof(Block));
+   }
+}
+
+// getBlockCount
+// Description: Returns the number of 64 byte blocks.
+int MembershipFilter::getBlockCount() const
+{
+   return (int)blocks.size();
+}
@@ -0,0 +1,50 @@
+/******************************************************************************
+# Program Desc.:      This program is a website bookmarking program. The program
+#                     implements a hash table using chaining (pointer array of
+#                     linked lists) to store website information.
+# File:               membership_filter.h
+# File Description:   Header file for the MembershipFilter class, a blocked
+#                     counting Bloom filter. Every key lives in one 64 byte
+#                     block (one cache line) of 8 bit counters, so a lookup
+#                     touches one line. Counters instead of bits let keys be
+#                     removed again. "No" answers are always right; "maybe"
+#                     answers are wrong a few percent of the time.
+# Input:              None
+# Output:             None
+#******************************************************************************/
+#ifndef MEMBERSHIP_FILTER_H
+#define MEMBERSHIP_FILTER_H
+#include <cstdint>
+#include <vector>
+
+using namespace std;
+
+class MembershipFilter
+{
+public:
+   explicit MembershipFilter(int expectedKeys); // sized for expectedKeys
+
+   void add(uint64_t hash); // add one copy of a key
+   void remove(uint64_t hash); // remove one copy of a key added before
+   bool mayContain(uint64_t hash) const; // false means definitely absent
+   void clear(); // forget every key
+   int getBlockCount() const; // number of 64 byte blocks
+
+   static uint64_t hash(const char * key, uint64_t seed); // hash a C string
+
+private:
+   const static int SLOTS_PER_KEY = 10; // counters per expected key
+   const static int PROBES = 4; // counters set per key
+   const static uint8_t STUCK = 255; // saturated, never decremented again
+
+   struct alignas(64) Block // one cache line of counters
+   {
+      uint8_t counters[64];
+   };
+   vector<Block> blocks;
+
+   const Block & blockOf(uint64_t hash) const; // block a key lives in
+   Block & blockOf(uint64_t hash);
+};
+
+#endif
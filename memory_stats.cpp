@@ -0,0 +1,238 @@
+/******************************************************************************
+# Program Desc.:      This program is a website bookmarking program. The program
+#                     implements a hash table using chaining (pointer array of
+#                     linked lists) to store website information.
+# File:               memory_stats.cpp
+# File Description:   Implementation of the memory hooks, AllocationCounter
+#                     and MemoryReport.
+# Input:              None
+# Output:             None
+#******************************************************************************/
+#include "memory_stats.h"
+
+#include <iomanip>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+const char * const MEMORY_KIND_NAMES[MEM_KINDS] = { "index", "nodes", "keys",
+                                                    "text" };
+
+thread_local MemoryHook * currentMemoryHook = nullptr;
+
+// setMemoryHook
+// Description: Installs a hook for the calling thread. Work done on other
+//              threads (a WorkStealingPool, shard threads) is reported to
+//              their own hooks.
+// Input: hook - the hook, nullptr for none
+// Output: the hook that was installed before
+MemoryHook * setMemoryHook(MemoryHook * hook)
+{
+   MemoryHook * previous = currentMemoryHook;
+   currentMemoryHook = hook;
+   return previous;
+}
+
+// usableSize
+// Description: Bytes the allocator really reserved for a block, which is
+//              at least what was asked for. Falls back to the requested size
+//              where the C library cannot tell.
+// Input: block - pointer returned by new, requested - bytes asked for
+// Output: the usable size
+size_t usableSize(const void * block, size_t requested)
+{
+#ifdef __GLIBC__
+   return block ? malloc_usable_size(const_cast<void *>(block)) : 0;
+#else
+   return block ? requested : 0;
+#endif
+}
+
+// ALLOCATION COUNTER
+
+// Constructor
+AllocationCounter::AllocationCounter()
+{
+   reset();
+}
+
+// allocated
+// Description: Counts one block of bytes of a kind.
+void AllocationCounter::allocated(MemoryKind kind, size_t bytes)
+{
+   allocations[kind]++;
+   bytesAllocated[kind] += bytes;
+}
+
+// freed
+// Description: Counts one freed block of bytes of a kind.
+void AllocationCounter::freed(MemoryKind kind, size_t bytes)
+{
+   frees[kind]++;
+   bytesFreed[kind] += bytes;
+}
+
+// reset
+// Description: Sets every count back to 0.
+void AllocationCounter::reset()
+{
+   for (int i = 0; i < MEM_KINDS; i++)
+   {
+      allocations[i] = 0;
+      frees[i] = 0;
+      bytesAllocated[i] = 0;
+      bytesFreed[i] = 0;
+   }
+}
+
+// getAllocations
+// Description: Returns the blocks allocated of one kind.
+long long AllocationCounter::getAllocations(MemoryKind kind) const
+{
+   return allocations[kind];
+}
+
+// getFrees
+// Description: Returns the blocks freed of one kind.
+long long AllocationCounter::getFrees(MemoryKind kind) const
+{
+   return frees[kind];
+}
+
+// getAllocations (every kind)
+// Description: Returns the blocks allocated of every kind.
+long long AllocationCounter::getAllocations() const
+{
+   long long total = 0;
+   for (int i = 0; i < MEM_KINDS; i++)
+   {
+      total += allocations[i];
+   }
+   return total;
+}
+
+// getFrees (every kind)
+// Description: Returns the blocks freed of every kind.
+long long AllocationCounter::getFrees() const
+{
+   long long total = 0;
+   for (int i = 0; i < MEM_KINDS; i++)
+   {
+      total += frees[i];
+   }
+   return total;
+}
+
+// getBytesAllocated
+// Description: Returns the bytes allocated of every kind.
+long long AllocationCounter::getBytesAllocated() const
+{
+   long long total = 0;
+   for (int i = 0; i < MEM_KINDS; i++)
+   {
+      total += bytesAllocated[i];
+   }
+   return total;
+}
+
+// getBytesFreed
+// Description: Returns the bytes freed of every kind.
+long long AllocationCounter::getBytesFreed() const
+{
+   long long total = 0;
+   for (int i = 0; i < MEM_KINDS; i++)
+   {
+      total += bytesFreed[i];
+   }
+   return total;
+}
+
+// SCOPED MEMORY HOOK
+
+// Constructor
+// Description: Installs the hook on this thread.
+ScopedMemoryHook::ScopedMemoryHook(MemoryHook * hook)
+{
+   previous = setMemoryHook(hook);
+}
+
+// Destructor
+// Description: Puts back the hook that was installed before.
+ScopedMemoryHook::~ScopedMemoryHook()
+{
+   setMemoryHook(previous);
+}
+
+// MEMORY REPORT
+
+// totalRequested
+// Description: Returns the bytes asked for, over every kind.
+size_t MemoryReport::totalRequested() const
+{
+   size_t total = 0;
+   for (int i = 0; i < MEM_KINDS; i++)
+   {
+      total += requested[i];
+   }
+   return total;
+}
+
+// totalUsable
+// Description: Returns the bytes the allocator gave, over every kind.
+size_t MemoryReport::totalUsable() const
+{
+   size_t total = 0;
+   for (int i = 0; i < MEM_KINDS; i++)
+   {
+      total += usable[i];
+   }
+   return total;
+}
+
+// bytesPerEntry
+// Description: Returns the usable bytes, plus the filter, per website.
+double MemoryReport::bytesPerEntry() const
+{
+   return entries ? (double)(totalUsable() + filterBytes) / entries : 0;
+}
+
+// slack
+// Description: Returns the share of the usable bytes that were not asked
+//              for: rounding up to the allocator's size classes. Many small
+//              blocks (like one per string) push it up.
+double MemoryReport::slack() const
+{
+   size_t total = totalUsable();
+   return total ? (double)(total - totalRequested()) / total : 0;
+}
+
+// ostream operator overload
+// Description: Writes the report as a small table, one line per kind. The
+//              stream's flags and precision are put back afterwards.
+// Input: out, report
+// Output: out
+ostream & operator<<(ostream & out, const MemoryReport & report)
+{
+   ios::fmtflags flags = out.flags();
+   streamsize precision = out.precision();
+   out << "kind        requested       usable" << '\n';
+   for (int i = 0; i < MEM_KINDS; i++)
+   {
+      out << left << setw(8) << MEMORY_KIND_NAMES[i] << right << setw(13)
+          << report.requested[i] << setw(13) << report.usable[i] << '\n';
+   }
+   out << left << setw(8) << "total" << right << setw(13)
+       << report.totalRequested() << setw(13) << report.totalUsable() << '\n'
+       << "filter bytes: " << report.filterBytes << '\n'
+       << "cached topics: " << report.cachedTopics << '\n'
+       << "heap blocks: " << report.blocks << '\n'
+       << "entries: " << report.entries << " (" << report.sharedEntries
+       << " shared with snapshots)" << '\n'
+       << "bytes per entry: " << fixed << setprecision(1)
+       << report.bytesPerEntry() << '\n'
+       << "allocator slack: " << setprecision(1) << report.slack() * 100
+       << "%" << '\n';
+   out.flags(flags);
+   out.precision(precision);
+   return out;
+}
@@ -0,0 +1,127 @@
+/******************************************************************************
+# Program Desc.:      This program is a website bookmarking program. The program
+#                     implements a hash table using chaining (pointer array of
+#                     linked lists) to store website information.
+# File:               memory_stats.h
+# File Description:   Memory accounting. Every heap block the table and its
+#                     websites allocate or free is reported, by kind, to the
+#                     calling thread's MemoryHook if one is installed (one
+#                     branch when none is). AllocationCounter is a hook that
+#                     counts them, so allocations per operation can be
+#                     measured and budgeted. MemoryReport is what
+#                     Table::memoryReport() returns: bytes by kind, bytes
+#                     per entry and allocator slack.
+# Input:              None
+# Output:             None
+#******************************************************************************/
+#ifndef MEMORY_STATS_H
+#define MEMORY_STATS_H
+#include <iostream>
+#include <cstddef>
+
+using namespace std;
+
+// MemoryKind
+// What a heap block holds.
+enum MemoryKind
+{
+   MEM_INDEX, // bucket arrays
+   MEM_NODES, // chain nodes and the Website objects they own
+   MEM_KEYS, // topic and URL strings
+   MEM_TEXT, // summary and review strings (cold: only read for display)
+   MEM_KINDS
+};
+extern const char * const MEMORY_KIND_NAMES[MEM_KINDS];
+
+// MemoryHook
+// Told about every block allocated or freed on the thread it is installed
+// on. Sizes are the bytes asked for.
+class MemoryHook
+{
+public:
+   virtual ~MemoryHook() {}
+   virtual void allocated(MemoryKind kind, size_t bytes) = 0;
+   virtual void freed(MemoryKind kind, size_t bytes) = 0;
+};
+
+extern thread_local MemoryHook * currentMemoryHook; // nullptr if none
+
+MemoryHook * setMemoryHook(MemoryHook * hook); // install, returns the old one
+
+// memoryAllocated / memoryFreed
+// Called next to every new and delete of table memory.
+inline void memoryAllocated(MemoryKind kind, size_t bytes)
+{
+   if (currentMemoryHook)
+   {
+      currentMemoryHook->allocated(kind, bytes);
+   }
+}
+
+inline void memoryFreed(MemoryKind kind, size_t bytes)
+{
+   if (currentMemoryHook)
+   {
+      currentMemoryHook->freed(kind, bytes);
+   }
+}
+
+// AllocationCounter
+// Hook that counts blocks and bytes allocated and freed, by kind.
+class AllocationCounter : public MemoryHook
+{
+public:
+   AllocationCounter();
+   void allocated(MemoryKind kind, size_t bytes);
+   void freed(MemoryKind kind, size_t bytes);
+   void reset(); // back to 0
+
+   long long getAllocations(MemoryKind kind) const;
+   long long getFrees(MemoryKind kind) const;
+   long long getAllocations() const; // every kind
+   long long getFrees() const;
+   long long getBytesAllocated() const;
+   long long getBytesFreed() const;
+
+private:
+   long long allocations[MEM_KINDS];
+   long long frees[MEM_KINDS];
+   long long bytesAllocated[MEM_KINDS];
+   long long bytesFreed[MEM_KINDS];
+};
+
+// ScopedMemoryHook
+// Installs a hook on this thread until the end of the scope.
+class ScopedMemoryHook
+{
+public:
+   explicit ScopedMemoryHook(MemoryHook * hook);
+   ~ScopedMemoryHook(); // puts the previous hook back
+   ScopedMemoryHook(const ScopedMemoryHook &) = delete;
+
+private:
+   MemoryHook * previous;
+};
+
+// MemoryReport
+// Memory held by one table (see Table::memoryReport).
+struct MemoryReport
+{
+   size_t requested[MEM_KINDS] = {}; // bytes asked for
+   size_t usable[MEM_KINDS] = {}; // bytes the allocator actually gave
+   long long blocks = 0; // heap blocks
+   int entries = 0; // websites
+   int sharedEntries = 0; // nodes shared with a snapshot (copy-on-write)
+   size_t filterBytes = 0; // membership filter, 0 if off
+   int cachedTopics = 0; // result cache entries, 0 if off
+
+   size_t totalRequested() const;
+   size_t totalUsable() const;
+   double bytesPerEntry() const; // usable bytes (and filter) per website
+   double slack() const; // share of usable bytes nobody asked for
+};
+ostream & operator<< (ostream & out, const MemoryReport & report);
+
+size_t usableSize(const void * block, size_t requested); // allocator's size
+
+#endif
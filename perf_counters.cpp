@@ -0,0 +1,363 @@
+/******************************************************************************
+# Program Desc.:      This program is a website bookmarking program. The program
+#                     implements a hash table using chaining (pointer array of
+#                     linked lists) to store website information.
+# File:               perf_counters.cpp
+# File Description:   Implementation of PerfCounters (perf_event_open on
+#                     Linux, nothing elsewhere) and PerfStats.
+# Input:              None
+# Output:             None
+#******************************************************************************/
+#include "perf_counters.h"
+
+#include <iomanip>
+#include <chrono>
+#include <cstring>
+#include <cerrno>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+const char * const PERF_EVENT_NAMES[PERF_EVENTS] = { "cycles", "instructions",
+                                                     "llc-misses",
+                                                     "branch-misses" };
+
+const char * const PERF_OPERATION_NAMES[PERF_OPERATIONS] = { "insert",
+                                                             "bulk",
+                                                             "retrieve",
+                                                             "topK", "edit",
+                                                             "remove",
+                                                             "merge",
+                                                             "load" };
+
+thread_local PerfStats * currentPerfStats = nullptr;
+
+// setPerfStats
+// Description: Installs stats for the calling thread, which must be the
+//              thread that made them (the counters count that thread).
+// Input: stats - the stats, nullptr for none
+// Output: the stats that were installed before
+PerfStats * setPerfStats(PerfStats * stats)
+{
+   PerfStats * previous = currentPerfStats;
+   currentPerfStats = stats;
+   return previous;
+}
+
+// PERF COUNTERS
+
+// Constructor
+// Description: Opens the four counters for the calling thread, user space
+//              only (which perf_event_paranoid 2, the usual default,
+//              allows), as one group led by the first one that opens.
+//              Counters the CPU or kernel does not offer are left out; if
+//              none open, error says why.
+PerfCounters::PerfCounters()
+{
+   leader = -1;
+   opened = 0;
+   for (int i = 0; i < PERF_EVENTS; i++)
+   {
+      fds[i] = -1;
+      slots[i] = -1;
+   }
+#ifdef __linux__
+   const uint64_t configs[PERF_EVENTS] = { PERF_COUNT_HW_CPU_CYCLES,
+                                           PERF_COUNT_HW_INSTRUCTIONS,
+                                           PERF_COUNT_HW_CACHE_MISSES,
+                                           PERF_COUNT_HW_BRANCH_MISSES };
+   for (int i = 0; i < PERF_EVENTS; i++)
+   {
+      perf_event_attr attr;
+      memset(&attr, 0, sizeof(attr));
+      attr.size = sizeof(attr);
+      attr.type = PERF_TYPE_HARDWARE;
+      attr.config = configs[i];
+      attr.disabled = leader < 0 ? 1 : 0; // the group starts together
+      attr.exclude_kernel = 1;
+      attr.exclude_hv = 1;
+      attr.read_format = PERF_FORMAT_GROUP |
+                         PERF_FORMAT_TOTAL_TIME_ENABLED |
+                         PERF_FORMAT_TOTAL_TIME_RUNNING;
+      int fd = (int)syscall(SYS_perf_event_open, &attr, 0, -1, leader, 0);
+      if (fd < 0)
+      {
+         if (error.empty())
+         {
+            error = string(PERF_EVENT_NAMES[i]) + ": " + strerror(errno);
+         }
+         continue;
+      }
+      fds[i] = fd;
+      slots[i] = opened++;
+      if (leader < 0)
+      {
+         leader = fd;
+      }
+   }
+   if (leader >= 0)
+   {
+      ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+      if (opened == PERF_EVENTS)
+      {
+         error.clear();
+      }
+   }
+#else
+   error = "perf_event_open is Linux only";
+#endif
+}
+
+// Destructor
+// Description: Closes every counter that was opened.
+PerfCounters::~PerfCounters()
+{
+#ifdef __linux__
+   for (int i = 0; i < PERF_EVENTS; i++)
+   {
+      if (fds[i] >= 0)
+      {
+         close(fds[i]);
+      }
+   }
+#endif
+}
+
+// isAvailable
+// Description: Returns true if the counter was opened.
+bool PerfCounters::isAvailable(PerfEvent event) const
+{
+   return fds[event] >= 0;
+}
+
+// anyAvailable
+// Description: Returns true if at least one counter was opened.
+bool PerfCounters::anyAvailable() const
+{
+   return leader >= 0;
+}
+
+// getError
+// Description: Returns why the first missing counter could not be opened,
+//              "" if every counter was.
+const string & PerfCounters::getError() const
+{
+   return error;
+}
+
+// read
+// Description: Reads every counter at once. If the kernel had to share the
+//              hardware between more counters than it has (multiplexing),
+//              the counts are scaled up by the share of time they ran.
+// Input: values - set to the counts so far, 0 for counters not opened
+// Output: None
+void PerfCounters::read(uint64_t values[PERF_EVENTS]) const
+{
+   for (int i = 0; i < PERF_EVENTS; i++)
+   {
+      values[i] = 0;
+   }
+#ifdef __linux__
+   if (leader < 0)
+   {
+      return;
+   }
+   uint64_t buffer[3 + PERF_EVENTS]; // count, enabled, running, values
+   ssize_t bytes = ::read(leader, buffer, sizeof(buffer));
+   if (bytes < (ssize_t)(3 * sizeof(uint64_t)))
+   {
+      return;
+   }
+   double scale = buffer[2] > 0 && buffer[2] < buffer[1] ?
+                  (double)buffer[1] / buffer[2] : 1.0;
+   for (int i = 0; i < PERF_EVENTS; i++)
+   {
+      if (slots[i] >= 0 && (uint64_t)slots[i] < buffer[0])
+      {
+         values[i] = (uint64_t)(buffer[3 + slots[i]] * scale);
+      }
+   }
+#endif
+}
+
+// PERF STATS
+
+// Constructor
+PerfStats::PerfStats()
+{
+   depth = 0;
+   current = PERF_INSERT;
+   startNanos = 0;
+   for (int i = 0; i < PERF_EVENTS; i++)
+   {
+      start[i] = 0;
+   }
+   reset();
+}
+
+// nowNanos
+// Description: Steady clock time in nanoseconds.
+static uint64_t nowNanos()
+{
+   return (uint64_t)chrono::duration_cast<chrono::nanoseconds>(
+      chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// begin
+// Description: Starts counting a call of operation, unless a call is
+//              already being counted (then it is part of that one).
+// Input: operation - the operation starting
+// Output: None
+void PerfStats::begin(PerfOperation operation)
+{
+   if (depth++ > 0)
+   {
+      return;
+   }
+   current = operation;
+   startNanos = nowNanos();
+   counters.read(start);
+}
+
+// end
+// Description: Ends the call begin started, adding what the counters and
+//              the clock moved by to its operation.
+// Input: None
+// Output: None
+void PerfStats::end()
+{
+   if (--depth > 0)
+   {
+      return;
+   }
+   uint64_t values[PERF_EVENTS];
+   counters.read(values);
+   nanos[current] += nowNanos() - startNanos;
+   for (int i = 0; i < PERF_EVENTS; i++)
+   {
+      totals[current][i] += values[i] - start[i];
+   }
+   calls[current]++;
+}
+
+// reset
+// Description: Sets every total back to 0.
+void PerfStats::reset()
+{
+   for (int op = 0; op < PERF_OPERATIONS; op++)
+   {
+      calls[op] = 0;
+      nanos[op] = 0;
+      for (int i = 0; i < PERF_EVENTS; i++)
+      {
+         totals[op][i] = 0;
+      }
+   }
+}
+
+// getCalls
+// Description: Returns the calls counted for an operation.
+long long PerfStats::getCalls(PerfOperation operation) const
+{
+   return calls[operation];
+}
+
+// getTotal
+// Description: Returns a counter's total over the calls of an operation,
+//              0 if the counter is not available.
+uint64_t PerfStats::getTotal(PerfOperation operation, PerfEvent event) const
+{
+   return totals[operation][event];
+}
+
+// getNanos
+// Description: Returns the wall time of the calls of an operation.
+uint64_t PerfStats::getNanos(PerfOperation operation) const
+{
+   return nanos[operation];
+}
+
+// getCounters
+// Description: Returns the counters, to check what is available.
+const PerfCounters & PerfStats::getCounters() const
+{
+   return counters;
+}
+
+// ostream operator overload
+// Description: Writes one line per operation that was called: calls, then
+//              per call the wall time, each counter (- if not available),
+//              and instructions per cycle. Says why if counters are
+//              missing.
+// Input: out, stats
+// Output: out
+ostream & operator<<(ostream & out, const PerfStats & stats)
+{
+   const PerfCounters & counters = stats.getCounters();
+   out << "operation     calls      ns/op  cycles/op   instr/op   llc/op"
+       << " brmiss/op   IPC" << '\n';
+   for (int op = 0; op < PERF_OPERATIONS; op++)
+   {
+      PerfOperation operation = (PerfOperation)op;
+      long long calls = stats.getCalls(operation);
+      if (calls == 0)
+      {
+         continue;
+      }
+      out << left << setw(9) << PERF_OPERATION_NAMES[op] << right
+          << setw(10) << calls << fixed << setprecision(0) << setw(11)
+          << (double)stats.getNanos(operation) / calls;
+      const int widths[PERF_EVENTS] = { 11, 11, 9, 10 };
+      for (int i = 0; i < PERF_EVENTS; i++)
+      {
+         out << setw(widths[i]);
+         if (counters.isAvailable((PerfEvent)i))
+         {
+            out << setprecision(i >= PERF_LLC_MISSES ? 2 : 0)
+                << (double)stats.getTotal(operation, (PerfEvent)i) / calls;
+         }
+         else
+         {
+            out << "-";
+         }
+      }
+      uint64_t cycles = stats.getTotal(operation, PERF_CYCLES);
+      out << setw(6);
+      if (cycles > 0 && counters.isAvailable(PERF_INSTRUCTIONS))
+      {
+         out << setprecision(2)
+             << (double)stats.getTotal(operation, PERF_INSTRUCTIONS) / cycles;
+      }
+      else
+      {
+         out << "-";
+      }
+      out << '\n';
+   }
+   out.unsetf(ios::fixed);
+   if (!counters.getError().empty())
+   {
+      out << "counters missing (" << counters.getError() << ")"
+          << (counters.anyAvailable() ? "" : ": wall time only") << '\n';
+   }
+   return out;
+}
+
+// SCOPED PERF STATS
+
+// Constructor
+// Description: Installs the stats on this thread.
+ScopedPerfStats::ScopedPerfStats(PerfStats * stats)
+{
+   previous = setPerfStats(stats);
+}
+
+// Destructor
+// Description: Puts back the stats that were installed before.
+ScopedPerfStats::~ScopedPerfStats()
+{
+   setPerfStats(previous);
+}
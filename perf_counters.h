@@ -0,0 +1,152 @@
+/******************************************************************************
+# Program Desc.:      This program is a website bookmarking program. The program
+#                     implements a hash table using chaining (pointer array of
+#                     linked lists) to store website information.
+# File:               perf_counters.h
+# File Description:   Hardware performance counters for the table's hot
+#                     operations. PerfCounters opens cycles, instructions,
+#                     last level cache misses and branch misses for the
+#                     calling thread with perf_event_open. PerfStats adds
+#                     them up per operation (insert, retrieve, ...); Table
+#                     wraps each operation in a PerfScope, which reports to
+#                     the calling thread's PerfStats if one is installed
+#                     (one branch when none is). Where the counters cannot
+#                     be opened (not Linux, perf_event_paranoid, a VM
+#                     without a PMU) only calls and wall time are counted.
+# Input:              None
+# Output:             None
+#******************************************************************************/
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+#include <iostream>
+#include <string>
+#include <cstdint>
+
+using namespace std;
+
+// PerfEvent
+// What a counter counts (user space only).
+enum PerfEvent
+{
+   PERF_CYCLES,
+   PERF_INSTRUCTIONS,
+   PERF_LLC_MISSES, // last level cache misses
+   PERF_BRANCH_MISSES,
+   PERF_EVENTS
+};
+extern const char * const PERF_EVENT_NAMES[PERF_EVENTS];
+
+// PerfOperation
+// Table operations the counters are added up for.
+enum PerfOperation
+{
+   PERF_INSERT,
+   PERF_BULK, // insertBulk
+   PERF_RETRIEVE, // retrieve and retrieveShared
+   PERF_TOPK,
+   PERF_EDIT,
+   PERF_REMOVE, // removeOneStar
+   PERF_MERGE, // mergeFromFile
+   PERF_LOAD, // loadFromFile
+   PERF_OPERATIONS
+};
+extern const char * const PERF_OPERATION_NAMES[PERF_OPERATIONS];
+
+// PerfCounters
+// The four counters of the thread that made the object, opened as one
+// group so they are read together with a single system call.
+class PerfCounters
+{
+public:
+   PerfCounters(); // opens what it can for the calling thread
+   ~PerfCounters(); // closes them
+   PerfCounters(const PerfCounters &) = delete;
+   const PerfCounters & operator= (const PerfCounters &) = delete;
+
+   bool isAvailable(PerfEvent event) const; // true if it was opened
+   bool anyAvailable() const;
+   const string & getError() const; // why counters are missing, "" if not
+   void read(uint64_t values[PERF_EVENTS]) const; // totals so far
+
+private:
+   int fds[PERF_EVENTS]; // file descriptor per counter, -1 if not opened
+   int slots[PERF_EVENTS]; // place of each counter in a group read, or -1
+   int leader; // first counter opened, -1 if none
+   int opened; // counters in the group
+   string error;
+};
+
+// PerfStats
+// Counter totals, wall time and calls per operation, for one thread.
+class PerfStats
+{
+public:
+   PerfStats(); // opens the counters for the calling thread
+   PerfStats(const PerfStats &) = delete;
+   void begin(PerfOperation operation); // called by PerfScope
+   void end();
+   void reset(); // back to 0
+
+   long long getCalls(PerfOperation operation) const;
+   uint64_t getTotal(PerfOperation operation, PerfEvent event) const;
+   uint64_t getNanos(PerfOperation operation) const;
+   const PerfCounters & getCounters() const;
+
+private:
+   PerfCounters counters;
+   int depth; // PerfScopes open; only the outermost one is counted
+   PerfOperation current; // operation of the outermost scope
+   uint64_t start[PERF_EVENTS]; // counter values when it began
+   uint64_t startNanos;
+   long long calls[PERF_OPERATIONS];
+   uint64_t totals[PERF_OPERATIONS][PERF_EVENTS];
+   uint64_t nanos[PERF_OPERATIONS];
+};
+ostream & operator<< (ostream & out, const PerfStats & stats);
+
+extern thread_local PerfStats * currentPerfStats; // nullptr if none
+
+PerfStats * setPerfStats(PerfStats * stats); // install, returns the old one
+
+// PerfScope
+// Counts the rest of the enclosing block as one call of an operation.
+// Operations called from inside another one (insert from mergeFromFile)
+// count toward the outer one only.
+class PerfScope
+{
+public:
+   explicit PerfScope(PerfOperation operation)
+   {
+      stats = currentPerfStats;
+      if (stats)
+      {
+         stats->begin(operation);
+      }
+   }
+   ~PerfScope()
+   {
+      if (stats)
+      {
+         stats->end();
+      }
+   }
+   PerfScope(const PerfScope &) = delete;
+
+private:
+   PerfStats * stats;
+};
+
+// ScopedPerfStats
+// Installs stats on this thread until the end of the scope.
+class ScopedPerfStats
+{
+public:
+   explicit ScopedPerfStats(PerfStats * stats);
+   ~ScopedPerfStats(); // puts the previous stats back
+   ScopedPerfStats(const ScopedPerfStats &) = delete;
+
+private:
+   PerfStats * previous;
+};
+
+#endif
@@ -0,0 +1,139 @@
+/******************************************************************************
+# Program Desc.:      This program is a website bookmarking program. The program
+#                     implements a hash table using chaining (pointer array of
+#                     linked lists) to store website information.
+# File:               protocol.cpp
+# File Description:   Implementation of the protocol and socket helpers shared
+#                     by the query server and the load generator.
+# Input:              None
+# Output:             None
+#******************************************************************************/
+#include "protocol.h"
+
+#include <cstring>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+// splitFields
+// Description: Splits a request line on tabs. The last field gets the rest
+//              of the line if there are more than max fields.
+// Input: line - the request line, fields - array to fill, max - its size
+// Output: the number of fields filled
+int splitFields(const string & line, string fields[], int max)
+{
+   int count = 0;
+   size_t start = 0;
+   while (count < max)
+   {
+      size_t tab = line.find('\t', start);
+      if (tab == string::npos || count == max - 1) // last field
+      {
+         fields[count] = line.substr(start);
+         count++;
+         break;
+      }
+      fields[count] = line.substr(start, tab - start);
+      count++;
+      start = tab + 1;
+   }
+   return count;
+}
+
+// makeAddress
+// Description: Fills in a Unix socket address if unixPath is given, else a
+//              localhost TCP address for port.
+// Input: unixPath, port, storage for the address
+// Output: the length of the address
+static socklen_t makeAddress(const char * unixPath, int port,
+                             sockaddr_storage & address)
+{
+   memset(&address, 0, sizeof(address));
+   if (unixPath)
+   {
+      sockaddr_un * un = (sockaddr_un *)&address;
+      un->sun_family = AF_UNIX;
+      strncpy(un->sun_path, unixPath, sizeof(un->sun_path) - 1);
+      return sizeof(sockaddr_un);
+   }
+   sockaddr_in * in = (sockaddr_in *)&address;
+   in->sin_family = AF_INET;
+   in->sin_port = htons(port);
+   in->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+   return sizeof(sockaddr_in);
+}
+
+// openListener
+// Description: Creates a non blocking listening socket. A stale Unix socket
+//              file from an earlier run is removed first.
+// Input: unixPath - Unix socket path, or nullptr for TCP
+//        port - localhost TCP port when unixPath is nullptr
+// Output: the socket, -1 on error
+int openListener(const char * unixPath, int port)
+{
+   sockaddr_storage address;
+   socklen_t length = makeAddress(unixPath, port, address);
+   int fd = socket(address.ss_family, SOCK_STREAM, 0);
+   if (fd < 0)
+   {
+      return -1;
+   }
+   if (unixPath)
+   {
+      unlink(unixPath);
+   }
+   else
+   {
+      int on = 1;
+      setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+   }
+   if (bind(fd, (sockaddr *)&address, length) < 0 || listen(fd, 128) < 0 ||
+       !setNonBlocking(fd))
+   {
+      close(fd);
+      return -1;
+   }
+   return fd;
+}
+
+// openClient
+// Description: Connects a blocking socket to the server. Nagle is turned
+//              off for TCP so small pipelined requests are not delayed.
+// Input: unixPath - Unix socket path, or nullptr for TCP
+//        port - localhost TCP port when unixPath is nullptr
+// Output: the socket, -1 on error
+int openClient(const char * unixPath, int port)
+{
+   sockaddr_storage address;
+   socklen_t length = makeAddress(unixPath, port, address);
+   int fd = socket(address.ss_family, SOCK_STREAM, 0);
+   if (fd < 0)
+   {
+      return -1;
+   }
+   if (connect(fd, (sockaddr *)&address, length) < 0)
+   {
+      close(fd);
+      return -1;
+   }
+   if (!unixPath)
+   {
+      int on = 1;
+      setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+   }
+   return fd;
+}
+
+// setNonBlocking
+// Description: Sets O_NONBLOCK on a file descriptor.
+// Input: fd
+// Output: false if fcntl failed
+bool setNonBlocking(int fd)
+{
+   int flags = fcntl(fd, F_GETFL, 0);
+   return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
@@ -0,0 +1,48 @@
+/******************************************************************************
+# Program Desc.:      This program is a website bookmarking program. The program
+#                     implements a hash table using chaining (pointer array of
+#                     linked lists) to store website information.
+# File:               protocol.h
+# File Description:   Header for the line protocol shared by the query server
+#                     and the load generator, plus socket helpers.
+#
+#                     Every request is one line, fields separated by tabs:
+#                        GET <topic>
+#                        ADD <topic> <url> <summary> <review> <rating>
+#                        EDIT <topic> <url> <review> <rating>
+#                        PURGE
+#                        PING
+#                     Every response starts with a status line
+#                     "<STATUS> <number>". For GET the number is how many
+#                     website lines follow (topic, url, summary, review and
+#                     rating separated by tabs, best rated first). For PURGE
+#                     it is how many websites were removed. Otherwise it is 0
+#                     and nothing follows. STATUS is OK, EXISTS, NOTFOUND or
+#                     ERR. ERR also answers a rating that is not a whole
+#                     number and a line longer than MAX_LINE bytes. Requests
+#                     can be pipelined; responses come back in request
+#                     order.
+# Input:              None
+# Output:             None
+#******************************************************************************/
+#ifndef PROTOCOL_H
+#define PROTOCOL_H
+#include <string>
+
+using namespace std;
+
+const int DEFAULT_PORT = 5555; // localhost TCP port used when none is given
+const int MAX_FIELDS = 6; // command name plus the 5 fields of ADD
+const size_t MAX_LINE = 65536; // longest request line the server reads
+const size_t MAX_PENDING = 1048576; // unhandled request bytes per client
+
+// split a request line on tabs, returns the number of fields
+int splitFields(const string & line, string fields[], int max);
+// listen on a Unix socket (path) or localhost TCP port, -1 on error
+int openListener(const char * unixPath, int port);
+// connect to a Unix socket (path) or localhost TCP port, -1 on error
+int openClient(const char * unixPath, int port);
+// make a socket non blocking, false on error
+bool setNonBlocking(int fd);
+
+#endif
@@ -0,0 +1,131 @@
+/******************************************************************************
+# Program Desc.:      This program is a website bookmarking program. The program
+#                     implements a hash table using chaining (pointer array of
+#                     linked lists) to store website information.
+# File:               query_cache.cpp
+# File Description:   Implementation file for the QueryCache class.
+# Input:              None
+# Output:             None
+#******************************************************************************/
+#include "query_cache.h"
+
+// Constructor
+// Description: Makes an empty cache.
+// Input: maxTopics - most topics to keep, at least 1
+QueryCache::QueryCache(int maxTopics) : generations(GENERATION_SLOTS, 0)
+{
+   this->maxTopics = maxTopics > 0 ? maxTopics : 1;
+}
+
+// find
+// Description: Looks up a topic. A hit moves the entry to the front of the
+//              recently used list. A miss passes back the key's generation,
+//              to be handed to store with the result searched for.
+// Input: key - hash of the topic, topic - the topic
+//        generation - passed back on a miss: the key's generation
+// Output: the cached result, nullptr on a miss
+QueryCache::Matches QueryCache::find(uint64_t key, const char * topic,
+                                     uint64_t & generation)
+{
+   lock_guard<mutex> guard(lock);
+   unordered_map<uint64_t, Entries::iterator>::iterator it = index.find(key);
+   if (it == index.end() || it->second->topic != topic)
+   {
+      stats.misses++;
+      generation = generations[key % GENERATION_SLOTS];
+      return nullptr;
+   }
+   entries.splice(entries.begin(), entries, it->second); // now most recent
+   stats.hits++;
+   return it->second->matches;
+}
+
+// store
+// Description: Caches the result for a topic as the most recently used
+//              entry, evicting the least recently used entry if the cache is
+//              full. Replaces any entry already there for the key. The
+//              result is dropped instead if the key was invalidated after
+//              the miss it was searched for (or another key of its slot
+//              was, which only costs a later miss): the search may have
+//              run before the change.
+// Input: key - hash of the topic, topic - the topic, matches - its result
+//        generation - what find passed back on the miss
+// Output: None
+void QueryCache::store(uint64_t key, const char * topic,
+                       const Matches & matches, uint64_t generation)
+{
+   lock_guard<mutex> guard(lock);
+   if (generations[key % GENERATION_SLOTS] != generation)
+   {
+      return;
+   }
+   unordered_map<uint64_t, Entries::iterator>::iterator it = index.find(key);
+   if (it != index.end())
+   {
+      entries.erase(it->second);
+      index.erase(it);
+   }
+   else if ((int)entries.size() >= maxTopics)
+   {
+      index.erase(entries.back().key);
+      entries.pop_back();
+      stats.evictions++;
+   }
+   Entry entry;
+   entry.key = key;
+   entry.topic = topic;
+   entry.matches = matches;
+   entries.push_front(entry);
+   index[key] = entries.begin();
+}
+
+// invalidate
+// Description: Drops the entry for a topic and moves its generation on, so
+//              results of searches that started before are not stored.
+//              Readers still holding the old result keep it; they just
+//              will not be handed it again.
+// Input: key - hash of the topic
+// Output: None
+void QueryCache::invalidate(uint64_t key)
+{
+   lock_guard<mutex> guard(lock);
+   generations[key % GENERATION_SLOTS]++;
+   unordered_map<uint64_t, Entries::iterator>::iterator it = index.find(key);
+   if (it != index.end())
+   {
+      entries.erase(it->second);
+      index.erase(it);
+      stats.invalidations++;
+   }
+}
+
+// clear
+// Description: Drops every entry and moves every generation on. The
+//              counters are kept.
+void QueryCache::clear()
+{
+   lock_guard<mutex> guard(lock);
+   for (size_t i = 0; i < generations.size(); i++)
+   {
+      generations[i]++;
+   }
+   entries.clear();
+   index.clear();
+}
+
+// getStats
+// Description: Returns a copy of the counters.
+CacheStats QueryCache::getStats() const
+{
+   lock_guard<mutex> guard(lock);
+   CacheStats copy = stats;
+   copy.entries = (int)entries.size();
+   return copy;
+}
+
+// getMaxTopics
+// Description: Returns the most topics the cache keeps.
+int QueryCache::getMaxTopics() const
+{
+   return maxTopics;
+}
@@ -0,0 +1,80 @@
+/******************************************************************************
+# Program Desc.:      This program is a website bookmarking program. The program
+#                     implements a hash table using chaining (pointer array of
+#                     linked lists) to store website information.
+# File:               query_cache.h
+# File Description:   Header file for the QueryCache class, a bounded least
+#                     recently used cache of lookup results keyed by topic.
+#                     Entries hold their own copies of the websites (shared,
+#                     read only), so they stay valid however the table moves
+#                     or copies its nodes. The table invalidates a topic's
+#                     entry whenever it changes one of the topic's websites.
+#                     Readers search the table without a lock, so a reader
+#                     could finish a search that started before a change
+#                     only after the change's invalidate: every invalidate
+#                     also bumps a generation for the key, find passes back
+#                     the generation on a miss, and store drops a result
+#                     whose key's generation has moved on since.
+# Input:              None
+# Output:             None
+#******************************************************************************/
+#ifndef QUERY_CACHE_H
+#define QUERY_CACHE_H
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#include "website.h"
+
+using namespace std;
+
+// CacheStats
+// Counters of a QueryCache since it was created.
+struct CacheStats
+{
+   long long hits = 0; // lookups answered from the cache
+   long long misses = 0; // lookups that had to search the table
+   long long invalidations = 0; // entries dropped because the topic changed
+   long long evictions = 0; // entries dropped to stay under the limit
+   int entries = 0; // topics cached right now
+};
+
+class QueryCache
+{
+public:
+   typedef shared_ptr<const vector<Website> > Matches; // one topic's result
+
+   explicit QueryCache(int maxTopics); // keep at most maxTopics results
+
+   Matches find(uint64_t key, const char * topic,
+                uint64_t & generation); // nullptr (and generation) on a miss
+   void store(uint64_t key, const char * topic, const Matches & matches,
+              uint64_t generation); // dropped if invalidated since the miss
+   void invalidate(uint64_t key); // drop the entry for a topic, if any
+   void clear(); // drop every entry
+   CacheStats getStats() const;
+   int getMaxTopics() const;
+
+private:
+   struct Entry
+   {
+      uint64_t key; // hash of the topic
+      string topic; // the topic itself, in case two topics share a hash
+      Matches matches;
+   };
+   typedef list<Entry> Entries; // most recently used first
+   const static int GENERATION_SLOTS = 4096; // keys share slots by modulo
+
+   int maxTopics;
+   Entries entries;
+   unordered_map<uint64_t, Entries::iterator> index; // key to entry
+   CacheStats stats;
+   vector<uint64_t> generations; // invalidations per slot of keys
+   mutable mutex lock; // lookups come from const (possibly shared) readers
+};
+
+#endif
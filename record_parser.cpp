@@ -0,0 +1,278 @@
+/******************************************************************************
+# Program Desc.:      This program is a website bookmarking program. The program
+#                     implements a hash table using chaining (pointer array of
+#                     linked lists) to store website information.
+# File:               record_parser.cpp
+# File Description:   Implementation file for the RecordParser class.
+# Input:              Website records
+# Output:             None
+#******************************************************************************/
+#include "record_parser.h"
+
+#include <cstdio>
+#include <cstring>
+#include <climits>
+
+// Constructor
+// Description: Starts a parse at line 1 with no record in progress.
+RecordParser::RecordParser()
+{
+   field = 0;
+   recordLine = 0;
+   skipping = false;
+   lineCount = 0;
+   recordCount = 0;
+   errorCount = 0;
+}
+
+// feed
+// Description: Parses the next bytes of input. Complete lines are handled
+//              straight from the buffer passed in; only a line split across
+//              two feeds is copied (into carry) until its end arrives.
+// Input: data, length - the bytes
+//        handler - called with each good record
+// Output: None
+void RecordParser::feed(const char * data, size_t length,
+                        const RecordHandler & handler)
+{
+   const char * end = data + length;
+   while (data < end)
+   {
+      const char * newline = (const char *)memchr(data, '\n', end - data);
+      if (!newline) // the rest of the line comes in a later feed
+      {
+         carry.append(data, end - data);
+         return;
+      }
+      if (carry.empty())
+      {
+         line(data, newline, handler);
+      }
+      else
+      {
+         carry.append(data, newline - data);
+         line(carry.data(), carry.data() + carry.size(), handler);
+         carry.clear();
+      }
+      data = newline + 1;
+   }
+}
+
+// finish
+// Description: Ends the input: a last line without a newline is handled,
+//              and a record still missing lines is reported.
+// Input: handler - called with the last record, if it is good
+// Output: None
+void RecordParser::finish(const RecordHandler & handler)
+{
+   if (!carry.empty())
+   {
+      line(carry.data(), carry.data() + carry.size(), handler);
+      carry.clear();
+   }
+   if (field > 0 && !skipping)
+   {
+      error(recordLine, "record ends after " + to_string(field) +
+                        " of 5 lines");
+   }
+   field = 0;
+   skipping = false;
+}
+
+// parseFile
+// Description: Feeds a whole file through the parser in 64 KB reads, then
+//              finishes.
+// Input: filename - the file
+//        handler - called with each good record
+// Output: false if the file could not be opened
+bool RecordParser::parseFile(const char * filename,
+                             const RecordHandler & handler)
+{
+   FILE * file = fopen(filename, "rb");
+   if (!file)
+   {
+      return false;
+   }
+   vector<char> buffer(65536);
+   size_t got;
+   while ((got = fread(buffer.data(), 1, buffer.size(), file)) > 0)
+   {
+      feed(buffer.data(), got, handler);
+   }
+   fclose(file);
+   finish(handler);
+   return true;
+}
+
+// line
+// Description: Handles one line (without its newline). A blank line ends a
+//              record: blank lines between records are skipped, and a blank
+//              line is where skipping after a bad record stops. Summary and
+//              review lines may be blank; topic, URL and rating may not.
+// Input: begin, end - the line
+//        handler - called if the line completes a good record
+// Output: None
+void RecordParser::line(const char * begin, const char * end,
+                        const RecordHandler & handler)
+{
+   lineCount++;
+   if (end > begin && end[-1] == '\r') // CRLF
+   {
+      end--;
+   }
+   bool blank = end == begin;
+   if (skipping)
+   {
+      skipping = !blank;
+      return;
+   }
+   if (field == 0)
+   {
+      if (blank) // between records
+      {
+         return;
+      }
+      recordLine = lineCount;
+   }
+   else if (blank && (field == 1 || field == FIELDS - 1))
+   {
+      error(lineCount, field == 1 ? "missing URL" : "missing rating");
+      field = 0;
+      return;
+   }
+   if (field < FIELDS - 1)
+   {
+      fields[field].assign(begin, end - begin);
+      field++;
+      return;
+   }
+
+   field = 0;
+   int rating = 0;
+   if (!parseInt(begin, end, rating))
+   {
+      error(lineCount, "rating \"" + string(begin, end - begin) +
+                       "\" is not a whole number");
+      skipping = true;
+      return;
+   }
+   website.setTopic(&fields[0][0]);
+   website.setURL(&fields[1][0]);
+   website.setSummary(&fields[2][0]);
+   website.setReview(&fields[3][0]);
+   website.setRating(rating);
+   recordCount++;
+   handler(website);
+}
+
+// parseInt
+// Description: Parses a decimal int that makes up the whole text, allowing
+//              spaces or tabs around it and a leading sign. No locale, no
+//              streams, no allocation.
+// Input: begin, end - the text
+//        value - set to the number if it parsed
+// Output: false if the text is not exactly one int that fits
+bool RecordParser::parseInt(const char * begin, const char * end, int & value)
+{
+   while (begin < end && (*begin == ' ' || *begin == '\t'))
+   {
+      begin++;
+   }
+   while (end > begin && (end[-1] == ' ' || end[-1] == '\t'))
+   {
+      end--;
+   }
+   bool negative = false;
+   if (begin < end && (*begin == '-' || *begin == '+'))
+   {
+      negative = *begin == '-';
+      begin++;
+   }
+   if (begin == end)
+   {
+      return false;
+   }
+   long long number = 0;
+   for (; begin < end; begin++)
+   {
+      if (*begin < '0' || *begin > '9')
+      {
+         return false;
+      }
+      number = number * 10 + (*begin - '0');
+      if (number > (long long)INT_MAX + 1)
+      {
+         return false;
+      }
+   }
+   number = negative ? -number : number;
+   if (number > INT_MAX)
+   {
+      return false;
+   }
+   value = (int)number;
+   return true;
+}
+
+// error
+// Description: Counts a bad record, keeping the first MAX_ERRORS in detail.
+// Input: line - line number, message - what was wrong
+// Output: None
+void RecordParser::error(int line, const string & message)
+{
+   errorCount++;
+   if ((int)errors.size() < MAX_ERRORS)
+   {
+      RecordError recordError;
+      recordError.line = line;
+      recordError.message = message;
+      errors.push_back(recordError);
+   }
+}
+
+// reportErrors
+// Description: Writes one "name:line: message" line per kept error, and how
+//              many more there were.
+// Input: out - where to write, name - the input's name
+// Output: None
+void RecordParser::reportErrors(ostream & out, const char * name) const
+{
+   for (size_t i = 0; i < errors.size(); i++)
+   {
+      out << name << ':' << errors[i].line << ": " << errors[i].message
+          << '\n';
+   }
+   if (errorCount > (int)errors.size())
+   {
+      out << name << ": " << errorCount - (int)errors.size()
+          << " more bad records" << '\n';
+   }
+}
+
+// getRecordCount
+// Description: Returns the number of good records passed to the handler.
+int RecordParser::getRecordCount() const
+{
+   return recordCount;
+}
+
+// getErrorCount
+// Description: Returns the number of bad records skipped.
+int RecordParser::getErrorCount() const
+{
+   return errorCount;
+}
+
+// getErrors
+// Description: Returns the first MAX_ERRORS errors.
+const vector<RecordError> & RecordParser::getErrors() const
+{
+   return errors;
+}
+
+// getLineCount
+// Description: Returns the number of lines seen so far.
+int RecordParser::getLineCount() const
+{
+   return lineCount;
+}
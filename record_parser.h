@@ -0,0 +1,80 @@
+/******************************************************************************
+# Program Desc.:      This program is a website bookmarking program. The program
+#                     implements a hash table using chaining (pointer array of
+#                     linked lists) to store website information.
+# File:               record_parser.h
+# File Description:   Header file for the RecordParser class, the one parser
+#                     for the 5 line website record format (topic, URL,
+#                     summary, review, rating, records separated by blank
+#                     lines). Bytes are pushed in as they are read, in chunks
+#                     of any size, so the same parser serves blocking loads
+#                     and the coroutine loader. Lines may be any length and
+#                     may end in CRLF. A bad record is reported with its line
+#                     number and skipped up to the next blank line, so it
+#                     never throws off the records after it.
+# Input:              None
+# Output:             None
+#******************************************************************************/
+#ifndef RECORD_PARSER_H
+#define RECORD_PARSER_H
+#include <iostream>
+#include <string>
+#include <vector>
+#include <functional>
+#include <cstddef>
+
+#include "website.h"
+
+using namespace std;
+
+// RecordError
+// One bad record: the line the problem was found on and what it was.
+struct RecordError
+{
+   int line;
+   string message;
+};
+
+class RecordParser
+{
+public:
+   typedef function<void(const Website &)> RecordHandler; // once per record
+
+   RecordParser();
+
+   void feed(const char * data, size_t length,
+             const RecordHandler & handler); // parse the next bytes
+   void finish(const RecordHandler & handler); // end of input
+   bool parseFile(const char * filename,
+                  const RecordHandler & handler); // feed a whole file
+   void reportErrors(ostream & out, const char * name) const; // name:line:
+
+   int getRecordCount() const; // good records passed to the handler
+   int getErrorCount() const; // bad records skipped
+   const vector<RecordError> & getErrors() const; // the first MAX_ERRORS
+   int getLineCount() const; // lines seen so far
+
+   static bool parseInt(const char * begin, const char * end,
+                        int & value); // whole line as a decimal int
+
+private:
+   const static int FIELDS = 5; // lines per record
+   const static int MAX_ERRORS = 100; // errors kept in detail
+
+   string carry; // start of a line split across feeds
+   string fields[FIELDS - 1]; // topic, URL, summary, review of this record
+   int field; // line of the record expected next, 0 for the topic
+   int recordLine; // line number of the record's topic
+   bool skipping; // after a bad record, skip to the next blank line
+   int lineCount;
+   int recordCount;
+   int errorCount;
+   vector<RecordError> errors;
+   Website website; // reused for every record
+
+   void line(const char * begin, const char * end,
+             const RecordHandler & handler); // handle one complete line
+   void error(int line, const string & message); // record a bad record
+};
+
+#endif
@@ -0,0 +1,605 @@
+/******************************************************************************
+# Program Desc.:      This program is a website bookmarking program. The program
+#                     implements a hash table using chaining (pointer array of
+#                     linked lists) to store website information.
+# File:               server.cpp
+# File Description:   Query server for the bookmark table. One epoll event
+#                     loop owns every connection (non blocking sockets) and
+#                     hands complete request lines to a fixed pool of worker
+#                     threads. Readers take no lock (see epoch.h), writers
+#                     take turns on one mutex.
+#                     See protocol.h for the request/response format.
+# Input:              Requests over a Unix socket or localhost TCP port,
+#                     optional data file to load at start up
+# Output:             Responses to each request
+#******************************************************************************/
+#include <iostream>
+#include <string>
+#include <vector>
+#include <deque>
+#include <unordered_map>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <csignal>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+using namespace std;
+
+#include "table.h"
+#include "website.h"
+#include "protocol.h"
+#include "record_parser.h"
+
+// Job
+// A run of complete request lines read from one connection. The event loop
+// only hands out one job per connection at a time, so responses stay in
+// request order even though any worker may run the job.
+struct Job
+{
+   unsigned long long connId; // connection the lines came from
+   string lines; // one or more complete request lines
+   string response; // filled in by the worker
+};
+
+// Connection
+// State of one client. Only the event loop thread touches it.
+struct Connection
+{
+   int fd = -1;
+   string inBuf; // bytes read but not yet handed to a worker
+   size_t partial = 0; // bytes of inBuf after its last newline
+   bool skipping = false; // dropping the rest of a line over MAX_LINE
+   string outBuf; // response bytes not yet written
+   bool busy = false; // a job for this connection is with a worker
+   bool readClosed = false; // client finished sending
+   unsigned events = EPOLLIN; // events registered with epoll
+};
+
+// Function Prototypes
+void workerLoop();
+string execute(const string &line);
+void appendWebsite(string &out, const Website &website);
+void handleAccept(int listenFd);
+void handleRead(unsigned long long connId);
+void handleWrite(unsigned long long connId);
+void dispatch(unsigned long long connId);
+void finishJobs();
+void closeConnection(unsigned long long connId);
+void updateEvents(unsigned long long connId);
+void onSignal(int signalNum);
+
+// Globals shared by the event loop and the workers
+Table table; // the bookmarks
+mutex writeLock; // held by ADD, EDIT and PURGE; GET takes no lock
+mutex queueLock; // guards jobQueue, doneQueue and stopping
+condition_variable queueReady; // signalled when jobQueue gets a job
+deque<Job> jobQueue; // jobs waiting for a worker
+deque<Job> doneQueue; // jobs finished, waiting for the event loop
+bool stopping = false; // tells workers to exit
+int epollFd = -1;
+int wakeFd = -1; // eventfd: workers (and signals) wake the event loop
+volatile sig_atomic_t stopRequested = 0;
+unordered_map<unsigned long long, Connection> connections;
+unsigned long long nextConnId = 1; // 0 is the listening socket's tag
+const unsigned long long WAKE_TAG = ~0ULL; // epoll tag of wakeFd
+
+int main(int argc, char * argv[])
+{
+   const char * unixPath = nullptr;
+   int port = DEFAULT_PORT;
+   int numWorkers = (int)thread::hardware_concurrency();
+   for (int i = 1; i < argc; i++)
+   {
+      if (strcmp(argv[i], "--unix") == 0 && i + 1 < argc)
+      {
+         unixPath = argv[++i];
+      }
+      else if (strcmp(argv[i], "--port") == 0 && i + 1 < argc)
+      {
+         port = atoi(argv[++i]);
+      }
+      else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+      {
+         numWorkers = atoi(argv[++i]);
+      }
+      else if (strcmp(argv[i], "--load") == 0 && i + 1 < argc)
+      {
+         table.loadFromFile(argv[++i]);
+      }
+      else
+      {
+         cerr << "Usage: server [--unix path | --port n] [--threads n] "
+              << "[--load file]" << endl;
+         return 1;
+      }
+   }
+   if (numWorkers < 1)
+   {
+      numWorkers = 1;
+   }
+
+   int listenFd = openListener(unixPath, port);
+   if (listenFd < 0)
+   {
+      perror("listen");
+      return 1;
+   }
+   epollFd = epoll_create1(0);
+   wakeFd = eventfd(0, EFD_NONBLOCK);
+   epoll_event event = {};
+   event.events = EPOLLIN;
+   event.data.u64 = 0;
+   epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd, &event);
+   event.data.u64 = WAKE_TAG;
+   epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &event);
+   signal(SIGINT, onSignal);
+   signal(SIGTERM, onSignal);
+   signal(SIGPIPE, SIG_IGN);
+
+   vector<thread> workers;
+   for (int i = 0; i < numWorkers; i++)
+   {
+      workers.push_back(thread(workerLoop));
+   }
+   cerr << "Serving " << table.getSize() << " websites on "
+        << (unixPath ? unixPath : "127.0.0.1:" + to_string(port))
+        << " with " << numWorkers << " workers" << endl;
+
+   // event loop
+   epoll_event events[64];
+   while (!stopRequested)
+   {
+      int ready = epoll_wait(epollFd, events, 64, -1);
+      for (int i = 0; i < ready; i++)
+      {
+         unsigned long long tag = events[i].data.u64;
+         if (tag == 0)
+         {
+            handleAccept(listenFd);
+         }
+         else if (tag == WAKE_TAG)
+         {
+            uint64_t count;
+            while (read(wakeFd, &count, sizeof(count)) > 0) // reset eventfd
+            {
+            }
+            finishJobs();
+         }
+         else
+         {
+            if (events[i].events & EPOLLOUT)
+            {
+               handleWrite(tag);
+            }
+            if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR))
+            {
+               handleRead(tag);
+            }
+         }
+      }
+   }
+
+   // shut down
+   {
+      lock_guard<mutex> guard(queueLock);
+      stopping = true;
+   }
+   queueReady.notify_all();
+   for (size_t i = 0; i < workers.size(); i++)
+   {
+      workers[i].join();
+   }
+   while (!connections.empty())
+   {
+      closeConnection(connections.begin()->first);
+   }
+   close(listenFd);
+   close(wakeFd);
+   close(epollFd);
+   if (unixPath)
+   {
+      unlink(unixPath);
+   }
+   cerr << "Server stopped" << endl;
+   return 0;
+}
+
+// onSignal function
+// Description: SIGINT/SIGTERM handler. Sets the stop flag and wakes the
+//              event loop (write to an eventfd is async signal safe).
+void onSignal(int signalNum)
+{
+   stopRequested = 1;
+   uint64_t one = 1;
+   ssize_t ignored = write(wakeFd, &one, sizeof(one));
+   (void)ignored;
+}
+
+// workerLoop function
+// Description: Runs jobs until the server stops. Each line of a job is
+//              executed in order and the responses are appended together,
+//              then the job goes back to the event loop.
+// Input: None
+// Output: None
+void workerLoop()
+{
+   while (true)
+   {
+      Job job;
+      {
+         unique_lock<mutex> guard(queueLock);
+         queueReady.wait(guard, [] { return stopping || !jobQueue.empty(); });
+         if (stopping)
+         {
+            return;
+         }
+         job = std::move(jobQueue.front());
+         jobQueue.pop_front();
+      }
+      size_t start = 0;
+      while (start < job.lines.size())
+      {
+         size_t newline = job.lines.find('\n', start);
+         job.response += execute(job.lines.substr(start, newline - start));
+         start = newline + 1;
+      }
+      {
+         lock_guard<mutex> guard(queueLock);
+         doneQueue.push_back(std::move(job));
+      }
+      uint64_t one = 1;
+      ssize_t ignored = write(wakeFd, &one, sizeof(one));
+      (void)ignored;
+   }
+}
+
+// execute function
+// Description: Runs one request line against the table and returns the
+//              response text (see protocol.h).
+// Input: line - the request without its newline
+// Output: the response, ending in a newline
+string execute(const string &line)
+{
+   string fields[MAX_FIELDS];
+   string clean = line;
+   if (!clean.empty() && clean[clean.size() - 1] == '\r')
+   {
+      clean.erase(clean.size() - 1);
+   }
+   int count = splitFields(clean, fields, MAX_FIELDS);
+   const string &command = fields[0];
+
+   if (command == "GET" && count == 2)
+   {
+      EpochGuard guard; // keeps the websites topK points at alive
+      // one buffer per worker, grown to the longest topic run served so
+      // far, so a GET costs the size of its result, not of the table
+      thread_local vector<const Website *> matches(64);
+      int found = 0;
+      table.topK(fields[1].c_str(), (int)matches.size(), matches.data(),
+                 found);
+      while (found == (int)matches.size()) // the run may go on
+      {
+         matches.resize(matches.size() * 2);
+         table.topK(fields[1].c_str(), (int)matches.size(), matches.data(),
+                    found);
+      }
+      string out = (found > 0 ? "OK " : "NOTFOUND ") + to_string(found) + "\n";
+      for (int i = 0; i < found; i++)
+      {
+         appendWebsite(out, *matches[i]);
+      }
+      return out;
+   }
+   if (command == "ADD" && count == 6)
+   {
+      int rating = 0;
+      if (!RecordParser::parseInt(fields[5].data(),
+                                  fields[5].data() + fields[5].size(),
+                                  rating))
+      {
+         return "ERR 0\n";
+      }
+      Website website;
+      website.setTopic(&fields[1][0]);
+      website.setURL(&fields[2][0]);
+      website.setSummary(&fields[3][0]);
+      website.setReview(&fields[4][0]);
+      website.setRating(rating);
+      lock_guard<mutex> guard(writeLock);
+      return table.insert(website) ? "OK 0\n" : "EXISTS 0\n";
+   }
+   if (command == "EDIT" && count == 5)
+   {
+      int rating = 0;
+      if (!RecordParser::parseInt(fields[4].data(),
+                                  fields[4].data() + fields[4].size(),
+                                  rating))
+      {
+         return "ERR 0\n";
+      }
+      lock_guard<mutex> guard(writeLock);
+      bool edited = table.edit(&fields[1][0], &fields[2][0], &fields[3][0],
+                               rating);
+      return edited ? "OK 0\n" : "NOTFOUND 0\n";
+   }
+   if (command == "PURGE" && count == 1)
+   {
+      lock_guard<mutex> guard(writeLock);
+      int before = table.getSize();
+      table.removeOneStar();
+      return "OK " + to_string(before - table.getSize()) + "\n";
+   }
+   if (command == "PING" && count == 1)
+   {
+      return "OK 0\n";
+   }
+   return "ERR 0\n";
+}
+
+// appendWebsite function
+// Description: Appends one website as a tab separated line. Tabs inside
+//              fields are turned into spaces so the line stays parseable.
+// Input: out - the response being built, website - the website
+// Output: None
+void appendWebsite(string &out, const Website &website)
+{
+   const char * fields[4] = { website.getTopic(), website.getURL(),
+                              website.getSummary(), website.getReview() };
+   for (int i = 0; i < 4; i++)
+   {
+      size_t start = out.size();
+      out += fields[i] ? fields[i] : "";
+      for (size_t j = start; j < out.size(); j++)
+      {
+         if (out[j] == '\t')
+         {
+            out[j] = ' ';
+         }
+      }
+      out += '\t';
+   }
+   out += to_string(website.getRating());
+   out += '\n';
+}
+
+// handleAccept function
+// Description: Accepts every pending client and registers it for reads.
+// Input: listenFd - the listening socket
+// Output: None
+void handleAccept(int listenFd)
+{
+   while (true)
+   {
+      int fd = accept(listenFd, nullptr, nullptr);
+      if (fd < 0) // EAGAIN: no more pending clients
+      {
+         return;
+      }
+      setNonBlocking(fd);
+      unsigned long long connId = nextConnId++;
+      connections[connId].fd = fd;
+      epoll_event event = {};
+      event.events = EPOLLIN;
+      event.data.u64 = connId;
+      epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event);
+   }
+}
+
+// handleRead function
+// Description: Reads what is available from a client, up to MAX_PENDING
+//              buffered bytes, then hands the complete lines to a worker if
+//              none is busy with this client. A line that grows past
+//              MAX_LINE is dropped, up to its newline, and answered with
+//              ERR in its place (an empty line).
+// Input: connId - the connection
+// Output: None
+void handleRead(unsigned long long connId)
+{
+   unordered_map<unsigned long long, Connection>::iterator found =
+      connections.find(connId);
+   if (found == connections.end())
+   {
+      return;
+   }
+   Connection &conn = found->second;
+   char buffer[16384];
+   while (conn.inBuf.size() < MAX_PENDING)
+   {
+      ssize_t got = read(conn.fd, buffer, sizeof(buffer));
+      if (got > 0)
+      {
+         const char * start = buffer;
+         const char * end = buffer + got;
+         if (conn.skipping) // the rest of a long line, up to its newline
+         {
+            const char * newline = (const char *)memchr(start, '\n', got);
+            if (!newline)
+            {
+               continue;
+            }
+            start = newline + 1;
+            conn.skipping = false;
+         }
+         conn.inBuf.append(start, end - start);
+         const char * last = (const char *)memrchr(start, '\n',
+                                                    end - start);
+         conn.partial = last ? end - last - 1 : conn.partial + (end - start);
+         if (conn.partial > MAX_LINE)
+         {
+            conn.inBuf.erase(conn.inBuf.size() - conn.partial);
+            conn.inBuf += '\n'; // an empty request, answered with ERR
+            conn.partial = 0;
+            conn.skipping = true;
+         }
+      }
+      else if (got == 0 || (errno != EAGAIN && errno != EINTR))
+      {
+         conn.readClosed = true; // EOF or error
+         break;
+      }
+      else if (errno == EAGAIN)
+      {
+         break;
+      }
+   }
+   dispatch(connId);
+}
+
+// dispatch function
+// Description: If the connection is idle and has complete lines buffered,
+//              queues them as one job. Closes the connection once the client
+//              has finished sending and every response is written.
+// Input: connId - the connection
+// Output: None
+void dispatch(unsigned long long connId)
+{
+   Connection &conn = connections[connId];
+   size_t lastNewline = conn.inBuf.rfind('\n');
+   if (!conn.busy && lastNewline != string::npos)
+   {
+      Job job;
+      job.connId = connId;
+      job.lines = conn.inBuf.substr(0, lastNewline + 1);
+      conn.inBuf.erase(0, lastNewline + 1);
+      conn.busy = true;
+      {
+         lock_guard<mutex> guard(queueLock);
+         jobQueue.push_back(std::move(job));
+      }
+      queueReady.notify_one();
+   }
+   if (conn.readClosed && !conn.busy && conn.outBuf.empty())
+   {
+      closeConnection(connId);
+      return;
+   }
+   updateEvents(connId);
+}
+
+// finishJobs function
+// Description: Takes finished jobs from the workers, queues their responses
+//              for writing and starts the next job for each connection.
+// Input: None
+// Output: None
+void finishJobs()
+{
+   deque<Job> done;
+   {
+      lock_guard<mutex> guard(queueLock);
+      done.swap(doneQueue);
+   }
+   for (size_t i = 0; i < done.size(); i++)
+   {
+      unordered_map<unsigned long long, Connection>::iterator found =
+         connections.find(done[i].connId);
+      if (found == connections.end()) // client went away
+      {
+         continue;
+      }
+      found->second.busy = false;
+      found->second.outBuf += done[i].response;
+      handleWrite(done[i].connId);
+      if (connections.count(done[i].connId))
+      {
+         dispatch(done[i].connId);
+      }
+   }
+}
+
+// handleWrite function
+// Description: Writes as much of the pending output as the socket takes.
+// Input: connId - the connection
+// Output: None
+void handleWrite(unsigned long long connId)
+{
+   unordered_map<unsigned long long, Connection>::iterator found =
+      connections.find(connId);
+   if (found == connections.end())
+   {
+      return;
+   }
+   Connection &conn = found->second;
+   size_t written = 0;
+   while (written < conn.outBuf.size())
+   {
+      ssize_t sent = write(conn.fd, conn.outBuf.data() + written,
+                           conn.outBuf.size() - written);
+      if (sent > 0)
+      {
+         written += sent;
+      }
+      else if (sent < 0 && errno == EINTR)
+      {
+         continue;
+      }
+      else if (sent < 0 && errno == EAGAIN)
+      {
+         break;
+      }
+      else // client is gone
+      {
+         closeConnection(connId);
+         return;
+      }
+   }
+   conn.outBuf.erase(0, written);
+   if (conn.readClosed && !conn.busy && conn.outBuf.empty())
+   {
+      closeConnection(connId);
+      return;
+   }
+   updateEvents(connId);
+}
+
+// updateEvents function
+// Description: Asks epoll for EPOLLOUT only while output is pending, and
+//              for EPOLLIN only while the connection can take more input:
+//              not once the client has finished sending (a closed socket
+//              is always readable), not while a job of its is with a
+//              worker and not while MAX_PENDING bytes wait. The client's
+//              further requests wait in the socket, which holds it back,
+//              and EPOLLIN comes back when its job finishes (finishJobs).
+// Input: connId - the connection
+// Output: None
+void updateEvents(unsigned long long connId)
+{
+   Connection &conn = connections[connId];
+   bool reading = !conn.readClosed && !conn.busy &&
+                  conn.inBuf.size() < MAX_PENDING;
+   unsigned events = (reading ? EPOLLIN : 0) |
+                     (conn.outBuf.empty() ? 0 : EPOLLOUT);
+   if (events == conn.events)
+   {
+      return;
+   }
+   conn.events = events;
+   epoll_event event = {};
+   event.events = events;
+   event.data.u64 = connId;
+   epoll_ctl(epollFd, EPOLL_CTL_MOD, conn.fd, &event);
+}
+
+// closeConnection function
+// Description: Closes the socket and forgets the connection. A job still
+//              running for it is dropped when it finishes.
+// Input: connId - the connection
+// Output: None
+void closeConnection(unsigned long long connId)
+{
+   unordered_map<unsigned long long, Connection>::iterator found =
+      connections.find(connId);
+   if (found == connections.end())
+   {
+      return;
+   }
+   epoll_ctl(epollFd, EPOLL_CTL_DEL, found->second.fd, nullptr);
+   close(found->second.fd);
+   connections.erase(found);
+}
@@ -0,0 +1,310 @@
+/******************************************************************************
+# Program Desc.:      This program is a website bookmarking program. The program
+#                     implements a hash table using chaining (pointer array of
+#                     linked lists) to store website information.
+# File:               sharded_table.cpp
+# File Description:   Implementation file for the ShardedTable class.
+# Input:              None
+# Output:             None
+#******************************************************************************/
+#include "sharded_table.h"
+#include "basic_table.h"
+#include "record_parser.h"
+
+#include <sstream>
+#include <chrono>
+
+// Constructor
+// Description: Creates the shards and starts one thread per shard. Each
+//              shard's table is built by the main thread but only ever used
+//              by its shard thread afterwards.
+// Input: numShards - number of shards, 0 for one per core
+ShardedTable::ShardedTable(int numShards)
+{
+   if (numShards <= 0)
+   {
+      numShards = (int)thread::hardware_concurrency();
+   }
+   if (numShards <= 0)
+   {
+      numShards = 1;
+   }
+   for (int i = 0; i < numShards; i++)
+   {
+      shards.push_back(unique_ptr<Shard>(new Shard()));
+   }
+   for (int i = 0; i < numShards; i++)
+   {
+      shards[i]->worker = thread(&ShardedTable::workerLoop, this,
+                                 shards[i].get());
+   }
+}
+
+// Destructor
+// Description: Lets every shard finish its queue, then joins the threads.
+ShardedTable::~ShardedTable()
+{
+   for (size_t i = 0; i < shards.size(); i++)
+   {
+      {
+         lock_guard<mutex> guard(shards[i]->lock);
+         shards[i]->stopping = true;
+      }
+      shards[i]->ready.notify_one();
+   }
+   for (size_t i = 0; i < shards.size(); i++)
+   {
+      shards[i]->worker.join();
+   }
+}
+
+// shardOf
+// Description: Picks the shard for a topic with FNV-1a, so all websites of
+//              a topic live in one shard and topic lookups go to one thread.
+//              (Table's own additive hash would put anagrams together.)
+// Input: topic
+// Output: index of the shard
+int ShardedTable::shardOf(const char * topic) const
+{
+   return (int)(CStringHash()(topic) % shards.size());
+}
+
+// workerLoop
+// Description: Shard thread body. Runs queued requests in order until the
+//              table is destroyed and the queue is empty.
+// Input: shard - the shard this thread owns
+// Output: None
+void ShardedTable::workerLoop(Shard * shard)
+{
+   while (true)
+   {
+      function<void()> request;
+      {
+         unique_lock<mutex> guard(shard->lock);
+         shard->ready.wait(guard, [shard]
+         {
+            return shard->stopping || !shard->queue.empty();
+         });
+         if (shard->queue.empty()) // stopping and nothing left to do
+         {
+            return;
+         }
+         request = std::move(shard->queue.front());
+         shard->queue.pop_front();
+      }
+      chrono::steady_clock::time_point start = chrono::steady_clock::now();
+      request();
+      shard->stats.busyNanos += chrono::duration_cast<chrono::nanoseconds>(
+         chrono::steady_clock::now() - start).count();
+      shard->stats.size = shard->table.getSize();
+   }
+}
+
+// post
+// Description: Queues a request for a shard's thread.
+// Input: shard - index of the shard, request - the work
+// Output: None
+void ShardedTable::post(int shard, function<void()> request) const
+{
+   Shard * target = shards[shard].get();
+   {
+      lock_guard<mutex> guard(target->lock);
+      target->queue.push_back(std::move(request));
+   }
+   target->ready.notify_one();
+}
+
+// insert
+// Description: Sends a copy of the website to the shard that owns its topic.
+// Input: website - the website to be inserted
+// Output: true if inserted, false if the website already exists
+bool ShardedTable::insert(const Website & website)
+{
+   Website copy(website); // the message; the caller's website is not shared
+   return submit<bool>(shardOf(website.getTopic()),
+      [copy](Table & table, ShardStats & stats) mutable
+      {
+         stats.inserts++;
+         return table.insert(copy);
+      }).get();
+}
+
+// retrieve
+// Description: Asks the shard that owns the topic to copy its matches into
+//              the caller's array. The caller waits for the answer, so the
+//              array is safe to write from the shard thread.
+// Input: searchTopic, websites - array to fill, num_found - count passed back
+// Output: true if the websites were found, false if not
+bool ShardedTable::retrieve(const char * searchTopic, Website websites[],
+                            int & num_found) const
+{
+   string topic = searchTopic;
+   num_found = 0;
+   return submit<bool>(shardOf(searchTopic),
+      [topic, websites, &num_found](Table & table, ShardStats & stats)
+      {
+         stats.retrieves++;
+         return table.retrieve(topic.c_str(), websites, num_found);
+      }).get();
+}
+
+// edit
+// Description: Sends the edit to the shard that owns the topic.
+// Input: searchTopic, searchURL, newReview, newRating
+// Output: true if the website was edited, false if it does not exist
+bool ShardedTable::edit(const char * searchTopic, const char * searchURL,
+                        const char * newReview, int newRating)
+{
+   string topic = searchTopic;
+   string url = searchURL;
+   string review = newReview;
+   return submit<bool>(shardOf(searchTopic),
+      [topic, url, review, newRating](Table & table, ShardStats & stats)
+         mutable
+      {
+         stats.edits++;
+         return table.edit(&topic[0], &url[0], &review[0], newRating);
+      }).get();
+}
+
+// removeOneStar
+// Description: Sends removeOneStar to every shard at once, so they purge in
+//              parallel, then waits for all of them.
+// Input: None
+// Output: true if any shard removed something
+bool ShardedTable::removeOneStar()
+{
+   vector<future<bool> > results;
+   for (size_t i = 0; i < shards.size(); i++)
+   {
+      results.push_back(submit<bool>((int)i,
+         [](Table & table, ShardStats & stats)
+         {
+            stats.scans++;
+            return table.removeOneStar();
+         }));
+   }
+   bool removed = false;
+   for (size_t i = 0; i < results.size(); i++)
+   {
+      removed = results[i].get() || removed;
+   }
+   return removed;
+}
+
+// displayAll
+// Description: Every shard formats its websites in parallel, then the text
+//              is printed shard by shard, so the output order is stable.
+// Input: None
+// Output: true if there was anything to display
+bool ShardedTable::displayAll() const
+{
+   vector<future<string> > results;
+   for (size_t i = 0; i < shards.size(); i++)
+   {
+      results.push_back(submit<string>((int)i,
+         [](Table & table, ShardStats & stats)
+         {
+            stats.scans++;
+            ostringstream out;
+            for (Table::const_iterator it = table.begin(); it != table.end();
+                 ++it)
+            {
+               out << *it << '\n';
+            }
+            return out.str();
+         }));
+   }
+   bool found = false;
+   for (size_t i = 0; i < results.size(); i++)
+   {
+      string text = results[i].get();
+      found = found || !text.empty();
+      cout << text;
+   }
+   return found;
+}
+
+// getSize
+// Description: Adds up the size of every shard (asked in parallel).
+// Input: None
+// Output: the total number of websites
+int ShardedTable::getSize() const
+{
+   vector<future<int> > results;
+   for (size_t i = 0; i < shards.size(); i++)
+   {
+      results.push_back(submit<int>((int)i,
+         [](Table & table, ShardStats &)
+         {
+            return table.getSize();
+         }));
+   }
+   int total = 0;
+   for (size_t i = 0; i < results.size(); i++)
+   {
+      total += results[i].get();
+   }
+   return total;
+}
+
+// getShardCount
+// Description: Returns the number of shards.
+int ShardedTable::getShardCount() const
+{
+   return (int)shards.size();
+}
+
+// getStats
+// Description: Returns a copy of a shard's counters, read on its own thread
+//              so the copy is consistent.
+// Input: shard - index of the shard
+// Output: the counters
+ShardStats ShardedTable::getStats(int shard) const
+{
+   return submit<ShardStats>(shard, [](Table &, ShardStats & stats)
+   {
+      return stats;
+   }).get();
+}
+
+// loadFromFile
+// Description: Parses the file with RecordParser and posts each website
+//              straight to the shard that owns its topic, so the shards
+//              insert while the file is still being read and each one sees
+//              its websites in file order. Then waits for every shard to
+//              drain its queue. Bad records are skipped and reported to cerr
+//              with their line numbers, like Table::loadFromFile.
+// Input: filename - the name of the file to be loaded
+// Output: None
+void ShardedTable::loadFromFile(const char * filename)
+{
+   RecordParser parser;
+   if (!parser.parseFile(filename, [this](const Website & website)
+   {
+      Shard * target = shards[shardOf(website.getTopic())].get();
+      Website copy(website); // the message, like insert
+      post(shardOf(website.getTopic()), [target, copy]() mutable
+      {
+         target->stats.inserts++;
+         target->table.insert(copy);
+      });
+   }))
+   {
+      cout << "Error opening file" << endl;
+      return;
+   }
+   vector<future<bool> > drained(shards.size());
+   for (size_t i = 0; i < shards.size(); i++) // queues run in order
+   {
+      drained[i] = submit<bool>((int)i, [](Table &, ShardStats &)
+      {
+         return true;
+      });
+   }
+   for (size_t i = 0; i < drained.size(); i++)
+   {
+      drained[i].get();
+   }
+   parser.reportErrors(cerr, filename);
+}
@@ -0,0 +1,106 @@
+/******************************************************************************
+# Program Desc.:      This program is a website bookmarking program. The program
+#                     implements a hash table using chaining (pointer array of
+#                     linked lists) to store website information.
+# File:               sharded_table.h
+# File Description:   Header file for the ShardedTable class. Websites are
+#                     partitioned by topic hash into independent Table shards.
+#                     Each shard is owned by one thread that is the only one
+#                     to ever touch it (shared nothing); other threads send it
+#                     requests through its queue. Operations that cover every
+#                     topic are sent to all shards at once and merged.
+# Input:              None
+# Output:             None
+#******************************************************************************/
+#ifndef SHARDED_TABLE_H
+#define SHARDED_TABLE_H
+#include <iostream>
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <future>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include "table.h"
+#include "website.h"
+
+using namespace std;
+
+// ShardStats
+// Per shard counters. Only the shard's own thread writes them.
+struct ShardStats
+{
+   long long inserts = 0; // insert requests
+   long long retrieves = 0; // retrieve requests
+   long long edits = 0; // edit requests
+   long long scans = 0; // fan out requests (removeOneStar, displayAll, ...)
+   long long busyNanos = 0; // time spent running requests
+   int size = 0; // websites in the shard
+};
+
+class ShardedTable
+{
+public:
+   ShardedTable(int numShards = 0); // 0 means one shard per core
+   ~ShardedTable(); // stops and joins the shard threads
+   ShardedTable(const ShardedTable &) = delete;
+
+   bool insert(const Website& aWebsite); // add website to its shard
+   bool retrieve(const char * topic_keyword, Website all_matches[],
+                 int& num_found) const; // retrieve websites by topic keyword
+   bool edit(const char * searchTopic, const char * searchURL,
+             const char * newReview, int newRating); // edit review and rating
+   bool removeOneStar(); // remove 1 star websites from every shard
+   bool displayAll() const; // display every shard, in shard order
+   int getSize() const; // total websites over every shard
+   int getShardCount() const; // number of shards
+   ShardStats getStats(int shard) const; // counters of one shard
+   void loadFromFile(const char * filename); // load test data from file
+
+private:
+   // Shard
+   // One partition: its table, the thread that owns it and its queue.
+   // Aligned so two shards never share a cache line.
+   struct alignas(64) Shard
+   {
+      Table table;
+      ShardStats stats;
+      deque<function<void()> > queue; // requests waiting to run
+      mutex lock; // guards queue and stopping
+      condition_variable ready;
+      bool stopping = false;
+      thread worker;
+   };
+   vector<unique_ptr<Shard> > shards;
+
+   int shardOf(const char * topic) const; // which shard owns a topic
+   void workerLoop(Shard * shard); // shard thread body
+   void post(int shard, function<void()> request) const; // queue a request
+   template <class Result, class Function>
+   future<Result> submit(int shard, Function function) const;
+};
+
+// submit
+// Description: Sends a request to a shard's thread and returns a future for
+//              its result. The request runs with the shard's table and stats
+//              and is timed into the stats.
+// Input: shard - index of the shard, function - callable taking
+//        (Table &, ShardStats &) and returning Result
+// Output: future for the result
+template <class Result, class Function>
+future<Result> ShardedTable::submit(int shard, Function function) const
+{
+   shared_ptr<promise<Result> > result(new promise<Result>());
+   Shard * target = shards[shard].get();
+   post(shard, [target, function, result]() mutable
+   {
+      result->set_value(function(target->table, target->stats));
+   });
+   return result->get_future();
+}
+
+#endif
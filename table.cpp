@@ -10,6 +10,14 @@
 #******************************************************************************/
 #include "table.h"
 #include "website.h"
+#include "work_pool.h"
+#include "membership_filter.h"
+#include "record_parser.h"
+#include "perf_counters.h"
+
+#include <map>
+#include <climits>
+#include <algorithm>
 
 //Function Definitions
 
@@ -21,26 +29,198 @@ Table::Table()
 {  
    size = 0;
    currCapacity = INIT_CAP;
-   aTable = new Node*[currCapacity];
-   for (int i = 0; i < currCapacity; i++)
-   {
-      aTable[i] = nullptr;
-   }
+   aTable = new Buckets(currCapacity, 0, 0);
+   published = aTable;
+   filter = nullptr;
+   cache = nullptr;
+   eviction = nullptr;
 } 
 
+// Constructor (capacity)
+// Description: Initializes an empty hash table with at least capacity
+//              buckets, rounded up to the next prime of PrimeGrowth.
+// Input: capacity - the smallest number of buckets wanted
+Table::Table(int capacity)
+{
+   size = 0;
+   currCapacity = capacity > INIT_CAP ?
+                  (int)PrimeGrowth::nextCapacity(capacity - 1) : INIT_CAP;
+   aTable = new Buckets(currCapacity, 0, 0);
+   published = aTable;
+   filter = nullptr;
+   cache = nullptr;
+   eviction = nullptr;
+}
+
+// Constructor (capacity, hash seed)
+// Description: Same as Table(capacity), but topics are hashed with
+//              KeyedStringHash instead of TopicSumHash, keyed by hashSeed
+//              and ~hashSeed: a 64 bit key, handy for runs that have to be
+//              repeated from one number. Use the two seed constructor for
+//              the full 128 bit key.
+// Input: capacity - the smallest number of buckets wanted
+//        hashSeed - the hash key, 0 for TopicSumHash
+Table::Table(int capacity, uint64_t hashSeed)
+   : Table(capacity, hashSeed, ~hashSeed)
+{
+}
+
+// Constructor (capacity, two hash seeds)
+// Description: Same as Table(capacity), but topics are hashed with
+//              KeyedStringHash under the 128 bit key hashSeed, hashSeed2
+//              instead of TopicSumHash. Anagrams and other crafted topics
+//              then spread over the buckets like any others, so nobody who
+//              does not know the key can pile topics into one chain. Pass
+//              two randomSeed() (see basic_table.h) for a key nobody can
+//              guess; copies and snapshots keep the key.
+// Input: capacity - the smallest number of buckets wanted
+//        hashSeed, hashSeed2 - the two halves of the key; hashSeed 0 for
+//                              TopicSumHash
+Table::Table(int capacity, uint64_t hashSeed, uint64_t hashSeed2)
+   : Table(capacity)
+{
+   aTable->hashSeed = hashSeed;
+   aTable->hashSeed2 = hashSeed2;
+}
+
 // Copy constructor
 // Description: Copies the hash table from the table passed in
 //              into the new table. Uses overloaded assignment
 //              operator.
 Table::Table(const Table & table)
 {
-   /*  
    aTable = nullptr;
+   published = nullptr;
    size = 0;
-   */
+   currCapacity = 0;
+   filter = nullptr;
+   cache = nullptr;
+   eviction = nullptr;
    *this = table;
 }
 
+// Move constructor
+// Description: Takes over the bucket array of the table passed in, which is
+//              O(1). The moved from table is left empty but usable.
+Table::Table(Table && table)
+{
+   aTable = nullptr;
+   published = nullptr;
+   size = 0;
+   currCapacity = 0;
+   filter = nullptr;
+   cache = nullptr;
+   eviction = nullptr;
+   *this = std::move(table);
+}
+
+// assignment operator overload
+// Description: Deep copies the table passed in. Same capacity, same chain
+//              order, so the copy hashes and iterates identically.
+// Input: const Table & table
+// Output: Table & table
+const Table & Table::operator=(const Table & table)
+{
+   if (this != &table)
+   {
+      destroy();
+      copy(table);
+   }
+   return *this;
+}
+
+// move assignment operator overload
+// Description: Frees this table, then takes over the bucket array (and
+//              membership filter and result cache) of the table passed in.
+//              The moved from table gets a new empty bucket array and no
+//              filter or cache so it can still be used.
+// Input: Table && table
+// Output: Table & table
+const Table & Table::operator=(Table && table)
+{
+   if (this != &table)
+   {
+      destroy();
+      aTable = table.aTable;
+      published = aTable;
+      currCapacity = table.currCapacity;
+      size = table.size.load();
+      filter = table.filter;
+      table.filter = nullptr;
+      cache = table.cache;
+      table.cache = nullptr;
+      eviction = table.eviction;
+      table.eviction = nullptr;
+      table.currCapacity = INIT_CAP;
+      table.size = 0;
+      table.aTable = new Buckets(table.currCapacity, aTable->hashSeed,
+                                 aTable->hashSeed2);
+      table.published = table.aTable;
+   }
+   return *this;
+}
+
+// copy
+// Description: Deep copies the table passed in, in one pass. The bucket
+//              array is allocated at its final size up front, and each chain
+//              is built front to back so chain order is preserved. Nodes are
+//              allocated in table order, which keeps them close together.
+//              A resize in progress is copied as it stands, old buckets and
+//              all. The membership filter, if any, is copied as is; the copy
+//              gets an empty result cache of the same size.
+// Input: table - the table to copy
+// Output: None
+void Table::copy(const Table & table)
+{
+   currCapacity = table.currCapacity;
+   size = table.size.load();
+   aTable = new Buckets(currCapacity, table.aTable->hashSeed,
+                        table.aTable->hashSeed2);
+   published = aTable;
+   filter = table.filter ? new MembershipFilter(*table.filter) : nullptr;
+   cache = table.cache ? new QueryCache(table.cache->getMaxTopics()) :
+           nullptr;
+   eviction = table.eviction ? new Eviction(*table.eviction) : nullptr;
+   copyChains(table.aTable, aTable);
+   const Buckets * old = table.aTable->old;
+   if (old)
+   {
+      Buckets * oldCopy = new Buckets(old->capacity, old->hashSeed,
+                                      old->hashSeed2);
+      copyChains(old, oldCopy);
+      aTable->old = oldCopy;
+      aTable->migrated = table.aTable->migrated;
+   }
+}
+
+// copyChains
+// Description: Copies every chain of one bucket array into the empty bucket
+//              array of the same capacity passed in, front to back.
+// Input: from - the bucket array to copy
+//        to - the bucket array to fill
+// Output: None
+void Table::copyChains(const Buckets * from, Buckets * to)
+{
+   for (int i = 0; i < from->capacity; i++) // for each index in the table
+   {
+      Node * tail = nullptr;
+      for (Node * curr = from->heads[i]; curr; curr = curr->next)
+      {
+         Node * newNode = new Node(*curr->data);
+         copyUse(newNode, curr);
+         if (tail)
+         {
+            tail->next = newNode;
+         }
+         else
+         {
+            to->heads[i] = newNode;
+         }
+         tail = newNode;
+      }
+   }
+}
+
 // Destructor
 Table::~Table()
 {
@@ -57,375 +237,2811 @@ void Table::destroy()
 {
    if (aTable)
    {
-      for (int i = 0; i < currCapacity; i++)
-      {
-         if (aTable[i])
-         {
-            delete aTable[i];
-            aTable[i] = nullptr;
-         }
-      }
-      delete [] aTable;
+      published = nullptr;
+      release(aTable); // snapshots may still be holding the buckets
       aTable = nullptr;
    }
+   delete filter;
+   filter = nullptr;
+   delete cache;
+   cache = nullptr;
+   delete eviction;
+   eviction = nullptr;
 }
 
-// OPT TODO - Maybe create destroyChain here if needed 
-
-// Insert
-// Description: Inserts a website into the hash table. If the website
-//              already exists, the function returns false. If the
-//              website does not exist, the function inserts the
-//              website into the hash table and returns true.
-// Input: website - the website to be inserted
-// Output: true if the website was inserted, false if the website
-//         already exists
-bool Table::insert(Website& website)
+// Buckets constructor
+// Description: Allocates an array of capacity empty chains. The creator
+//              holds the only reference.
+// Input: capacity - number of buckets
+//        hashSeed, hashSeed2 - KeyedStringHash key, hashSeed 0 for
+//                              TopicSumHash
+// Output: None
+Table::Buckets::Buckets(int capacity, uint64_t hashSeed, uint64_t hashSeed2)
 {
-   int index = hash(website.getTopic()); // hash the topic
-   if (aTable[index]) // if the index is not null
+   this->capacity = capacity;
+   this->hashSeed = hashSeed;
+   this->hashSeed2 = hashSeed2;
+   growth.reset(capacity);
+   heads = new atomic<Node *>[capacity];
+   for (int i = 0; i < capacity; i++)
    {
-      Node * curr = aTable[index]; // set curr to the index
-      while (curr) // while curr is not null
-      {
-         if (*curr->data == website) // if the website already exists
-         {
-            return false;
-         }
-         curr = curr->next;
-      }
+      heads[i] = nullptr;
    }
-   Node * newNode = new Node(website);
-   newNode->next = aTable[index];
-   aTable[index] = newNode;
-   size++;
-   return true;
+   refs = 1;
+   old = nullptr;
+   migrated = 0;
+   memoryAllocated(MEM_INDEX, sizeof(Buckets));
+   memoryAllocated(MEM_INDEX, capacity * sizeof(Node*));
 }
 
-// hashing function 
-// Description: A naive hashing function that only adds the ASCII value of each 
-//              char in the key field and mods the capacity of the table. 
-//              "abc" and "cba" will result in the same index since it 
-//              doesn't consider position value.
-// Input: key - the key (Topic) to be hashed as a char *
-// Output: the index of the hash table as an int
-/*
-int Table::hash(const char * key) const
+// Buckets destructor
+// Description: Drops the reference this bucket array holds on every chain,
+//              and on the old array if it is still being migrated, then
+//              deallocates the array.
+Table::Buckets::~Buckets()
 {
-   int index = 0;
-   for (int i = 0; key[i] != '\0'; i++)
+   for (int i = 0; i < capacity; i++)
    {
-      index += key[i];
+      release(heads[i]);
+      heads[i] = nullptr;
    }
-   return index % currCapacity;
+   release(old.load());
+   old = nullptr;
+   delete [] heads;
+   heads = nullptr;
+   memoryFreed(MEM_INDEX, capacity * sizeof(Node*));
+   memoryFreed(MEM_INDEX, sizeof(Buckets));
 }
-*/
 
-// hashing function (recursive)
-// Description: A hasing function that recursivly adds the
-//             ASCII value of each char in the key field
-//             and mods the capacity of the table. "abc"
-//             and "cba" will result in the same index
-// Input: key - the key (Topic) to be hashed as a char *
-// Output: the index of the hash table as an int
+// release (chain)
+// Description: Drops one reference to the chain starting at head. Nodes are
+//              deleted front to back until a node that someone else still
+//              points to (a snapshot or another bucket array) is reached.
+//              A lock free reader may still be on a node whose last owner
+//              just let go (the live chain it was walking was replaced),
+//              so nodes are retired, and deleted once the readers that
+//              could have seen them have left (see epoch.h).
+// Input: head - first node of the chain, may be nullptr
+// Output: None
+void Table::release(Node * head)
+{
+   while (head && --head->refs == 0) // last owner of this node
+   {
+      Node * temp = head;
+      head = head->next;
+      epochRetire(temp);
+   }
+}
 
-int Table::hash(const char * key) const
+// release (buckets)
+// Description: Drops one reference to a bucket array and retires it when
+//              neither the table nor any snapshot uses it anymore; lock
+//              free readers that loaded it may still be walking it.
+// Input: buckets - the bucket array
+// Output: None
+void Table::release(Buckets * buckets)
 {
-   int returnVal = 0; // return value
-   //get length of key using strlen
-   int len = strlen(key);
-   //copy key into a new char array
-   char * newKey = new char[len + 1];
-   strcpy(newKey, key);
-   //call recursive helper function
-   returnVal = hashHelper(newKey, len - 1); // -1 because of null terminator
-   //delete newKey
-   delete [] newKey;
-   //return the return value
-   return returnVal % currCapacity;
+   if (buckets && --buckets->refs == 0)
+   {
+      epochRetire(buckets);
+   }
 }
 
+// detach
+// Description: Called before every write. If a snapshot shares the bucket
+//              array, the table gets its own copy of the array. The chains
+//              themselves stay shared (their heads just gain an owner) until
+//              ownChain() is called on them.
+// Input: None
+// Output: None
+void Table::detach()
+{
+   if (aTable->refs == 1) // nobody else is looking at the buckets
+   {
+      return;
+   }
+   Buckets * shared = aTable;
+   aTable = shareBuckets(shared);
+   published = aTable;
+   release(shared);
+}
 
-// hashing function (recursive) helper
-// Description: Recurisive helper function for the hash function
-// Input: key - the key (Topic) to be hashed as a char *
-// Output: the index of the hash table as an int
-int Table::hashHelper(char * key, int i) const
+// shareBuckets
+// Description: Makes a new bucket array with the same chains as the one
+//              passed in; every chain head gains an owner. The old array of
+//              a resize in progress is shared the same way (one more
+//              reference), along with how far its migration has got.
+// Input: buckets - the bucket array to copy
+// Output: the copy, which the caller owns
+Table::Buckets * Table::shareBuckets(const Buckets * buckets)
 {
-   if (i == -1) // base case (-1 to get index 0 char)
+   Buckets * copy = new Buckets(buckets->capacity, buckets->hashSeed,
+                                buckets->hashSeed2);
+   for (int i = 0; i < buckets->capacity; i++)
    {
-      return 0;
+      copy->heads[i] = buckets->heads[i].load();
+      if (copy->heads[i])
+      {
+         copy->heads[i].load()->refs++;
+      }
    }
-   else // recursive case
+   Buckets * old = buckets->old;
+   copy->old = old;
+   if (old)
    {
-      return key[i] + hashHelper(key, i - 1);
+      old->refs++;
    }
+   copy->migrated = buckets->migrated;
+   return copy;
 }
 
+// ownChain
+// Description: Called before a write to the chain at index (after detach).
+//              If any node on the chain is shared with a snapshot, the whole
+//              chain is copied (order preserved) so it can be changed in place
+//              without the snapshot seeing it. Chains are short, so copying
+//              the whole chain keeps every writer simple. The copy is built
+//              first and swapped in with one store, so lock free readers
+//              see one chain or the other.
+// Input: index - the index of the chain
+// Output: None
+void Table::ownChain(int index)
+{
+   ownChain(aTable, index);
+}
 
-// removeOneStar
-// Description: Removes all websites from the hash table with a rating of 1. 
-//              Decrements size after removal. Returns true if anything removed
-//              and false if nothing removed.
-// Input: None
-// Output: true if something removed, false if nothing removed
-bool Table::removeOneStar()
+// ownChain (static)
+// Description: Does the work for ownChain on the bucket array passed in,
+//              which the caller must own. Also used on the old array of a
+//              resize before its chains are moved.
+// Input: buckets - the bucket array, index - the index of the chain
+// Output: None
+void Table::ownChain(Buckets * buckets, int index)
 {
-   bool removed = false;
-   for (int i = 0; i < currCapacity; i++) // for each index in the table
+   Node * curr = buckets->heads[index];
+   while (curr && curr->refs == 1) // look for a shared node
+   {
+      curr = curr->next;
+   }
+   if (!curr) // chain is already ours
+   {
+      return;
+   }
+   Node * head = nullptr;
+   Node * tail = nullptr;
+   for (curr = buckets->heads[index]; curr; curr = curr->next)
    {
-      if (aTable[i]) // chain on index
+      Node * newNode = new Node(*curr->data);
+      newNode->marked = curr->marked;
+      copyUse(newNode, curr);
+      if (tail)
       {
-         Node * curr = aTable[i]; // set curr to the index
-         Node * prev = nullptr; // set prev to null
-         while (curr)
-         {
-            if (curr->data->getRating() == 1) // match
-            {
-               Node * temp = curr; // save curr node before deleting
-               if (prev) // removing in middle or at end
-               {
-                  prev->next = curr->next;
-               }
-               else // removing at beginning
-               {
-                  aTable[i] = curr->next;
-               }
-               curr = curr->next;
-               delete temp;
-               temp = nullptr;
-               size--;
-               removed = true;
-            }
-            else // no match
-            {
-               prev = curr;
-               curr = curr->next;
-            }
-         }
+         tail->next = newNode;
+      }
+      else
+      {
+         head = newNode;
       }
+      tail = newNode;
    }
-   return removed; // return true if something removed
+   Node * shared = buckets->heads[index];
+   buckets->heads[index] = head;
+   release(shared);
 }
 
-// retrieve
-// Description: Retrieves all websites matching search topic from the hash 
-//              table. If the websites exists, the function returns true and 
-//              the websites are passed back by reference to an array of
-//              websites. 
-// Input: searchTopic - the topic to search for
-//        websites - the array of websites to be passed back
-// Output: true if the websites were found, false if not
-bool Table::retrieve(const char * searchTopic, Website websites[], 
-                     int& num_found) const
+// Insert
+// Description: Inserts a website into the hash table. If the website
+//              already exists, the function returns false. If the
+//              website does not exist, the function inserts the
+//              website into the hash table and returns true. The
+//              website is placed with the rest of its topic, ordered
+//              by rating (see linkSorted). With the membership filter
+//              on, a URL the filter has never seen skips the duplicate
+//              search. Once there are more websites than buckets the table
+//              grows (see startResize).
+// Input: website - the website to be inserted
+// Output: true if the website was inserted, false if the website
+//         already exists
+bool Table::insert(const Website& website)
 {
-   bool found = false;
-   int index = hash(searchTopic); // hash the topic
-   if (aTable[index]) // if the index is not null
+   PerfScope scope(PERF_INSERT);
+   resizeStep(website.getTopic());
+   int index = hash(website.getTopic()); // hash the topic
+   uint64_t url = filter ? urlKey(website.getURL()) : 0;
+   if (aTable->heads[index] && (!filter || filter->mayContain(url)))
    {
-      Node * curr = aTable[index]; // set curr to the index 
-      int i = 0; // index for the websites array  
+      Node * curr = aTable->heads[index]; // set curr to the index
       while (curr) // while curr is not null
       {
-         if (strcmp(curr->data->getTopic(), searchTopic) == 0) // topic matches
+         if (*curr->data == website) // if the website already exists
          {
-            websites[i] = *curr->data; // copy website to array
-            i++;
-            found = true; // set found to true
+            return false;
          }
          curr = curr->next;
       }
-      num_found = i; // set num_found to the number of websites found
    }
-   return found;
+   detach();
+   ownChain(index);
+   Node * newNode = new Node(website);
+   linkSorted(index, newNode);
+   size++;
+   if (filter)
+   {
+      filter->add(topicKey(website.getTopic()));
+      filter->add(url);
+   }
+   if (cache)
+   {
+      cache->invalidate(topicKey(website.getTopic()));
+   }
+   if (eviction)
+   {
+      eviction->tick++;
+      touch(newNode, eviction);
+      eviction->stats.bytes += websiteBytes(website);
+      enforceBudget(newNode); // never evicts the website just inserted
+   }
+   if (size > currCapacity) // load factor over 1
+   {
+      finishResize(); // only if the last one has not finished already
+      startResize();
+   }
+   return true;
 }
 
-// edit
-// Description: Edits a website review and rating in the hash table. 
-//              If the website exists, the function returns true and the website
-//              is edited. If the website does not exist, the
-//              function returns false.
-// Input: website - the website to be edited
-// Output: true if the website was edited, false if the website does not exist
-bool Table::edit(char * searchTopic, char * searchURL, char * newReview,
-                 int newRating)
+// linkSorted
+// Description: Links a node into the chain at index so that websites with the
+//              same topic stay next to each other, highest rating first. Ties
+//              keep insertion order. A topic not yet in the chain goes at the
+//              head, like a plain chained insert. This ordering is what lets
+//              topK return the best websites without sorting. The chain must
+//              already be owned by the table (ownChain). The node's next is
+//              set before the store that links it in, so a lock free reader
+//              either sees it whole or not at all.
+// Input: index - the index of the chain
+//        newNode - the node to link in
+// Output: None
+void Table::linkSorted(int index, Node * newNode)
 {
-   int index = hash(searchTopic); // hash the topic
-   if (aTable[index]) // if the index is not null
+   const char * topic = newNode->data->getTopic();
+   int rating = newNode->data->getRating();
+   Node * prev = nullptr;
+   Node * curr = aTable->heads[index];
+   while (curr && strcmp(curr->data->getTopic(), topic) != 0) // find topic
    {
-      Node * curr = aTable[index]; // set curr to the index
-      while (curr) // while curr is not null
+      prev = curr;
+      curr = curr->next;
+   }
+   if (curr) // topic found, skip websites rated the same or higher
+   {
+      while (curr && strcmp(curr->data->getTopic(), topic) == 0 &&
+             curr->data->getRating() >= rating)
       {
-         if (strcmp(curr->data->getTopic(), searchTopic) == 0 && 
-             strcmp(curr->data->getURL(), searchURL) == 0) // match
-         {
-            curr->data->setReview(newReview);
-            curr->data->setRating(newRating);
-            return true;
-         }
+         prev = curr;
          curr = curr->next;
       }
    }
-   return false;
+   else // new topic for this chain, insert at the beginning
+   {
+      prev = nullptr;
+      curr = aTable->heads[index];
+   }
+   newNode->next = curr;
+   if (prev) // inserting in middle or at end
+   {
+      prev->next = newNode;
+   }
+   else // inserting at beginning
+   {
+      aTable->heads[index] = newNode;
+   }
 }
 
-// displayAll
-// Description: Displays all websites in the hash table. If the hash table is
-//              empty, the function returns false. If the hash table is not
-//              empty, the function returns true.
-// Input: None
-// Output: true if the hash table is not empty, false if the hash table is
-//         empty
-bool Table::displayAll() const
+// insertBulk
+// Description: Inserts count websites with the same result as calling insert
+//              on each in order: a website whose URL is already in its
+//              chain, or earlier in the batch, is rejected, and every
+//              topic's run ends up in the same order (rating, then insertion
+//              order). Instead of one chain walk per website it hashes every
+//              topic once, groups the websites by bucket with a counting
+//              sort (one radix pass whose digit is the bucket index), finds
+//              duplicate URLs by sorting each bucket's group, and merges
+//              each group into its chain with one more walk while the chain
+//              is still in cache. Separate inserts grow the table one
+//              capacity at a time, and a URL filed under two topics is only
+//              a duplicate if the topics share a chain at the capacity of
+//              the insert, and while a resize is moving buckets, only once
+//              the other topic's bucket has moved. So the batch goes in
+//              phases, one per capacity, each taking the websites up to the
+//              one whose insert would grow the table, and decided against
+//              what insert would have migrated by then (see BulkPhase). The
+//              table is left with the buckets migrated that the inserts
+//              would leave, so the next batch or insert sees what it would
+//              have. Topics can sit in a different order along a chain than
+//              separate inserts would leave them, like after a resize. With
+//              a budget set it falls back to insert, since eviction decides
+//              after every website.
+// Input: websites - the websites to be inserted
+//        count - the number of websites
+// Output: the number of websites inserted
+int Table::insertBulk(const Website websites[], int count)
 {
-   if (size == 0) // if the hash table is empty
+   if (eviction)
    {
-      return false;
+      int inserted = 0;
+      for (int i = 0; i < count; i++)
+      {
+         inserted += insert(websites[i]);
+      }
+      return inserted;
    }
-   for (int i = 0; i < currCapacity; i++) // for each index in the table
+   PerfScope scope(PERF_BULK);
+   vector<BulkEntry> entries(count);
+   for (int i = 0; i < count; i++)
+   {
+      entries[i].topic = websites[i].getTopic();
+      entries[i].url = websites[i].getURL();
+      entries[i].rating = websites[i].getRating();
+      entries[i].hash = topicHash(entries[i].topic, aTable);
+      entries[i].site = i;
+   }
+   BulkPhase phase;
+   vector<BulkEntry> window;
+   vector<int> chains;
+   vector<int> bounds;
+   vector<BulkGroup> groups;
+   vector<BulkGroup *> fresh;
+   int inserted = 0;
+   int done = 0;
+   beginPhase(phase, 0, count); // a resize may be part way through already
+   while (done < count)
    {
-      if (aTable[i]) // chain on index
+      // a window never runs past the insert that would grow the table, so
+      // each chain can be decided and linked in one go
+      int length = min(count - done, phaseRoom());
+      window.assign(entries.begin() + done, entries.begin() + done + length);
+      moveOldBuckets(phase, window);
+      partitionBulk(window, chains, bounds);
+      detach();
+      int linked = 0;
+      for (size_t i = 0; i < chains.size(); i++)
       {
-         Node * curr = aTable[i]; // set curr to the index   
-         while (curr) // while curr is not null
-         {
-            curr->data->display(); // display the website
-            cout << endl;
-            curr = curr->next;
-         }
+         BulkEntry * first = window.data() + bounds[i];
+         BulkEntry * last = window.data() + bounds[i + 1];
+         rejectDuplicates(chains[i], first, last, phase);
+         linked += mergeBulk(chains[i], websites, first, last, groups,
+                             fresh);
+      }
+      size += linked;
+      inserted += linked;
+      done += length;
+      if (size > currCapacity) // the last insert of the window would grow
+      {
+         finishResize();
+         startResize();
+         beginPhase(phase, done, count);
       }
    }
-   return true;
+   return inserted;
 }
 
-// displayAll (overloaded)
-// Description: Displays all websites matching search topic from the hash
-//              table. If the websites exists, the function returns true and
-//              the websites are displayed. If the websites do not exist, the
-//              function returns false.
-// Input: searchTopic - the topic to search for
-// Output: true if the websites were found, false if not
-bool Table::displayAll(char * searchTopic) const
+// phaseRoom
+// Description: How many more websites the table takes before an insert
+//              grows it; unlimited at the largest capacity.
+// Input: None
+// Output: the number of websites
+int Table::phaseRoom() const
 {
-   bool found = false;
-   int index = hash(searchTopic); // hash the topic
-   if (aTable[index]) // if the index is not null
+   if (PrimeGrowth::nextCapacity(currCapacity) <= (size_t)currCapacity)
    {
-      Node * curr = aTable[index]; // set curr to the index
-      while (curr) // while curr is not null
-      {
-         if (strcmp(curr->data->getTopic(), searchTopic) == 0) // match
-         {
-            curr->data->display(); // display the website
-            cout << endl;
-            found = true; // set found to true
-         }
-         curr = curr->next;
-      }
+      return INT_MAX;
    }
-   return found;
+   return max(currCapacity + 1 - size, 1);
 }
 
-// monitor
-// Description: Displays the length of a chain at a given index in the hash
-//              table, 0 if the index is empty, and -1 if the index is out of
-//              bounds.
-// Input: index - the index to be monitored
-// Output: the length of the chain at the index, 0 if the index is empty, and
-//         -1 if the index is out of bounds
-int Table::monitor(int index) const
+// beginPhase
+// Description: Records what separate inserts starting at website start of
+//              a batch would find of the resize in progress, if any: the
+//              old bucket array's capacity, how far its in order migration
+//              has got, and which old buckets are already empty (moved).
+//              If those inserts would finish the migration before the
+//              phase ends, it is finished now, in order.
+// Input: phase - set up here
+//        start - index in the batch of the phase's first website
+//        count - websites in the batch
+// Output: None
+void Table::beginPhase(BulkPhase & phase, int start, int count)
 {
-   if (index < 0 || index >= currCapacity) // if the index is out of bounds
+   const Buckets * old = aTable->old;
+   phase.start = start;
+   phase.oldCapacity = old ? old->capacity : 0;
+   phase.migrated = old ? aTable->migrated : 0;
+   phase.touched.assign(phase.oldCapacity, INT_MAX);
+   if (!old)
    {
-      return -1;
+      return;
    }
-   if (!aTable[index]) // if the index is empty
+   phase.oldGrowth = old->growth;
+   for (int i = 0; i < old->capacity; i++)
    {
-      return 0;
+      if (i < aTable->migrated || !old->heads[i])
+      {
+         phase.touched[i] = -1;
+      }
    }
-   int length = 0;
-   Node * curr = aTable[index]; // set curr to the index
-   while (curr) // while curr is not null
+   long long room = min(phaseRoom(), count - start);
+   if (count - start >= phaseRoom() &&
+       phase.migrated + MIGRATE_STEP * room >= phase.oldCapacity)
    {
-      length++;
-      curr = curr->next;
+      finishResize(); // the phase's inserts would have moved everything
    }
-   return length;
+}
+
+// moveOldBuckets
+// Description: Migrates what the separate inserts of an insertBulk window
+//              would have: each one's own topic's old bucket and the next
+//              MIGRATE_STEP in order (see resizeStep). Records, for every
+//              old bucket, the place in the phase of the first website that
+//              would move it, so websites before it are not taken for
+//              duplicates of what it held (see BulkPhase).
+// Input: phase - the phase, window - websites in batch order
+// Output: None
+void Table::moveOldBuckets(BulkPhase & phase,
+                           const vector<BulkEntry> & window)
+{
+   if (phase.oldCapacity == 0)
+   {
+      return;
+   }
+   bool migrating = aTable->old != nullptr; // not finished already
+   if (migrating)
+   {
+      detach();
+   }
+   for (size_t i = 0; i < window.size(); i++)
+   {
+      int bucket = (int)phase.oldGrowth.index(window[i].hash);
+      if (phase.touched[bucket] == INT_MAX) // first to move it
+      {
+         phase.touched[bucket] = window[i].site - phase.start;
+         if (migrating)
+         {
+            migrateBucket(bucket);
+         }
+      }
+   }
+   if (!migrating)
+   {
+      return;
+   }
+   long long target = (long long)phase.migrated + (long long)MIGRATE_STEP *
+                      (window.back().site + 1 - phase.start);
+   migrateSome((int)min(target, (long long)phase.oldCapacity) -
+               aTable->migrated);
+}
+
+// BulkPhase::moved
+// Description: Whether insert number place of the phase would find the
+//              websites of an old bucket moved to the new array (after its
+//              resizeStep), where its duplicate check can see them.
+// Input: bucket - index in the old array, -1 if there was no resize
+//        place - insert number in the phase
+// Output: true if moved by then
+bool Table::BulkPhase::moved(int bucket, int place) const
+{
+   return bucket < 0 ||
+          bucket < migrated + MIGRATE_STEP * ((long long)place + 1) ||
+          touched[bucket] <= place;
+}
+
+// partitionBulk
+// Description: Reorders an insertBulk window by bucket of the current
+//              bucket array with a stable counting sort: count the websites
+//              per bucket, turn the counts into start offsets, then
+//              scatter. A window much smaller than the array is sorted by
+//              bucket instead, so it does not pay for every bucket.
+// Input: entries - the window, reordered
+//        chains - passed back: the buckets with websites, in order
+//        bounds - passed back: chain i's are entries[bounds[i]] up to but
+//                 not including entries[bounds[i + 1]]
+// Output: None
+void Table::partitionBulk(vector<BulkEntry> & entries, vector<int> & chains,
+                          vector<int> & bounds) const
+{
+   for (size_t i = 0; i < entries.size(); i++)
+   {
+      entries[i].bucket = (int)aTable->growth.index(entries[i].hash);
+   }
+   if (entries.size() < (size_t)currCapacity / 64)
+   {
+      sort(entries.begin(), entries.end(), [](const BulkEntry & a,
+                                              const BulkEntry & b)
+      {
+         return a.bucket < b.bucket;
+      });
+   }
+   else
+   {
+      vector<int> starts(currCapacity + 1, 0);
+      for (size_t i = 0; i < entries.size(); i++)
+      {
+         starts[entries[i].bucket + 1]++;
+      }
+      for (int i = 0; i < currCapacity; i++)
+      {
+         starts[i + 1] += starts[i];
+      }
+      vector<BulkEntry> sorted(entries.size());
+      for (size_t i = 0; i < entries.size(); i++)
+      {
+         sorted[starts[entries[i].bucket]++] = entries[i];
+      }
+      entries.swap(sorted);
+   }
+   chains.clear();
+   bounds.clear();
+   for (size_t i = 0; i < entries.size(); i++)
+   {
+      if (i == 0 || entries[i].bucket != entries[i - 1].bucket)
+      {
+         chains.push_back(entries[i].bucket);
+         bounds.push_back((int)i);
+      }
+   }
+   bounds.push_back((int)entries.size());
+}
+
+// rejectDuplicates
+// Description: Marks the websites of one bucket's group that insert would
+//              reject. The group is sorted by URL and then by place in the
+//              batch, and one walk of the chain finds the websites with
+//              those URLs (moveOldBuckets has already moved every old
+//              bucket the window could see). Going through a URL's
+//              websites in batch order, one is rejected if an earlier one
+//              was taken (it went into this chain) or a website in the
+//              chain with its URL is one insert would see: of its own
+//              topic, or of a topic whose old bucket had moved by then
+//              (see BulkPhase).
+// Input: index - the bucket
+//        first, last - its websites, from partitionBulk
+//        phase - what separate inserts would see of a resize
+// Output: None
+void Table::rejectDuplicates(int index, BulkEntry * first, BulkEntry * last,
+                             const BulkPhase & phase) const
+{
+   if (last - first > 1)
+   {
+      sort(first, last, [](const BulkEntry & a, const BulkEntry & b)
+      {
+         int order = strcmp(a.url, b.url);
+         return order < 0 || (order == 0 && a.site < b.site);
+      });
+   }
+   vector<pair<BulkEntry *, int> > clashes; // URL's first entry, old bucket
+   for (Node * curr = aTable->heads[index]; curr; curr = curr->next)
+   {
+      const char * url = curr->data->getURL();
+      BulkEntry * entry = first;
+      if (last - first > 1)
+      {
+         entry = lower_bound(first, last, url,
+            [](const BulkEntry & a, const char * key)
+            {
+               return strcmp(a.url, key) < 0;
+            });
+      }
+      if (entry < last && strcmp(entry->url, url) == 0)
+      {
+         int bucket = phase.oldCapacity == 0 ? -1 : (int)phase.oldGrowth
+            .index(topicHash(curr->data->getTopic(), aTable));
+         clashes.push_back(make_pair(entry, bucket));
+      }
+   }
+   if (clashes.size() > 1)
+   {
+      sort(clashes.begin(), clashes.end());
+   }
+   size_t clash = 0;
+   for (BulkEntry * run = first; run < last; ) // one URL at a time
+   {
+      BulkEntry * runEnd = run + 1;
+      while (runEnd < last && strcmp(runEnd->url, run->url) == 0)
+      {
+         runEnd++;
+      }
+      size_t clashEnd = clash;
+      while (clashEnd < clashes.size() && clashes[clashEnd].first == run)
+      {
+         clashEnd++;
+      }
+      bool taken = false;
+      for (BulkEntry * entry = run; entry < runEnd; entry++)
+      {
+         int place = entry->site - phase.start;
+         entry->rejected = taken;
+         for (size_t j = clash; j < clashEnd && !entry->rejected; j++)
+         {
+            entry->rejected = phase.moved(clashes[j].second, place);
+         }
+         taken = taken || !entry->rejected;
+      }
+      clash = clashEnd;
+      run = runEnd;
+   }
+}
+
+// mergeBulk
+// Description: Links one bucket's websites from an insertBulk batch into
+//              its chain in one walk. They are sorted by topic, rating
+//              (highest first) and place in the batch. Websites of a topic
+//              already in the chain are linked into its run after every
+//              website rated the same or higher, as linkSorted would. New
+//              topics go at the head, the one that came first in the batch
+//              nearest the old head, as separate inserts would leave them.
+//              A single website is linked in by linkSorted. Each node's
+//              next is set before the one store that links it in, and the
+//              new topics are linked to each other before their head is
+//              stored, so lock free readers see whole runs.
+// Input: index - the index of the chain
+//        websites - the batch
+//        first, last - the bucket's entries from rejectDuplicates
+//        groups, fresh - scratch, kept from chain to chain
+// Output: the number of websites linked in
+int Table::mergeBulk(int index, const Website websites[], BulkEntry * first,
+                     BulkEntry * last, vector<BulkGroup> & groups,
+                     vector<BulkGroup *> & fresh)
+{
+   sort(first, last, [](const BulkEntry & a, const BulkEntry & b)
+   {
+      if (a.rejected != b.rejected)
+      {
+         return b.rejected; // rejected ones last
+      }
+      int order = strcmp(a.topic, b.topic);
+      if (order != 0)
+      {
+         return order < 0;
+      }
+      if (a.rating != b.rating)
+      {
+         return a.rating > b.rating;
+      }
+      return a.site < b.site;
+   });
+   groups.clear();
+   for (BulkEntry * entry = first; entry < last && !entry->rejected; entry++)
+   {
+      if (groups.empty() ||
+          strcmp(entry->topic, groups.back().first->topic) != 0)
+      {
+         groups.push_back({ entry, entry, entry->site, false });
+      }
+      BulkGroup & group = groups.back();
+      group.last = entry + 1;
+      group.firstSite = min(group.firstSite, entry->site);
+   }
+   if (groups.empty())
+   {
+      return 0;
+   }
+   ownChain(index);
+   int linked = 1;
+   if (last - first == 1) // one website: link it in as insert would
+   {
+      linkSorted(index, new Node(websites[first->site]));
+   }
+   else
+   {
+      linked = mergeRuns(index, websites, groups, fresh);
+   }
+   for (size_t i = 0; i < groups.size(); i++)
+   {
+      const char * topic = groups[i].first->topic;
+      if (filter)
+      {
+         filter->add(topicKey(topic));
+         for (BulkEntry * entry = groups[i].first; entry < groups[i].last;
+              entry++)
+         {
+            filter->add(urlKey(entry->url));
+         }
+      }
+      if (cache)
+      {
+         cache->invalidate(topicKey(topic));
+      }
+   }
+   return linked;
+}
+
+// mergeRuns
+// Description: Does the linking for mergeBulk: one walk of the chain links
+//              each topic's websites into its run, then the topics new to
+//              the chain go at its head, the one first in the batch last.
+// Input: index - the index of the chain, owned by the table
+//        websites - the batch
+//        groups - the chain's topics, sorted by topic
+//        fresh - scratch space
+// Output: the number of websites linked in
+int Table::mergeRuns(int index, const Website websites[],
+                     vector<BulkGroup> & groups, vector<BulkGroup *> & fresh)
+{
+   int linked = 0;
+   Node * prev = nullptr;
+   Node * curr = aTable->heads[index];
+   while (curr) // one run of the chain per pass
+   {
+      const char * topic = curr->data->getTopic();
+      vector<BulkGroup>::iterator group = groups.begin();
+      if (groups.size() > 1)
+      {
+         group = lower_bound(groups.begin(), groups.end(), topic,
+            [](const BulkGroup & a, const char * key)
+            {
+               return strcmp(a.first->topic, key) < 0;
+            });
+      }
+      if (group != groups.end() &&
+          strcmp(group->first->topic, topic) == 0)
+      {
+         for (BulkEntry * entry = group->first; entry < group->last; entry++)
+         {
+            int rating = entry->rating;
+            while (curr && strcmp(curr->data->getTopic(), topic) == 0 &&
+                   curr->data->getRating() >= rating)
+            {
+               prev = curr;
+               curr = curr->next;
+            }
+            Node * newNode = new Node(websites[entry->site]);
+            newNode->next = curr;
+            if (prev)
+            {
+               prev->next = newNode;
+            }
+            else
+            {
+               aTable->heads[index] = newNode;
+            }
+            prev = newNode;
+            linked++;
+         }
+         group->linked = true;
+      }
+      while (curr && strcmp(curr->data->getTopic(), topic) == 0) // run's end
+      {
+         prev = curr;
+         curr = curr->next;
+      }
+   }
+   fresh.clear(); // topics new to the chain, last one first
+   for (size_t i = 0; i < groups.size(); i++)
+   {
+      if (!groups[i].linked)
+      {
+         fresh.push_back(&groups[i]);
+      }
+   }
+   if (!fresh.empty())
+   {
+      sort(fresh.begin(), fresh.end(), [](const BulkGroup * a,
+                                          const BulkGroup * b)
+      {
+         return a->firstSite > b->firstSite;
+      });
+      linked += linkFresh(index, websites, fresh);
+   }
+   return linked;
+}
+
+// linkFresh
+// Description: Links the topics of an insertBulk batch that are new to a
+//              chain at its head, in the order given, each run already in
+//              rating order. The runs are linked to each other and to the
+//              old head before one store publishes them.
+// Input: index - the index of the chain
+//        websites - the batch
+//        fresh - the new topics, the one to end up at the head first
+// Output: the number of websites linked in
+int Table::linkFresh(int index, const Website websites[],
+                     vector<BulkGroup *> & fresh)
+{
+   int linked = 0;
+   Node * head = nullptr;
+   Node * tail = nullptr;
+   for (size_t i = 0; i < fresh.size(); i++)
+   {
+      for (BulkEntry * entry = fresh[i]->first; entry < fresh[i]->last;
+           entry++)
+      {
+         Node * newNode = new Node(websites[entry->site]);
+         if (tail)
+         {
+            tail->next = newNode;
+         }
+         else
+         {
+            head = newNode;
+         }
+         tail = newNode;
+         linked++;
+      }
+   }
+   tail->next = aTable->heads[index].load();
+   aTable->heads[index] = head;
+   return linked;
+}
+
+// hashing function 
+// Description: A naive hashing function that only adds the ASCII value of each 
+//              char in the key field and mods the capacity of the table. 
+//              "abc" and "cba" will result in the same index since it 
+//              doesn't consider position value.
+// Input: key - the key (Topic) to be hashed as a char *
+// Output: the index of the hash table as an int
+/*
+int Table::hash(const char * key) const
+{
+   int index = 0;
+   for (int i = 0; key[i] != '\0'; i++)
+   {
+      index += key[i];
+   }
+   return index % currCapacity;
+}
+*/
+
+// hashing function
+// Description: Maps a topic to its bucket in the table's current bucket
+//              array (see hashIndex). A table built with a seed hashes with
+//              the keyed SipHash (KeyedStringHash), so no one who does not
+//              know the seed can pile topics into one chain. Without a seed
+//              it adds the chars (TopicSumHash), where "abc" and "cba" land
+//              in the same bucket. Either way PrimeGrowth takes the hash mod
+//              the prime capacity.
+// Input: key - the key (Topic) to be hashed as a char *
+// Output: the index of the hash table as an int
+
+int Table::hash(const char * key) const
+{
+   return hashIndex(key, aTable);
+}
+
+// hashIndex
+// Description: Hashes the key with TopicSumHash (adds the chars), or with
+//              KeyedStringHash if the buckets have a seed, and maps
+//              it to a bucket of the bucket array passed in with its
+//              PrimeGrowth policy, which does the mod by the prime capacity
+//              with a precomputed fast modulo instead of a divide. Static so
+//              snapshots, which keep their own buckets, hash the same way
+//              the table does.
+// Input: key - the key (Topic) to be hashed as a char *
+//        buckets - the bucket array to index into
+// Output: the index of the bucket as an int
+int Table::hashIndex(const char * key, const Buckets * buckets)
+{
+   return (int)buckets->growth.index(topicHash(key, buckets));
+}
+
+// topicHash
+// Description: The hash hashIndex maps to a bucket, before the mod. It only
+//              depends on the seed, so insertBulk hashes each topic once
+//              and maps it again after the table grows.
+// Input: key - the key (Topic) to be hashed as a char *
+//        buckets - the bucket array whose seed is used
+// Output: the hash
+size_t Table::topicHash(const char * key, const Buckets * buckets)
+{
+   if (buckets->hashSeed)
+   {
+      return KeyedStringHash(buckets->hashSeed, buckets->hashSeed2)(key);
+   }
+   return TopicSumHash()(key);
+}
+
+// findRun
+// Description: Returns the first website of a topic's run (see linkSorted).
+//              While a resize is in progress a topic stays in its old
+//              bucket until that bucket is migrated, so the old chain is
+//              searched first and the new one if the topic is not there.
+//              migrateBucket links each run into the new array before it
+//              cuts it out of the old one, so a lock free reader racing a
+//              migration finds the run in one or the other.
+// Input: topic - the topic
+//        buckets - the bucket array to look in
+// Output: the topic's first node, nullptr if it is not there
+Table::Node * Table::findRun(const char * topic, const Buckets * buckets)
+{
+   const Buckets * old = buckets->old;
+   Node * curr = nullptr;
+   if (old)
+   {
+      curr = old->heads[hashIndex(topic, old)];
+      while (curr && strcmp(curr->data->getTopic(), topic) != 0)
+      {
+         curr = curr->next;
+      }
+   }
+   if (!curr)
+   {
+      curr = buckets->heads[hashIndex(topic, buckets)];
+      while (curr && strcmp(curr->data->getTopic(), topic) != 0)
+      {
+         curr = curr->next;
+      }
+   }
+   return curr;
+}
+
+// chainCount
+// Description: Number of chains a scan has to walk: every bucket of the
+//              array, then the old buckets not migrated yet.
+// Input: buckets - the bucket array
+// Output: the number of chains
+int Table::chainCount(const Buckets * buckets)
+{
+   const Buckets * old = buckets->old;
+   return buckets->capacity + (old ? old->capacity - buckets->migrated : 0);
+}
+
+// chainAt
+// Description: Returns chain number chain of a scan (see chainCount).
+// Input: buckets - the bucket array
+//        chain - from 0 to chainCount(buckets) - 1
+// Output: the head of the chain, nullptr if it is empty
+Table::Node * Table::chainAt(const Buckets * buckets, int chain)
+{
+   if (chain < buckets->capacity)
+   {
+      return buckets->heads[chain];
+   }
+   const Buckets * old = buckets->old;
+   return old->heads[buckets->migrated + chain - buckets->capacity];
+}
+
+// isResizing
+// Description: Returns true while a resize is moving old buckets over.
+bool Table::isResizing() const
+{
+   return aTable->old != nullptr;
+}
+
+// startResize
+// Description: Grows the table to the next PrimeGrowth capacity without
+//              rehashing anything yet. The current bucket array becomes the
+//              old array of a new, empty one; every write then moves its
+//              own topic's old bucket and MIGRATE_STEP more (see
+//              resizeStep). With load factor 1 at the start and at least
+//              that many inserts before the next resize, every old bucket
+//              has moved by then, so no single operation ever pays for a
+//              whole rehash. Reads look in both arrays (see findRun).
+// Input: minCapacity - keep growing to at least this many buckets
+//                      (insertBulk grows once for a whole batch)
+// Output: None
+void Table::startResize(int minCapacity)
+{
+   int capacity = (int)PrimeGrowth::nextCapacity(currCapacity);
+   if (capacity <= currCapacity) // already the largest prime
+   {
+      return;
+   }
+   while (capacity < minCapacity)
+   {
+      int bigger = (int)PrimeGrowth::nextCapacity(capacity);
+      if (bigger <= capacity)
+      {
+         break;
+      }
+      capacity = bigger;
+   }
+   Buckets * bigger = new Buckets(capacity, aTable->hashSeed,
+                                  aTable->hashSeed2);
+   bigger->old = aTable; // takes over the table's reference
+   aTable = bigger;
+   published = aTable;
+   currCapacity = capacity;
+   migrateSome(MIGRATE_STEP);
+}
+
+// resizeStep
+// Description: Called by every write while a resize is in progress. Moves
+//              the old bucket of the topic about to be written, so the
+//              write only has to deal with the new array, then moves the
+//              next MIGRATE_STEP old buckets in order.
+// Input: topic - the topic about to be written
+// Output: None
+void Table::resizeStep(const char * topic)
+{
+   const Buckets * old = aTable->old;
+   if (!old)
+   {
+      return;
+   }
+   int index = hashIndex(topic, old);
+   if (old->heads[index])
+   {
+      detach();
+      migrateBucket(index);
+   }
+   migrateSome(MIGRATE_STEP);
+}
+
+// migrateSome
+// Description: Moves the next count old buckets, in index order, and drops
+//              the old array once the last one has moved.
+// Input: count - the most old buckets to move
+// Output: None
+void Table::migrateSome(int count)
+{
+   if (!aTable->old)
+   {
+      return;
+   }
+   detach();
+   int capacity = aTable->old.load()->capacity;
+   for (int i = 0; i < count && aTable->migrated < capacity; i++)
+   {
+      migrateBucket(aTable->migrated);
+      aTable->migrated++;
+   }
+   if (aTable->migrated >= capacity) // resize finished
+   {
+      Buckets * old = aTable->old;
+      aTable->old = nullptr; // readers that still have it may finish
+      aTable->migrated = 0;
+      release(old);
+   }
+}
+
+// migrateBucket
+// Description: Moves one old chain into the new array (which the table
+//              must own) and leaves the old bucket empty. Each topic run is
+//              moved whole to the head of its new chain, which keeps topics
+//              together and in rating order (see linkSorted) and moves
+//              nodes without copying them. Runs go last first: the last
+//              run ends the chain, so it can be linked into the new chain
+//              while still in the old one and only then cut off, and a
+//              lock free reader (see findRun) always finds it in one of
+//              them. If a snapshot shares the old array or the chain, they
+//              are copied first, so the snapshot still sees the chain where
+//              it was.
+// Input: index - the index of the chain in the old array
+// Output: None
+void Table::migrateBucket(int index)
+{
+   Buckets * old = aTable->old;
+   if (!old->heads[index])
+   {
+      return;
+   }
+   if (old->refs > 1)
+   {
+      Buckets * copy = shareBuckets(old);
+      aTable->old = copy;
+      release(old);
+      old = copy;
+   }
+   ownChain(old, index);
+   while (old->heads[index])
+   {
+      Node * before = nullptr; // last node before the last run
+      Node * first = old->heads[index];
+      Node * last = first;
+      while (last->next)
+      {
+         if (strcmp(last->next.load()->data->getTopic(),
+                    last->data->getTopic()) != 0) // a new run starts
+         {
+            before = last;
+            first = last->next;
+         }
+         last = last->next;
+      }
+      int to = hashIndex(first->data->getTopic(), aTable);
+      last->next = aTable->heads[to].load();
+      aTable->heads[to] = first;
+      if (before) // cut the run off the old chain
+      {
+         before->next = nullptr;
+      }
+      else
+      {
+         old->heads[index] = nullptr;
+      }
+   }
+}
+
+// finishResize
+// Description: Moves every old bucket left, for whole table writes
+//              (removeOneStar, merge sweeps) that want one bucket array.
+// Input: None
+// Output: None
+void Table::finishResize()
+{
+   const Buckets * old = aTable->old;
+   if (old)
+   {
+      migrateSome(old->capacity - aTable->migrated);
+   }
+}
+
+
+// removeOneStar
+// Description: Removes all websites from the hash table with a rating of 1. 
+//              Decrements size after removal. Returns true if anything removed
+//              and false if nothing removed.
+// Input: None
+// Output: true if something removed, false if nothing removed
+bool Table::removeOneStar()
+{
+   PerfScope scope(PERF_REMOVE);
+   bool removed = false;
+   vector<uint64_t> forgotten; // filter keys of removed websites
+   finishResize();
+   for (int i = 0; i < currCapacity; i++) // for each index in the table
+   {
+      if (hasOneStar(aTable->heads[i])) // look for a match before copying
+      {
+         detach();
+         size -= purgeChain(i, isOneStar, filter || cache ? &forgotten :
+                                                           nullptr);
+         removed = true;
+      }
+   }
+   forget(forgotten);
+   if (eviction && removed)
+   {
+      eviction->stats.bytes = countBytes();
+   }
+   return removed; // return true if something removed
+}
+
+// removeOneStar (parallel)
+// Description: Same result as removeOneStar, but bucket ranges are purged
+//              in parallel on the pool. Every chain is independent, so each
+//              chunk owns its buckets outright; the per chunk removal
+//              counts and filter keys are merged at the end, so the filter
+//              and cache are only changed by this thread.
+// Input: pool - the threads to use
+// Output: true if something removed, false if nothing removed
+bool Table::removeOneStar(WorkStealingPool & pool)
+{
+   PerfScope scope(PERF_REMOVE);
+   finishResize(); // one bucket array to split between threads
+   detach(); // once, before the bucket array is shared between threads
+   vector<int> removed(currCapacity / scanGrain(pool) + 1, 0);
+   vector<vector<uint64_t> > forgotten(removed.size());
+   pool.parallelFor(0, currCapacity, scanGrain(pool),
+      [this, &removed, &forgotten](int begin, int end, int chunk)
+      {
+         for (int i = begin; i < end; i++)
+         {
+            if (hasOneStar(aTable->heads[i]))
+            {
+               removed[chunk] += purgeChain(i, isOneStar, filter || cache ?
+                                                &forgotten[chunk] : nullptr);
+            }
+         }
+      });
+   int total = 0;
+   for (size_t i = 0; i < removed.size(); i++)
+   {
+      total += removed[i];
+      forget(forgotten[i]);
+   }
+   size -= total;
+   if (eviction && total > 0)
+   {
+      eviction->stats.bytes = countBytes();
+   }
+   return total > 0;
+}
+
+// hasOneStar
+// Description: Checks a chain for a website with a rating of 1.
+// Input: head - the chain
+// Output: true if there is one
+bool Table::hasOneStar(const Node * head)
+{
+   while (head && head->data->getRating() != 1)
+   {
+      head = head->next;
+   }
+   return head != nullptr;
+}
+
+// isOneStar
+// Description: True for a website with a rating of 1 (removeOneStar).
+bool Table::isOneStar(Node * node)
+{
+   return node->data->getRating() == 1;
+}
+
+// takeUnmarked
+// Description: True for a website mergeFromFile did not see in the file.
+//              Clears the mark of the ones it did see, so after a sweep no
+//              node is left marked.
+bool Table::takeUnmarked(Node * node)
+{
+   bool unmarked = !node->marked;
+   node->marked = false;
+   return unmarked;
+}
+
+// clearMark
+// Description: Clears the mark mergeFromFile left on a website and keeps it.
+bool Table::clearMark(Node * node)
+{
+   node->marked = false;
+   return false;
+}
+
+// purgeChain
+// Description: Removes the websites the doomed test returns true for from
+//              the chain at index. Touches nothing but that chain, so different chains
+//              can be purged at the same time. The bucket array must already
+//              be the table's own (detach). Does not change size, the
+//              filter or the cache; the topic and URL keys of removed
+//              websites are passed back instead so the caller can forget
+//              them.
+// Input: index - the index of the chain
+//        doomed - test for the websites to remove (isOneStar, takeUnmarked)
+//        forgotten - topic key then URL key of each removed website are
+//                    appended to it, nullptr if there is no filter or cache
+// Output: the number of websites removed
+int Table::purgeChain(int index, bool (*doomed)(Node * node),
+                      vector<uint64_t> * forgotten)
+{
+   int removed = 0;
+   ownChain(index);
+   Node * curr = aTable->heads[index]; // set curr to the index
+   Node * prev = nullptr; // set prev to null
+   while (curr)
+   {
+      if (doomed(curr)) // match
+      {
+         Node * temp = curr; // save curr node before deleting
+         if (prev) // removing in middle or at end
+         {
+            prev->next = curr->next.load();
+         }
+         else // removing at beginning
+         {
+            aTable->heads[index] = curr->next.load();
+         }
+         if (forgotten)
+         {
+            forgotten->push_back(topicKey(temp->data->getTopic()));
+            forgotten->push_back(urlKey(temp->data->getURL()));
+         }
+         curr = curr->next;
+         epochRetire(temp); // a lock free reader may be on it
+         removed++;
+      }
+      else // no match
+      {
+         prev = curr;
+         curr = curr->next;
+      }
+   }
+   return removed;
+}
+
+// forget
+// Description: Removes the keys of removed websites from the membership
+//              filter and drops the cached results of their topics.
+// Input: keys - topic key, URL key, topic key, ... (see purgeChain)
+// Output: None
+void Table::forget(const vector<uint64_t> & keys)
+{
+   for (size_t i = 0; i < keys.size(); i++)
+   {
+      if (filter)
+      {
+         filter->remove(keys[i]);
+      }
+      if (cache && i % 2 == 0) // topic key
+      {
+         cache->invalidate(keys[i]);
+      }
+   }
+}
+
+// countIf
+// Description: Counts the websites the predicate returns true for. With a
+//              pool, bucket ranges are counted in parallel and the per chunk
+//              counts added up, which gives exactly the sequential count.
+// Input: predicate - test for each website
+//        pool - threads to use, nullptr to count on this thread
+// Output: the number of matching websites
+int Table::countIf(const function<bool(const Website &)> & predicate,
+                   WorkStealingPool * pool) const
+{
+   const Buckets * buckets = aTable;
+   function<int(int, int)> countRange = [buckets, &predicate](int begin,
+                                                              int end)
+   {
+      int count = 0;
+      for (int i = begin; i < end; i++)
+      {
+         for (Node * curr = chainAt(buckets, i); curr; curr = curr->next)
+         {
+            if (predicate(*curr->data))
+            {
+               count++;
+            }
+         }
+      }
+      return count;
+   };
+   int chains = chainCount(buckets);
+   if (!pool)
+   {
+      return countRange(0, chains);
+   }
+   vector<int> counts(chains / scanGrain(*pool) + 1, 0);
+   pool->parallelFor(0, chains, scanGrain(*pool),
+      [&counts, &countRange](int begin, int end, int chunk)
+      {
+         counts[chunk] = countRange(begin, end);
+      });
+   int total = 0;
+   for (size_t i = 0; i < counts.size(); i++)
+   {
+      total += counts[i];
+   }
+   return total;
+}
+
+// averageRatings
+// Description: Number of websites, rating total and average rating for each
+//              topic, sorted by topic. Totals are integers, so merging the
+//              per chunk totals in chunk order gives exactly the sequential
+//              result whatever thread ran which chunk.
+// Input: pool - threads to use, nullptr to scan on this thread
+// Output: one TopicRating per topic, sorted by topic
+vector<TopicRating> Table::averageRatings(WorkStealingPool * pool) const
+{
+   typedef map<string, pair<int, long long> > Totals; // count, rating total
+   const Buckets * buckets = aTable;
+   function<void(int, int, Totals &)> scanRange = [buckets](int begin,
+      int end, Totals & totals)
+   {
+      for (int i = begin; i < end; i++)
+      {
+         for (Node * curr = chainAt(buckets, i); curr; curr = curr->next)
+         {
+            pair<int, long long> & total = totals[curr->data->getTopic()];
+            total.first++;
+            total.second += curr->data->getRating();
+         }
+      }
+   };
+   Totals merged;
+   int chains = chainCount(buckets);
+   if (!pool)
+   {
+      scanRange(0, chains, merged);
+   }
+   else
+   {
+      vector<Totals> partial(chains / scanGrain(*pool) + 1);
+      pool->parallelFor(0, chains, scanGrain(*pool),
+         [&partial, &scanRange](int begin, int end, int chunk)
+         {
+            scanRange(begin, end, partial[chunk]);
+         });
+      for (size_t i = 0; i < partial.size(); i++) // merge in chunk order
+      {
+         for (Totals::iterator it = partial[i].begin();
+              it != partial[i].end(); ++it)
+         {
+            merged[it->first].first += it->second.first;
+            merged[it->first].second += it->second.second;
+         }
+      }
+   }
+   vector<TopicRating> result;
+   for (Totals::iterator it = merged.begin(); it != merged.end(); ++it)
+   {
+      TopicRating rating;
+      rating.topic = it->first;
+      rating.count = it->second.first;
+      rating.ratingTotal = it->second.second;
+      rating.average = (double)rating.ratingTotal / rating.count;
+      result.push_back(rating);
+   }
+   return result;
+}
+
+// scanGrain
+// Description: Buckets per chunk for parallel scans: enough chunks for every
+//              thread to steal from (16 per thread), but not so small that
+//              scheduling costs more than scanning.
+// Input: pool - the pool the scan will run on
+// Output: the chunk size in buckets
+int Table::scanGrain(const WorkStealingPool & pool) const
+{
+   int grain = currCapacity / (pool.getThreadCount() * 16);
+   return grain < 64 ? 64 : grain;
+}
+
+// retrieve
+// Description: Retrieves all websites matching search topic from the hash 
+//              table. If the websites exists, the function returns true and 
+//              the websites are passed back by reference to an array of
+//              websites. A topic the membership filter has never seen
+//              returns false without hashing into the table. The result
+//              cache is not used: the websites are copied straight from
+//              the chain, which is no more work than copying a cached
+//              result, without the cache's lock (retrieveShared is the
+//              cached lookup). Safe to call from any number of threads
+//              while one thread writes: the chain is walked inside an
+//              EpochGuard without taking a lock.
+// Input: searchTopic - the topic to search for
+//        websites - the array of websites to be passed back
+// Output: true if the websites were found, false if not
+bool Table::retrieve(const char * searchTopic, Website websites[], 
+                     int& num_found) const
+{
+   PerfScope scope(PERF_RETRIEVE);
+   if (filter && !filter->mayContain(topicKey(searchTopic)))
+   {
+      return false;
+   }
+   EpochGuard guard;
+   return retrieve(published.load(), searchTopic, websites, num_found,
+                   eviction);
+}
+
+// retrieveShared
+// Description: Returns the websites matching a topic as a shared, read only
+//              vector of copies, in chain order (best rated first). With the
+//              result cache on, a hot topic is answered from the cache with
+//              no chain walk and no copying; the result stays valid after
+//              the table changes (it just is not the latest any more). Safe
+//              to call from several readers at once, like retrieve.
+// Input: searchTopic - the topic to search for
+// Output: the matches, an empty vector if there are none
+QueryCache::Matches Table::retrieveShared(const char * searchTopic) const
+{
+   PerfScope scope(PERF_RETRIEVE);
+   if (filter && !filter->mayContain(topicKey(searchTopic)))
+   {
+      return QueryCache::Matches(new vector<Website>());
+   }
+   if (!cache)
+   {
+      return findMatches(searchTopic);
+   }
+   uint64_t key = topicKey(searchTopic);
+   uint64_t generation = 0;
+   QueryCache::Matches matches = cache->find(key, searchTopic, generation);
+   if (!matches)
+   {
+      matches = findMatches(searchTopic); // after find, so a change made
+                                          // before it is seen here
+      cache->store(key, searchTopic, matches, generation); // empty too
+   }
+   return matches;
+}
+
+// findMatches
+// Description: Copies the topic's websites out of its chain. A topic's
+//              websites are next to each other (see linkSorted), so the walk
+//              stops at the end of the run, and the run is counted first so
+//              the vector is usually allocated once.
+// Input: searchTopic - the topic to search for
+// Output: the matches, an empty vector if there are none
+QueryCache::Matches Table::findMatches(const char * searchTopic) const
+{
+   EpochGuard guard;
+   vector<Website> * matches = new vector<Website>();
+   Node * first = findRun(searchTopic, published.load());
+   int count = 0;
+   for (Node * curr = first;
+        curr && strcmp(curr->data->getTopic(), searchTopic) == 0;
+        curr = curr->next)
+   {
+      count++;
+   }
+   matches->reserve(count);
+   for (Node * curr = first; // the run may change under a lock free read
+        curr && strcmp(curr->data->getTopic(), searchTopic) == 0;
+        curr = curr->next)
+   {
+      matches->push_back(*curr->data);
+      touch(curr, eviction);
+   }
+   return QueryCache::Matches(matches);
+}
+
+// retrieve (static)
+// Description: Does the work for Table::retrieve and Snapshot::retrieve
+//              against the bucket array passed in.
+// Input: buckets - the bucket array to search
+//        searchTopic - the topic to search for
+//        websites - the array of websites to be passed back
+// Output: true if the websites were found, false if not
+bool Table::retrieve(const Buckets * buckets, const char * searchTopic,
+                     Website websites[], int& num_found,
+                     const Eviction * eviction)
+{
+   bool found = false;
+   Node * curr = findRun(searchTopic, buckets); // hash the topic
+   int i = 0; // index for the websites array
+   while (curr && strcmp(curr->data->getTopic(), searchTopic) == 0) // run
+   {
+      websites[i] = *curr->data; // copy website to array
+      touch(curr, eviction);
+      i++;
+      found = true; // set found to true
+      curr = curr->next;
+   }
+   num_found = i; // set num_found to the number of websites found
+   return found;
+}
+
+// edit
+// Description: Edits a website review and rating in the hash table. 
+//              If the website exists, the function returns true and the website
+//              is edited. If the website does not exist, the
+//              function returns false. If the rating changes, the website is
+//              moved to its new place in the topic's rating order.
+//              A URL the membership filter has never seen returns false
+//              right away. The website is not changed in place: an edited
+//              copy replaces it (see replaceSite), so lock free readers see
+//              the old website or the new one, and the old review is only
+//              freed once they have left.
+// Input: website - the website to be edited
+// Output: true if the website was edited, false if the website does not exist
+bool Table::edit(char * searchTopic, char * searchURL, char * newReview,
+                 int newRating)
+{
+   PerfScope scope(PERF_EDIT);
+   if (filter && !filter->mayContain(urlKey(searchURL)))
+   {
+      return false;
+   }
+   resizeStep(searchTopic);
+   if (!findSite(searchTopic, searchURL))
+   {
+      return false;
+   }
+   int index = hash(searchTopic); // hash the topic
+   detach();
+   ownChain(index);
+   Node * curr = findSite(searchTopic, searchURL); // chain may be copied
+   Node * edited = new Node(*curr->data);
+   edited->data->setReview(newReview);
+   edited->data->setRating(newRating);
+   edited->marked = curr->marked;
+   copyUse(edited, curr);
+   if (eviction)
+   {
+      eviction->stats.bytes -= websiteBytes(*curr->data);
+      eviction->stats.bytes += websiteBytes(*edited->data);
+      eviction->tick++;
+      touch(edited, eviction);
+   }
+   replaceSite(index, searchTopic, searchURL, edited);
+   if (cache)
+   {
+      cache->invalidate(topicKey(searchTopic));
+   }
+   if (eviction)
+   {
+      enforceBudget(edited); // a longer review may go over
+   }
+   return true;
+}
+
+// replaceSite
+// Description: Puts an edited copy in place of the website with a topic and
+//              URL in the chain at index, which the table must own. With
+//              the same rating the copy takes the website's place;
+//              otherwise it goes after every other website of the topic
+//              rated the same or higher, like linkSorted. The websites it
+//              moves past are copied too, so the whole changed stretch of
+//              the run is built privately, pointed at the rest of the
+//              chain, and swapped in with one store. A lock free reader
+//              walks the old stretch or the new one and never misses a
+//              website or sees one twice. The old nodes are retired.
+// Input: index - the chain, topic and url - the website
+//        edited - its replacement, not linked in yet
+// Output: None
+void Table::replaceSite(int index, const char * topic, const char * url,
+                        Node * edited)
+{
+   Node * before = nullptr; // node before the topic's run
+   Node * first = aTable->heads[index];
+   while (strcmp(first->data->getTopic(), topic) != 0)
+   {
+      before = first;
+      first = first->next;
+   }
+   vector<Node *> run;
+   int from = 0; // place of the website in the run
+   for (Node * curr = first;
+        curr && strcmp(curr->data->getTopic(), topic) == 0;
+        curr = curr->next)
+   {
+      if (strcmp(curr->data->getURL(), url) == 0)
+      {
+         from = (int)run.size();
+      }
+      run.push_back(curr);
+   }
+   int rating = edited->data->getRating();
+   int to = from; // place of the edited copy in the new run
+   if (run[from]->data->getRating() != rating)
+   {
+      to = 0;
+      for (int i = 0; i < (int)run.size(); i++)
+      {
+         if (i != from && run[i]->data->getRating() >= rating)
+         {
+            to++;
+         }
+      }
+   }
+   int low = from < to ? from : to;
+   int high = from < to ? to : from;
+   Node * head = nullptr;
+   Node * tail = nullptr;
+   for (int i = low; i <= high; i++) // the stretch in its new order
+   {
+      Node * newNode = edited;
+      if (i != to)
+      {
+         Node * moved = run[from < to ? i + 1 : i - 1];
+         newNode = new Node(*moved->data);
+         newNode->marked = moved->marked;
+         copyUse(newNode, moved);
+      }
+      if (tail)
+      {
+         tail->next = newNode;
+      }
+      else
+      {
+         head = newNode;
+      }
+      tail = newNode;
+   }
+   Node * rest = run[high]->next;
+   if (rest) // now pointed to by the old stretch and the new one
+   {
+      rest->refs++;
+   }
+   tail->next = rest;
+   Node * link = low > 0 ? run[low - 1] : before;
+   if (link)
+   {
+      link->next = head;
+   }
+   else
+   {
+      aTable->heads[index] = head;
+   }
+   release(run[low]); // retires the old stretch
+}
+
+// topK
+// Description: Finds the k highest rated websites for a topic. Websites of a
+//              topic are kept together in rating order (see linkSorted), so
+//              after finding the first one this is O(k). Passes back pointers
+//              to the websites in the table, not copies. The pointers are
+//              valid until the table is next changed, or, for a reader
+//              running alongside a writer, for as long as it holds the
+//              EpochGuard it called topK under.
+// Input: searchTopic - the topic to search for
+//        k - the most websites to pass back
+//        top - array of at least k pointers to be passed back
+// Output: true if any websites were found, false if not
+bool Table::topK(const char * searchTopic, int k, const Website * top[],
+                 int& num_found) const
+{
+   PerfScope scope(PERF_TOPK);
+   if (filter && !filter->mayContain(topicKey(searchTopic)))
+   {
+      num_found = 0;
+      return false;
+   }
+   EpochGuard guard;
+   return topK(published.load(), searchTopic, k, top,
+               num_found, eviction);
+}
+
+// topK (static)
+// Description: Does the work for Table::topK and Snapshot::topK against the
+//              bucket array passed in.
+bool Table::topK(const Buckets * buckets, const char * searchTopic, int k,
+                 const Website * top[], int& num_found,
+                 const Eviction * eviction)
+{
+   num_found = 0;
+   Node * curr = findRun(searchTopic, buckets); // hash the topic
+   while (curr && num_found < k &&
+          strcmp(curr->data->getTopic(), searchTopic) == 0) // topic run
+   {
+      top[num_found] = curr->data;
+      touch(curr, eviction);
+      num_found++;
+      curr = curr->next;
+   }
+   return num_found > 0;
+}
+
+// displayAll
+// Description: Displays all websites in the hash table. If the hash table is
+//              empty, the function returns false. If the hash table is not
+//              empty, the function returns true.
+// Input: None
+// Output: true if the hash table is not empty, false if the hash table is
+//         empty
+bool Table::displayAll() const
+{
+   if (size == 0) // if the hash table is empty
+   {
+      return false;
+   }
+   return displayAll(aTable);
+}
+
+// displayAll (static)
+// Description: Displays every website in the bucket array passed in. Shared
+//              by Table::displayAll and Snapshot::displayAll.
+// Input: buckets - the bucket array to display
+// Output: true if anything was displayed, false if not
+bool Table::displayAll(const Buckets * buckets)
+{
+   bool found = false;
+   for (const_iterator it(buckets); it != const_iterator(); ++it)
+   {
+      cout << *it << '\n'; // display the website
+      found = true;
+   }
+   return found;
+}
+
+// displayAll (overloaded)
+// Description: Displays all websites matching search topic from the hash
+//              table. If the websites exists, the function returns true and
+//              the websites are displayed. If the websites do not exist, the
+//              function returns false.
+//              A topic the membership filter has never seen returns false
+//              right away.
+// Input: searchTopic - the topic to search for
+// Output: true if the websites were found, false if not
+bool Table::displayAll(char * searchTopic) const
+{
+   bool found = false;
+   if (filter && !filter->mayContain(topicKey(searchTopic)))
+   {
+      return false;
+   }
+   EpochGuard guard;
+   Node * curr = findRun(searchTopic, published.load());
+   while (curr && strcmp(curr->data->getTopic(), searchTopic) == 0) // run
+   {
+      curr->data->display(); // display the website
+      cout << endl;
+      found = true; // set found to true
+      curr = curr->next;
+   }
+   return found;
+}
+
+// monitor
+// Description: Displays the length of a chain at a given index in the hash
+//              table, 0 if the index is empty, and -1 if the index is out of
+//              bounds.
+// Input: index - the index to be monitored
+// Output: the length of the chain at the index, 0 if the index is empty, and
+//         -1 if the index is out of bounds
+int Table::monitor(int index) const
+{
+   if (index < 0 || index >= currCapacity) // if the index is out of bounds
+   {
+      return -1;
+   }
+   if (!aTable->heads[index]) // if the index is empty
+   {
+      return 0;
+   }
+   int length = 0;
+   Node * curr = aTable->heads[index]; // set curr to the index
+   while (curr) // while curr is not null
+   {
+      length++;
+      curr = curr->next;
+   }
+   return length;
 }
 
 // getSize()
 // Description: Returns the size of the hash table.
 // Input: None
-// Output: the size of the hash table
-int Table::getSize() const
+// Output: the size of the hash table
+int Table::getSize() const
+{
+   return size;
+}
+
+// getCapacity()
+// Description: Returns the capacity of the hash table.
+// Input: None
+// Output: the capacity of the hash table
+int Table::getCapacity() const
+{
+   return currCapacity;
+}
+
+// loadFromFile
+// Description: Loads websites from file into the hash table. Records are
+//              collected and inserted a batch at a time with insertBulk,
+//              which gives the same table as inserting them one by one. A
+//              batch is BULK_BATCH records or as many as the table holds,
+//              whichever is more: insertBulk gains most when a batch puts
+//              several websites in each chain it walks, and the copies held
+//              for a batch never take more memory than the table itself.
+//              The file is read by RecordParser: lines of any length, LF or
+//              CRLF. Bad records are skipped and reported to cerr with their
+//              line numbers; the records after them still load.
+// Input: filename - the name of the file to be loaded
+// Output: none
+
+void Table::loadFromFile(const char* filename)
+{
+   PerfScope scope(PERF_LOAD);
+   RecordParser parser;
+   vector<Website> batch;
+   batch.reserve(BULK_BATCH);
+   if (!parser.parseFile(filename, [this, &batch](const Website & website)
+   {
+      batch.push_back(website);
+      if ((int)batch.size() >= BULK_BATCH && (int)batch.size() >= size)
+      {
+         insertBulk(batch.data(), (int)batch.size());
+         batch.clear();
+         batch.reserve(size); // so the next batch is not copied to grow
+      }
+   }))
+   {
+      cout << "Error opening file" << endl;
+      return;
+   }
+   insertBulk(batch.data(), (int)batch.size());
+   parser.reportErrors(cerr, filename);
+}
+
+// mergeFromFile
+// Description: Applies a bookmark file (same format as loadFromFile) to the
+//              table, one record at a time, so memory does not grow with the
+//              file. Each record is matched by topic and URL: a new one is
+//              inserted, one whose review or rating differs is changed with
+//              edit (so the rating order, filter and cache stay right), and
+//              the rest are left alone. Summaries are not compared, like
+//              edit. With deleteMissing, every website seen in the file is
+//              marked in its node, and websites left unmarked at the end are
+//              removed in a single sweep that also clears the marks. Bad
+//              records are skipped, counted and reported to cerr; if there
+//              were any, nothing is deleted, since a website may be missing
+//              only because its record was damaged.
+// Input: filename - the name of the file to be merged
+//        deleteMissing - remove websites that are not in the file
+//        summary - counts of what changed, passed back
+// Output: true if the file was merged, false if it could not be opened
+bool Table::mergeFromFile(const char * filename, bool deleteMissing,
+                          MergeSummary & summary)
+{
+   PerfScope scope(PERF_MERGE);
+   summary = MergeSummary();
+   RecordParser parser;
+   bool opened = parser.parseFile(filename, [this, deleteMissing, &summary](
+      const Website & website)
+   {
+      const char * topic = website.getTopic();
+      const char * url = website.getURL();
+      Node * node = findSite(topic, url);
+      if (!node)
+      {
+         if (!insert(website)) // same URL under a topic in the same chain
+         {
+            summary.rejected++;
+            return;
+         }
+         summary.inserted++;
+      }
+      else if (node->data->getRating() != website.getRating() ||
+               strcmp(node->data->getReview(), website.getReview()) != 0)
+      {
+         // edit does not change its strings, it only takes char *
+         edit(const_cast<char *>(topic), const_cast<char *>(url),
+              const_cast<char *>(website.getReview()), website.getRating());
+         summary.updated++;
+      }
+      else
+      {
+         summary.unchanged++;
+      }
+      if (deleteMissing)
+      {
+         markSite(topic, url);
+      }
+   });
+   if (!opened) // if the file cannot be opened
+   {
+      return false;
+   }
+   parser.reportErrors(cerr, filename);
+   summary.malformed = parser.getErrorCount();
+   if (deleteMissing) // a damaged file deletes nothing, it only unmarks
+   {
+      summary.deleted = sweepUnmarked(summary.malformed == 0 ? takeUnmarked :
+                                                               clearMark);
+   }
+   return true;
+}
+
+// findSite
+// Description: Finds the website with a topic and URL in its topic's chain.
+// Input: topic, url
+// Output: its node, nullptr if it is not there
+Table::Node * Table::findSite(const char * topic, const char * url) const
+{
+   for (Node * curr = findRun(topic, aTable);
+        curr && strcmp(curr->data->getTopic(), topic) == 0;
+        curr = curr->next)
+   {
+      if (strcmp(curr->data->getURL(), url) == 0)
+      {
+         return curr;
+      }
+   }
+   return nullptr;
+}
+
+// markSite
+// Description: Marks a website as seen by mergeFromFile. The mark is a write,
+//              so the chain is made the table's own first; snapshots never
+//              see marks.
+// Input: topic, url - the website, which must be in the table
+// Output: None
+void Table::markSite(const char * topic, const char * url)
+{
+   resizeStep(topic);
+   int index = hash(topic);
+   detach();
+   ownChain(index);
+   findSite(topic, url)->marked = true;
+}
+
+// sweepUnmarked
+// Description: Runs over every chain after mergeFromFile, removing the
+//              websites the doomed test picks and clearing every mark.
+// Input: doomed - takeUnmarked to remove what merge did not see, clearMark
+//                 to just clear the marks
+// Output: the number of websites removed
+int Table::sweepUnmarked(bool (*doomed)(Node * node))
+{
+   int removed = 0;
+   vector<uint64_t> forgotten; // filter keys of removed websites
+   finishResize();
+   for (int i = 0; i < currCapacity; i++) // for each index in the table
+   {
+      if (aTable->heads[i])
+      {
+         detach();
+         removed += purgeChain(i, doomed, filter || cache ?
+                                                &forgotten : nullptr);
+      }
+   }
+   size -= removed;
+   forget(forgotten);
+   if (eviction && removed > 0)
+   {
+      eviction->stats.bytes = countBytes();
+   }
+   return removed;
+}
+
+
+// saveToFile
+// Description: Saves every website to a file in the same 5 line format that
+//              loadFromFile reads. Writes from a snapshot so the file is a
+//              consistent point in time copy.
+// Input: filename - the name of the file to be written
+// Output: true if the file was written, false if it could not be opened
+bool Table::saveToFile(const char * filename) const
+{
+   return snapshot().saveToFile(filename);
+}
+
+// saveToFile (static)
+// Description: Writes every website in the bucket array passed in to a file
+//              as topic, URL, summary, review and rating lines followed by a
+//              blank line.
+// Input: buckets - the bucket array to save
+//        filename - the name of the file to be written
+// Output: true if the file was written, false if it could not be opened
+bool Table::saveToFile(const Buckets * buckets, const char * filename)
+{
+   ofstream outFile(filename);
+   if (!outFile) // if the file cannot be opened
+   {
+      return false;
+   }
+   for (const_iterator it(buckets); it != const_iterator(); ++it)
+   {
+      outFile << it->getTopic() << '\n'
+              << it->getURL() << '\n'
+              << it->getSummary() << '\n'
+              << it->getReview() << '\n'
+              << it->getRating() << "\n\n";
+   }
+   return bool(outFile);
+}
+
+// begin
+// Description: Returns an iterator to the first website in the table.
+// Input: None
+// Output: the iterator, equal to end() if the table is empty
+Table::const_iterator Table::begin() const
+{
+   return const_iterator(aTable);
+}
+
+// end
+// Description: Returns the iterator one past the last website.
+// Input: None
+// Output: the end iterator
+Table::const_iterator Table::end() const
 {
-   return size;
+   return const_iterator();
 }
 
-// getCapacity()
-// Description: Returns the capacity of the hash table.
+// nextBatch
+// Description: Passes back up to max websites starting at cursor and moves
+//              the cursor past them, so a big table can be walked in fixed
+//              size pages. Pointers are into the table (no copies) and are
+//              valid until the table is next changed. The cursor survives
+//              writes between batches, but websites inserted or removed in
+//              the meantime may be skipped or seen twice; page through a
+//              snapshot when that matters.
+// Input: cursor - where to start, updated to where the batch ended
+//        batch - array of at least max pointers to be passed back
+//        max - the most websites to pass back
+// Output: the number of websites passed back, 0 once the walk is done
+int Table::nextBatch(Cursor & cursor, const Website * batch[], int max) const
+{
+   return nextBatch(aTable, cursor, batch, max);
+}
+
+// nextBatch (static)
+// Description: Does the work for Table::nextBatch and Snapshot::nextBatch
+//              against the bucket array passed in.
+int Table::nextBatch(const Buckets * buckets, Cursor & cursor,
+                     const Website * batch[], int max)
+{
+   int count = 0;
+   while (!cursor.done() && count < max)
+   {
+      if (cursor.bucket >= chainCount(buckets)) // walked every chain
+      {
+         cursor.bucket = -1;
+         cursor.position = 0;
+         break;
+      }
+      Node * curr = chainAt(buckets, cursor.bucket);
+      for (int i = 0; curr && i < cursor.position; i++) // resume in chain
+      {
+         curr = curr->next;
+      }
+      while (curr && count < max)
+      {
+         batch[count] = curr->data;
+         count++;
+         cursor.position++;
+         curr = curr->next;
+      }
+      if (!curr) // chain finished, move to the next one
+      {
+         cursor.bucket++;
+         cursor.position = 0;
+      }
+   }
+   return count;
+}
+
+// enableFilter
+// Description: Turns on the membership filter: a blocked counting Bloom
+//              filter of every topic and URL in the table. retrieve, topK,
+//              displayAll(topic) and edit answer "not found" from it without
+//              walking a chain when a key was never added, and insert skips
+//              the duplicate search for new URLs. insert and removeOneStar
+//              keep it up to date. The filter does not grow; size it for the
+//              most websites the table will hold (it still works past that,
+//              just with more chain walks for absent keys).
+// Input: expectedWebsites - websites to size the filter for, 0 for the
+//                           larger of the current size and the capacity
+// Output: None
+void Table::enableFilter(int expectedWebsites)
+{
+   if (expectedWebsites <= 0)
+   {
+      int websites = size;
+      expectedWebsites = websites > currCapacity ? websites : currCapacity;
+   }
+   delete filter;
+   filter = new MembershipFilter(expectedWebsites * 2); // topic and URL
+   for (const_iterator it = begin(); it != end(); ++it)
+   {
+      filter->add(topicKey(it->getTopic()));
+      filter->add(urlKey(it->getURL()));
+   }
+}
+
+// disableFilter
+// Description: Frees the membership filter; lookups walk the chains again.
+void Table::disableFilter()
+{
+   delete filter;
+   filter = nullptr;
+}
+
+// hasFilter
+// Description: Returns true if the membership filter is on.
+bool Table::hasFilter() const
+{
+   return filter != nullptr;
+}
+
+// enableCache
+// Description: Turns on the result cache: retrieveShared keeps the results
+//              of the maxTopics most recently asked topics.
+//              insert, edit and removeOneStar drop the result of just the
+//              topics they change. Calling it again empties the cache.
+// Input: maxTopics - most topics to keep results for
+// Output: None
+void Table::enableCache(int maxTopics)
+{
+   delete cache;
+   cache = new QueryCache(maxTopics);
+}
+
+// disableCache
+// Description: Frees the result cache.
+void Table::disableCache()
+{
+   delete cache;
+   cache = nullptr;
+}
+
+// getCacheStats
+// Description: Returns the result cache counters.
 // Input: None
-// Output: the capacity of the hash table
-int Table::getCapacity() const
+// Output: the counters, all 0 if the cache is off
+CacheStats Table::getCacheStats() const
 {
-   return currCapacity;
+   return cache ? cache->getStats() : CacheStats();
 }
 
-// loadFromFile
-// Description: Loads websites from file into the hash table. Uses the
-//              insert function to insert the websites into the hash table.
-// Input: filename - the name of the file to be loaded
-// Output: none
+// memoryReport
+// Description: Walks the bucket array and every chain and adds up the bytes
+//              asked for and the bytes the allocator really handed out, by
+//              kind: index (bucket array), nodes (Node and Website objects),
+//              keys (topic and URL) and text (summary and review). Nodes
+//              shared with a snapshot are counted here in full.
+// Input: None
+// Output: the report
+MemoryReport Table::memoryReport() const
+{
+   MemoryReport report;
+   report.requested[MEM_INDEX] = sizeof(Buckets) +
+                                 aTable->capacity * sizeof(Node*);
+   report.usable[MEM_INDEX] = usableSize(aTable, sizeof(Buckets)) +
+      usableSize(aTable->heads, aTable->capacity * sizeof(Node*));
+   report.blocks = 2;
+   if (aTable->old) // still being migrated
+   {
+      const Buckets * old = aTable->old;
+      report.requested[MEM_INDEX] += sizeof(Buckets) +
+                                     old->capacity * sizeof(Node*);
+      report.usable[MEM_INDEX] += usableSize(old, sizeof(Buckets)) +
+         usableSize(old->heads, old->capacity * sizeof(Node*));
+      report.blocks += 2;
+   }
+   for (int i = 0; i < chainCount(aTable); i++)
+   {
+      for (Node * curr = chainAt(aTable, i); curr; curr = curr->next)
+      {
+         const Website * website = curr->data;
+         report.entries++;
+         if (curr->refs > 1)
+         {
+            report.sharedEntries++;
+         }
+         report.requested[MEM_NODES] += sizeof(Node) + sizeof(Website);
+         report.usable[MEM_NODES] += usableSize(curr, sizeof(Node)) +
+                                     usableSize(website, sizeof(Website));
+         report.blocks += 2;
+         const char * keys[2] = { website->getTopic(), website->getURL() };
+         const char * text[2] = { website->getSummary(),
+                                  website->getReview() };
+         for (int j = 0; j < 2; j++)
+         {
+            if (keys[j])
+            {
+               report.requested[MEM_KEYS] += strlen(keys[j]) + 1;
+               report.usable[MEM_KEYS] += usableSize(keys[j],
+                                                     strlen(keys[j]) + 1);
+               report.blocks++;
+            }
+            if (text[j])
+            {
+               report.requested[MEM_TEXT] += strlen(text[j]) + 1;
+               report.usable[MEM_TEXT] += usableSize(text[j],
+                                                     strlen(text[j]) + 1);
+               report.blocks++;
+            }
+         }
+      }
+   }
+   report.filterBytes = filter ? (size_t)filter->getBlockCount() * 64 : 0;
+   report.cachedTopics = cache ? cache->getStats().entries : 0;
+   return report;
+}
 
-void Table::loadFromFile(const char* filename)
+// setBudget
+// Description: Caps the table at budget.maxEntries websites and/or
+//              budget.maxBytes bytes (counted like memoryReport's requested
+//              total, bucket array included). From now on an insert or edit
+//              that goes over evicts websites, picked by budget.policy, until
+//              the table fits; the website just inserted or edited is never
+//              the one evicted. Evicted websites leave the membership filter
+//              and result cache like removed ones. Websites already in the
+//              table count as not used yet. Evicts right away if the table
+//              is already over.
+// Input: budget - the limits and policy
+// Output: None
+void Table::setBudget(const EvictionBudget & budget)
 {
-   // int count = 0;
-   ifstream inFile(filename);
-   if (!inFile) // if the file cannot be opened
+   if (!eviction)
    {
-      cout << "Error opening file" << endl;
-      return;
+      eviction = new Eviction();
+      eviction->random = UINT64_C(0x9E3779B97F4A7C15);
    }
+   eviction->budget = budget;
+   eviction->stats.bytes = countBytes();
+   enforceBudget(nullptr);
+}
+
+// clearBudget
+// Description: Removes the budget; the table grows without limit again.
+void Table::clearBudget()
+{
+   delete eviction;
+   eviction = nullptr;
+}
 
-   char topic[MAX_CSTRING], url[MAX_CSTRING], summary[MAX_PARAGRAPH], 
-        review[MAX_PARAGRAPH];
+// hasBudget
+// Description: Returns true if a budget is set.
+bool Table::hasBudget() const
+{
+   return eviction != nullptr;
+}
 
-   int rating = 0;
+// getEvictionStats
+// Description: Returns the eviction counters and the bytes held.
+// Input: None
+// Output: the counters, all 0 if there is no budget
+EvictionStats Table::getEvictionStats() const
+{
+   return eviction ? eviction->stats : EvictionStats();
+}
 
-   while (inFile.getline(topic, MAX_CSTRING)) // while there is data to read
+// enforceBudget
+// Description: Evicts websites until the table is within its budget.
+// Input: keep - a website that must not be evicted, or nullptr
+// Output: None
+void Table::enforceBudget(const Node * keep)
+{
+   const EvictionBudget & budget = eviction->budget;
+   while ((budget.maxEntries > 0 && size > budget.maxEntries) ||
+          (budget.maxBytes > 0 && eviction->stats.bytes > budget.maxBytes))
    {
-      if (strlen(topic) == 0) // blank line encountered
+      if (!evictOne(keep)) // nothing left but keep
       {
-         continue;
+         break;
       }
+   }
+}
+
+// evictOne
+// Description: Picks a website by the budget's policy and evicts it. During
+//              a resize only the buckets already migrated are searched,
+//              unless there is nothing else there.
+// Input: keep - a website that must not be evicted, or nullptr
+// Output: false if there was nothing to evict
+bool Table::evictOne(const Node * keep)
+{
+   int index = 0;
+   int position = 0;
+   bool found = eviction->budget.policy == EVICT_CLOCK ?
+                clockVictim(keep, index, position) :
+                sampleVictim(keep, index, position);
+   if (!found && aTable->old) // the rest are still in the old buckets
+   {
+      finishResize();
+      found = eviction->budget.policy == EVICT_CLOCK ?
+              clockVictim(keep, index, position) :
+              sampleVictim(keep, index, position);
+   }
+   if (found)
+   {
+      evictAt(index, position);
+   }
+   return found;
+}
 
-      inFile.getline(url, MAX_CSTRING);
-      inFile.getline(summary, MAX_PARAGRAPH);
-      inFile.getline(review, MAX_PARAGRAPH);
-      inFile >> rating;
-      inFile.ignore(); // ignore newline
+// clockVictim
+// Description: CLOCK: sweeps the chain under the hand, clearing the
+//              referenced bit of websites that have one (a second chance)
+//              and stopping at the first website without one. The hand
+//              moves to the next bucket once a chain has been swept. The
+//              bit is set again by touch, so within two passes over the
+//              buckets a victim is found.
+// Input: keep - a website that must not be picked, or nullptr
+//        index, position - set to where the victim is in the table
+// Output: false if there was nothing but keep
+bool Table::clockVictim(const Node * keep, int & index, int & position)
+{
+   for (int swept = 0; swept <= 2 * currCapacity; swept++)
+   {
+      int at = 0;
+      for (Node * curr = aTable->heads[eviction->hand]; curr;
+           curr = curr->next, at++)
+      {
+         eviction->stats.examined++;
+         if (curr == keep)
+         {
+            continue;
+         }
+         if (!curr->referenced.load(memory_order_relaxed))
+         {
+            index = eviction->hand;
+            position = at;
+            return true;
+         }
+         curr->referenced.store(false, memory_order_relaxed);
+      }
+      eviction->hand = (eviction->hand + 1) % currCapacity;
+   }
+   return false;
+}
 
-      // init new website
-      Website* website = new Website();
-      // set website data
-      website->setTopic(topic);
-      website->setURL(url);
-      website->setSummary(summary);
-      website->setReview(review);
-      website->setRating(rating);
+// sampleVictim
+// Description: Sampling policies: looks at budget.samples random non empty
+//              chains and picks the website with the highest evictionScore.
+//              Buckets are drawn again when empty rather than scanned
+//              forward, which would keep landing on the chain after the
+//              longest run of empty buckets. No list is kept in access
+//              order, so reads only ever stamp their own nodes.
+// Input: keep - a website that must not be picked, or nullptr
+//        index, position - set to where the victim is in the table
+// Output: false if there was nothing but keep
+bool Table::sampleVictim(const Node * keep, int & index, int & position)
+{
+   bool found = false;
+   double best = 0;
+   int samples = eviction->budget.samples > 0 ? eviction->budget.samples : 1;
+   for (int sample = 0; sample < samples; sample++)
+   {
+      uint64_t & random = eviction->random; // xorshift64
+      random ^= random << 13;
+      random ^= random >> 7;
+      random ^= random << 17;
+      int bucket = (int)(random % currCapacity);
+      for (int tries = 0; !aTable->heads[bucket] && tries < SAMPLE_TRIES;
+           tries++) // random buckets until one is not empty
+      {
+         random ^= random << 13;
+         random ^= random >> 7;
+         random ^= random << 17;
+         bucket = (int)(random % currCapacity);
+      }
+      int at = 0;
+      for (Node * curr = aTable->heads[bucket]; curr;
+           curr = curr->next, at++)
+      {
+         eviction->stats.examined++;
+         if (curr == keep)
+         {
+            continue;
+         }
+         double score = evictionScore(eviction->budget.policy,
+            curr->data->getRating(),
+            eviction->tick - curr->lastUsed.load(memory_order_relaxed));
+         if (!found || score > best)
+         {
+            found = true;
+            best = score;
+            index = bucket;
+            position = at;
+         }
+      }
+   }
+   for (int bucket = 0; !found && bucket < currCapacity; bucket++)
+   {
+      // every draw missed (a nearly empty table): take the first website
+      Node * head = aTable->heads[bucket];
+      if (head && (head != keep || head->next))
+      {
+         found = true;
+         index = bucket;
+         position = head != keep ? 0 : 1;
+      }
+   }
+   return found;
+}
 
-      insert(*website); // insert into hash table
-      
-      //PRINT STATEMENTS FOR TESTING
-      /*
-      count++;
-      cout << "Website " << count << " added." << endl;
-      cout << *website << endl;
-      */
+// evictAt
+// Description: Removes the website at position in the chain at index, like
+//              purgeChain, and forgets it in the filter and cache.
+// Input: index - the chain, position - place of the website in the chain
+// Output: None
+void Table::evictAt(int index, int position)
+{
+   detach();
+   ownChain(index); // same order, so position still finds the website
+   Node * prev = nullptr;
+   Node * curr = aTable->heads[index];
+   for (int i = 0; i < position; i++)
+   {
+      prev = curr;
+      curr = curr->next;
+   }
+   if (prev) // removing in middle or at end
+   {
+      prev->next = curr->next.load();
+   }
+   else // removing at beginning
+   {
+      aTable->heads[index] = curr->next.load();
+   }
+   vector<uint64_t> forgotten;
+   if (filter || cache)
+   {
+      forgotten.push_back(topicKey(curr->data->getTopic()));
+      forgotten.push_back(urlKey(curr->data->getURL()));
+   }
+   eviction->stats.bytes -= websiteBytes(*curr->data);
+   eviction->stats.evictions++;
+   epochRetire(curr); // a lock free reader may be on it
+   size--;
+   forget(forgotten);
+}
+
+// countBytes
+// Description: Adds up the bytes the table holds, the way the budget counts
+//              them: the bucket array plus websiteBytes of every website.
+//              Used when a budget is set and after bulk removals.
+// Input: None
+// Output: the bytes
+size_t Table::countBytes() const
+{
+   size_t bytes = sizeof(Buckets) + aTable->capacity * sizeof(Node*);
+   const Buckets * old = aTable->old;
+   if (old) // still being migrated
+   {
+      bytes += sizeof(Buckets) + old->capacity * sizeof(Node*);
+   }
+   for (int i = 0; i < chainCount(aTable); i++)
+   {
+      for (Node * curr = chainAt(aTable, i); curr; curr = curr->next)
+      {
+         bytes += websiteBytes(*curr->data);
+      }
+   }
+   return bytes;
+}
+
+// websiteBytes
+// Description: Bytes asked for to hold one website: its node, its Website
+//              and its four strings (see memoryReport).
+// Input: website - the website
+// Output: the bytes
+size_t Table::websiteBytes(const Website & website)
+{
+   size_t bytes = sizeof(Node) + sizeof(Website);
+   const char * strings[4] = { website.getTopic(), website.getURL(),
+                               website.getSummary(), website.getReview() };
+   for (int i = 0; i < 4; i++)
+   {
+      if (strings[i])
+      {
+         bytes += strlen(strings[i]) + 1;
+      }
+   }
+   return bytes;
+}
+
+// touch
+// Description: Records a use of a website for the eviction policy: stamps
+//              the current tick and sets the CLOCK bit. Both are relaxed
+//              atomics written only when they change, so concurrent readers
+//              never take a lock and a hot website's line is not written on
+//              every read.
+// Input: node - the website used
+//        eviction - the table's budget state, nullptr if it has none
+// Output: None
+void Table::touch(Node * node, const Eviction * eviction)
+{
+   if (!eviction)
+   {
+      return;
+   }
+   uint32_t tick = eviction->tick.load(memory_order_relaxed);
+   if (node->lastUsed.load(memory_order_relaxed) != tick)
+   {
+      node->lastUsed.store(tick, memory_order_relaxed);
+   }
+   if (!node->referenced.load(memory_order_relaxed))
+   {
+      node->referenced.store(true, memory_order_relaxed);
+   }
+}
+
+// copyUse
+// Description: Carries the eviction use of a website over to a copy of its
+//              node (copy-on-write, table copies).
+// Input: to - the copy, from - the original
+// Output: None
+void Table::copyUse(Node * to, const Node * from)
+{
+   to->lastUsed.store(from->lastUsed.load(memory_order_relaxed),
+                      memory_order_relaxed);
+   to->referenced.store(from->referenced.load(memory_order_relaxed),
+                        memory_order_relaxed);
+}
+
+// topicKey
+// Description: Hash of a topic for the membership filter and result cache.
+//              Topics and URLs share one filter under different seeds.
+// Input: topic
+// Output: the filter hash
+uint64_t Table::topicKey(const char * topic)
+{
+   return MembershipFilter::hash(topic, UINT64_C(0x746F706963)); // "topic"
+}
+
+// urlKey
+// Description: Hash of a URL for the membership filter.
+// Input: url
+// Output: the filter hash
+uint64_t Table::urlKey(const char * url)
+{
+   return MembershipFilter::hash(url, UINT64_C(0x75726C)); // "url"
+}
+
+// snapshot
+// Description: Returns a read only view of the table as it is right now.
+//              Only the reference count of the bucket array changes, so
+//              this is O(1). Writers copy what they change afterwards.
+// Input: None
+// Output: the snapshot
+Table::Snapshot Table::snapshot() const
+{
+   return Snapshot(aTable, size);
+}
+
+// SNAPSHOT
+
+// Snapshot constructor
+// Description: Takes a reference to the bucket array passed in.
+// Input: aBuckets - the bucket array to view
+//        aSize - the number of websites in it
+Table::Snapshot::Snapshot(Buckets * aBuckets, int aSize)
+{
+   buckets = aBuckets;
+   buckets->refs++;
+   size = aSize;
+}
+
+// Snapshot copy constructor
+// Description: Shares the same bucket array as the snapshot passed in.
+Table::Snapshot::Snapshot(const Snapshot & aSnapshot)
+{
+   buckets = aSnapshot.buckets;
+   buckets->refs++;
+   size = aSnapshot.size;
+}
+
+// Snapshot destructor
+// Description: Drops the reference to the bucket array. Chains the live
+//              table has already replaced are deleted here.
+Table::Snapshot::~Snapshot()
+{
+   release(buckets);
+   buckets = nullptr;
+}
+
+// Snapshot assignment operator overload
+// Description: Drops the current bucket array and shares the one from the
+//              snapshot passed in.
+// Input: aSnapshot - the snapshot to copy
+// Output: this snapshot
+const Table::Snapshot & Table::Snapshot::operator=(const Snapshot & aSnapshot)
+{
+   if (this != &aSnapshot)
+   {
+      aSnapshot.buckets->refs++;
+      release(buckets);
+      buckets = aSnapshot.buckets;
+      size = aSnapshot.size;
+   }
+   return *this;
+}
+
+// Snapshot retrieve
+// Description: Same as Table::retrieve, against the snapshot.
+bool Table::Snapshot::retrieve(const char * searchTopic, Website websites[],
+                               int& num_found) const
+{
+   return Table::retrieve(buckets, searchTopic, websites, num_found);
+}
+
+// Snapshot topK
+// Description: Same as Table::topK, against the snapshot. The pointers are
+//              valid for as long as the snapshot is.
+bool Table::Snapshot::topK(const char * searchTopic, int k,
+                           const Website * top[], int& num_found) const
+{
+   return Table::topK(buckets, searchTopic, k, top, num_found);
+}
+
+// Snapshot displayAll
+// Description: Same as Table::displayAll, against the snapshot.
+bool Table::Snapshot::displayAll() const
+{
+   return Table::displayAll(buckets);
+}
+
+// Snapshot begin
+// Description: Same as Table::begin, against the snapshot.
+Table::const_iterator Table::Snapshot::begin() const
+{
+   return const_iterator(buckets);
+}
+
+// Snapshot end
+// Description: Same as Table::end, against the snapshot.
+Table::const_iterator Table::Snapshot::end() const
+{
+   return const_iterator();
+}
+
+// Snapshot nextBatch
+// Description: Same as Table::nextBatch, against the snapshot. Since the
+//              snapshot never changes, paging through it is exact.
+int Table::Snapshot::nextBatch(Cursor & cursor, const Website * batch[],
+                               int max) const
+{
+   return Table::nextBatch(buckets, cursor, batch, max);
+}
+
+// Snapshot saveToFile
+// Description: Same as Table::saveToFile, against the snapshot.
+bool Table::Snapshot::saveToFile(const char * filename) const
+{
+   return Table::saveToFile(buckets, filename);
+}
+
+// Snapshot getSize
+// Description: Returns the number of websites in the snapshot.
+int Table::Snapshot::getSize() const
+{
+   return size;
+}
+
+// Snapshot getCapacity
+// Description: Returns the capacity of the snapshot.
+int Table::Snapshot::getCapacity() const
+{
+   return buckets->capacity;
+}
 
-      //Deallocate memory
-      delete website; // delete website
-      website = nullptr;
+// ITERATOR
+
+// const_iterator default constructor
+// Description: Makes the end iterator. Every end iterator compares equal.
+Table::const_iterator::const_iterator()
+{
+   buckets = nullptr;
+   bucket = 0;
+   curr = nullptr;
+}
+
+// const_iterator constructor
+// Description: Points at the first website in the bucket array passed in,
+//              or is the end iterator if there are none.
+// Input: aBuckets - the bucket array to walk
+Table::const_iterator::const_iterator(const Buckets * aBuckets)
+{
+   buckets = aBuckets;
+   bucket = 0;
+   curr = chainCount(buckets) > 0 ? chainAt(buckets, 0) : nullptr;
+   skipEmpty();
+}
+
+// skipEmpty
+// Description: If curr ran off the end of a chain, moves on to the head of
+//              the next non empty chain. Becomes the end iterator when there
+//              are no more chains.
+// Input: None
+// Output: None
+void Table::const_iterator::skipEmpty()
+{
+   while (!curr && buckets)
+   {
+      bucket++;
+      if (bucket >= chainCount(buckets)) // past the last chain
+      {
+         buckets = nullptr;
+         bucket = 0;
+      }
+      else
+      {
+         curr = chainAt(buckets, bucket);
+      }
    }
 }
 
+// dereference operator overload
+// Description: Returns the current website. Undefined for the end iterator.
+const Website & Table::const_iterator::operator*() const
+{
+   return *curr->data;
+}
+
+// arrow operator overload
+// Description: Returns a pointer to the current website.
+const Website * Table::const_iterator::operator->() const
+{
+   return curr->data;
+}
+
+// prefix increment operator overload
+// Description: Moves to the next website, crossing into the next non empty
+//              chain when this one ends.
+Table::const_iterator & Table::const_iterator::operator++()
+{
+   curr = curr->next;
+   skipEmpty();
+   return *this;
+}
+
+// postfix increment operator overload
+// Description: Moves to the next website and returns the old position.
+Table::const_iterator Table::const_iterator::operator++(int)
+{
+   const_iterator old = *this;
+   ++(*this);
+   return old;
+}
+
+// equals operator overload
+// Description: Two iterators are equal if they point at the same node (all
+//              end iterators point at nullptr).
+bool Table::const_iterator::operator==(const const_iterator & rhs) const
+{
+   return curr == rhs.curr;
+}
+
+// not equals operator overload
+bool Table::const_iterator::operator!=(const const_iterator & rhs) const
+{
+   return curr != rhs.curr;
+}
@@ -1,9 +1,9 @@
 /******************************************************************************
 # Program Desc.:      This program is a website bookmarking program. The program
-#                     implements a hash table using chaining (pointer array of 
+#                     implements a hash table using chaining (pointer array of
 #                     linked lists) to store website information.
 # File:               table.h
-# File Description:   Header file for the Table ADT class. Implemented using a 
+# File Description:   Header file for the Table ADT class. Implemented using a
 #                     hash table with chaining (array of linked lists).
 # Input:              None
 # Output:             None
@@ -13,63 +13,364 @@
 #include <iostream>
 #include <cstring>
 #include <fstream>
+#include <atomic>
+#include <iterator>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <functional>
 
 #include "website.h"
+#include "basic_table.h"
+#include "query_cache.h"
+#include "memory_stats.h"
+#include "eviction.h"
+#include "epoch.h"
 
 using namespace std;
 
+class WorkStealingPool; // work_pool.h
+class MembershipFilter; // membership_filter.h
+
+// TopicRating
+// Rating summary of one topic (see Table::averageRatings)
+struct TopicRating
+{
+   string topic;
+   int count; // number of websites
+   long long ratingTotal; // sum of their ratings
+   double average; // ratingTotal / count
+};
+
+// MergeSummary
+// What Table::mergeFromFile changed
+struct MergeSummary
+{
+   int inserted = 0; // websites new to the table
+   int updated = 0; // websites whose review or rating changed
+   int unchanged = 0; // websites already in the table as they are
+   int rejected = 0; // URL already in the table under another topic
+   int deleted = 0; // websites not in the file (only if asked to delete)
+   int malformed = 0; // bad records skipped (see RecordParser)
+};
+
 class Table
 {
+private:
+   struct Node; // forward declarations for the Snapshot class
+   struct Buckets;
+
 public:
+   // const_iterator
+   // STL style forward iterator over every website, bucket by bucket, in
+   // chain order. Works on a Table or a Snapshot. Any write to a Table
+   // invalidates its iterators; iterators of a Snapshot stay valid for as
+   // long as the snapshot does.
+   class const_iterator
+   {
+   public:
+      typedef forward_iterator_tag iterator_category;
+      typedef Website value_type;
+      typedef ptrdiff_t difference_type;
+      typedef const Website * pointer;
+      typedef const Website & reference;
+
+      const_iterator(); // end iterator
+      reference operator* () const;
+      pointer operator-> () const;
+      const_iterator& operator++ (); // prefix
+      const_iterator operator++ (int); // postfix
+      bool operator== (const const_iterator& rhs) const;
+      bool operator!= (const const_iterator& rhs) const;
+
+   private:
+      friend class Table;
+      const_iterator(const Buckets * aBuckets); // first website in buckets
+      void skipEmpty(); // move to the next non empty chain if needed
+
+      const Buckets * buckets; // bucket array being walked
+      int bucket; // index of the current chain
+      Node * curr; // current node, nullptr at the end
+   };
+
+   // Cursor
+   // Resumable position for paging through a table with nextBatch. It is
+   // just the bucket index and the position in that chain, so it can be
+   // kept between calls (or saved and restored) without holding anything.
+   struct Cursor
+   {
+      Cursor() : bucket(0), position(0) {}
+      bool done() const { return bucket < 0; } // true once past the end
+      int bucket; // index of the chain, -1 once the walk is finished
+      int position; // number of nodes of that chain already passed back
+   };
+
+   // Snapshot
+   // Read only, point in time view of a Table. Taking a snapshot only bumps
+   // the reference count on the bucket array, so it costs O(1) no matter how
+   // big the table is. The chains are shared with the live table and are
+   // copied lazily (copy-on-write) by the first write that touches them, so
+   // the snapshot keeps seeing the data as it was when it was taken.
+   // Table::snapshot() must be called with the same synchronization as the
+   // writers, but the snapshot itself can then be read from any thread.
+   class Snapshot
+   {
+   public:
+      Snapshot(const Snapshot& aSnapshot); // copy constructor
+      ~Snapshot(); // destructor
+      const Snapshot& operator= (const Snapshot& aSnapshot);
+
+      bool retrieve(const char * topic_keyword, Website all_matches[],
+                    int& num_found) const; // retrieve websites by topic
+      bool topK(const char * topic_keyword, int k, const Website * top[],
+                int& num_found) const; // best rated websites for topic
+      bool displayAll() const; // display all websites in the snapshot
+      const_iterator begin() const; // first website in the snapshot
+      const_iterator end() const; // past the last website
+      int nextBatch(Cursor& cursor, const Website * batch[],
+                    int max) const; // next max websites after cursor
+      bool saveToFile(const char * filename) const; // save in input format
+      int getSize() const; // return size of snapshot
+      int getCapacity() const; // return capacity of snapshot
+
+   private:
+      friend class Table;
+      Snapshot(Buckets * aBuckets, int aSize); // only Table makes snapshots
+
+      Buckets * buckets; // shared bucket array (reference counted)
+      int size; // number of websites when the snapshot was taken
+   };
+
    Table(); // constructor
+   explicit Table(int capacity); // constructor with at least capacity buckets
+   Table(int capacity, uint64_t hashSeed); // same, keyed topic hash
+   Table(int capacity, uint64_t hashSeed,
+         uint64_t hashSeed2); // same, 128 bit key
    Table(const Table& aTable); // copy constructor
+   Table(Table&& aTable); // move constructor
    ~Table(); // destructor
+   const Table& operator= (const Table& aTable); // deep copy
+   const Table& operator= (Table&& aTable); // O(1) move
 
-   bool insert(Website& aWebsite); // add website to the hash table
+   bool insert(const Website& aWebsite); // add website to the hash table
+   int insertBulk(const Website websites[], int count); // many, bucket order
    bool removeOneStar(); // remove all websites with a rating of 1
-   bool retrieve(const char * topic_keyword, Website all_matches[], 
+   bool removeOneStar(WorkStealingPool& pool); // same, buckets in parallel
+   int countIf(const function<bool(const Website&)>& predicate,
+               WorkStealingPool * pool = nullptr) const; // count matches
+   vector<TopicRating> averageRatings(WorkStealingPool * pool =
+                                      nullptr) const; // per topic, sorted
+   bool retrieve(const char * topic_keyword, Website all_matches[],
                  int& num_found) const; // retrieve websites by topic keyword
-   bool edit(char * searchTopic, char * searchURL, char * newReview, 
+   QueryCache::Matches retrieveShared(const char * topic_keyword)
+      const; // same, as a shared read only copy (no per call copying)
+   bool edit(char * searchTopic, char * searchURL, char * newReview,
              int newRating); // edit a website review and rating
+   bool topK(const char * topic_keyword, int k, const Website * top[],
+             int& num_found) const; // k best rated websites for a topic
    bool displayAll(char * searchTopic) const; // display all websites by topic
    bool displayAll() const; // display all websites (overload)
    int monitor(int index) const; // display chain length at index
    int getSize() const; // return size of hash table
    int getCapacity() const; // return capacity of hash table
+   bool isResizing() const; // true while old buckets are being migrated
+   Snapshot snapshot() const; // O(1) point in time view of the table
+   void enableFilter(int expectedWebsites = 0); // fast "not found" answers
+   void disableFilter(); // drop the membership filter
+   bool hasFilter() const; // true if the membership filter is on
+   void enableCache(int maxTopics); // cache retrieveShared hot topics
+   void disableCache(); // drop the result cache
+   CacheStats getCacheStats() const; // hit and miss counts, all 0 if off
+   MemoryReport memoryReport() const; // bytes held, by kind
+   void setBudget(const EvictionBudget& budget); // cap entries and bytes
+   void clearBudget(); // grow without limit again
+   bool hasBudget() const; // true if a budget is set
+   EvictionStats getEvictionStats() const; // all 0 if no budget
+   const_iterator begin() const; // first website in the table
+   const_iterator end() const; // past the last website
+   int nextBatch(Cursor& cursor, const Website * batch[],
+                 int max) const; // next max websites after cursor
 
    void loadFromFile(const char * filename); // load test data from file
-   // void saveToFile(const char * filename); // I think this is optional
+   bool mergeFromFile(const char * filename, bool deleteMissing,
+                      MergeSummary& summary); // upsert websites from file
+   bool saveToFile(const char * filename) const; // save data to file
 
 private:
    struct Node // node struct for vertical chain (column)
    {
       Node(const Website& aWebsite) // node constructor
       {
+         memoryAllocated(MEM_NODES, sizeof(Node));
          data = new Website(aWebsite);
+         memoryAllocated(MEM_NODES, sizeof(Website));
          next = nullptr;
+         refs = 1;
       };
       ~Node() // node destructor
       {
          if(data)
          {
             delete data;
+            memoryFreed(MEM_NODES, sizeof(Website));
          }
          data = nullptr;
          next = nullptr;
+         memoryFreed(MEM_NODES, sizeof(Node));
       };
-      Website * data = nullptr;
-      Node * next = nullptr;
+      Website * data = nullptr; // never changed once the node is linked in
+      atomic<Node *> next{nullptr};
+      atomic<int> refs; // owners: the bucket slot or node before this one
+      bool marked = false; // seen by mergeFromFile, only set while it runs
+      atomic<bool> referenced{false}; // CLOCK bit, set on use
+      atomic<uint32_t> lastUsed{0}; // eviction tick of the last use
+   };
+   struct Buckets // bucket array shared between a table and its snapshots
+   {
+      Buckets(int capacity, uint64_t hashSeed,
+              uint64_t hashSeed2); // allocate empty array
+      ~Buckets(); // release every chain
+      atomic<Node *> * heads; // array of pointers to nodes / chains (row)
+      int capacity; // number of buckets in heads
+      PrimeGrowth growth; // fast modulo constants for capacity
+      uint64_t hashSeed; // 0 for TopicSumHash, else KeyedStringHash key
+      uint64_t hashSeed2; // second half of the KeyedStringHash key
+      atomic<int> refs; // owners: the table and any live snapshots
+      atomic<Buckets *> old; // smaller array still being migrated, or nullptr
+      int migrated; // old buckets before this index have all been moved
    };
-   Node** aTable; // pointer to array of pointers to nodes / chains (row)
+   Buckets * aTable; // bucket array, copied on write while snapshots exist
+   atomic<Buckets *> published; // aTable, as lock free readers load it
    const static int INIT_CAP = 11; // initial capacity of the hash table
+   const static int SAMPLE_TRIES = 64; // random draws for a non empty chain
+   const static int MIGRATE_STEP = 2; // old buckets moved per write
+   const static int BULK_BATCH = 65536; // smallest loadFromFile batch
    int currCapacity; // current capacity of the hash table
-   int size; // current number of websites in the hash table
+   atomic<int> size; // current number of websites in the hash table
+   MembershipFilter * filter; // topics and URLs in the table, or nullptr
+   QueryCache * cache; // retrieveShared results by topic, or nullptr
+   struct Eviction // memory budget state (eviction.h)
+   {
+      Eviction() : tick(0), hand(0), random(0) {}
+      Eviction(const Eviction& other) : budget(other.budget),
+         stats(other.stats), tick(other.tick.load()), hand(other.hand),
+         random(other.random) {}
+      EvictionBudget budget;
+      EvictionStats stats; // stats.bytes is kept up to date
+      atomic<uint32_t> tick; // advances on every insert and edit
+      int hand; // CLOCK hand: bucket swept next
+      uint64_t random; // xorshift state for sampling
+   };
+   Eviction * eviction; // budget, or nullptr to grow without limit
+   struct BulkEntry // one website of an insertBulk batch
+   {
+      size_t hash; // topic hash, before it is mapped to a bucket
+      const char * topic; // the website's, so sorts do not chase it
+      const char * url;
+      int rating;
+      int site; // index of the website in the batch
+      int bucket; // index in the bucket array, set by partitionBulk
+      bool rejected; // URL already in its chain or earlier in the batch
+   };
+   struct BulkPhase // what separate inserts would see of a resize
+   {
+      int start; // index in the batch of the phase's first website
+      int oldCapacity; // of the array being migrated, 0 if none
+      PrimeGrowth oldGrowth; // its fast modulo constants
+      int migrated; // old buckets moved in order when the phase starts
+      vector<int> touched; // per old bucket: first insert to move it
+      bool moved(int bucket, int place) const; // seen by insert place
+   };
+   struct BulkGroup // one topic's websites in one bucket of a batch
+   {
+      BulkEntry * first; // sorted by rating, then place in the batch
+      BulkEntry * last;
+      int firstSite; // place in the batch of the topic's first website
+      bool linked; // merged into a run already in the chain
+   };
 
    // private helper functions
    int hash(const char * key) const; // hash function
-   int hashHelper(char * key, int i) const; // helper function for hash()
    //int monitorHelper(Node * head) const; // helper function for monitor()
    void destroy(); // destroy the hash table
+   void copy(const Table& aTable); // deep copy another table into this one
+   void detach(); // give the table its own bucket array before a write
+   void ownChain(int index); // give the table its own chain before a write
+   void resizeStep(const char * topic); // migrate topic and a few buckets
+   void migrateSome(int count); // migrate the next count old buckets
+   void migrateBucket(int index); // move one old chain into the new array
+   void startResize(int minCapacity = 0); // grow, migrating from now on
+   void finishResize(); // migrate every old bucket left
+   void linkSorted(int index, Node * newNode); // link in by topic and rating
+   int phaseRoom() const; // websites taken before the table grows
+   void beginPhase(BulkPhase& phase, int start,
+                   int count); // resize state
+   void moveOldBuckets(BulkPhase& phase,
+                       const vector<BulkEntry>& window); // as inserts would
+   void partitionBulk(vector<BulkEntry>& entries, vector<int>& chains,
+                      vector<int>& bounds) const; // group batch by bucket
+   void rejectDuplicates(int index, BulkEntry * first, BulkEntry * last,
+                         const BulkPhase& phase) const; // by sorted URL
+   int mergeBulk(int index, const Website websites[], BulkEntry * first,
+                 BulkEntry * last, vector<BulkGroup>& groups,
+                 vector<BulkGroup *>& fresh); // a bucket's batch, linked
+   int mergeRuns(int index, const Website websites[],
+                 vector<BulkGroup>& groups,
+                 vector<BulkGroup *>& fresh); // one walk links the groups
+   int linkFresh(int index, const Website websites[],
+                 vector<BulkGroup *>& fresh); // new topics, at the head
+   void replaceSite(int index, const char * topic, const char * url,
+                    Node * edited); // publish an edited copy, re-sorted
+   int purgeChain(int index, bool (*doomed)(Node * node),
+                  vector<uint64_t> * forgotten); // remove doomed websites
+   void forget(const vector<uint64_t> & keys); // update filter and cache
+   Node * findSite(const char * topic,
+                   const char * url) const; // node for topic and URL
+   void markSite(const char * topic, const char * url); // seen by merge
+   int sweepUnmarked(bool (*doomed)(Node * node)); // after a merge
+   QueryCache::Matches findMatches(const char * topic) const; // walk chain
+   int scanGrain(const WorkStealingPool& pool) const; // buckets per chunk
+   void enforceBudget(const Node * keep); // evict until within budget
+   bool evictOne(const Node * keep); // evict one website by the policy
+   bool clockVictim(const Node * keep, int& index, int& position);
+   bool sampleVictim(const Node * keep, int& index, int& position);
+   void evictAt(int index, int position); // remove the website there
+   size_t countBytes() const; // bytes held, walking every chain
+
+   static void release(Node * head); // drop one reference to a chain
+   static bool hasOneStar(const Node * head); // chain has a 1 star website
+   static bool isOneStar(Node * node); // doomed test for removeOneStar
+   static bool takeUnmarked(Node * node); // doomed test for mergeFromFile
+   static bool clearMark(Node * node); // keeps every website, clears marks
+   static void release(Buckets * buckets); // drop one reference to buckets
+   static Buckets * shareBuckets(const Buckets * buckets); // same chains
+   static void ownChain(Buckets * buckets, int index); // copy if shared
+   static void copyChains(const Buckets * from,
+                          Buckets * to); // deep copy, same order
+   static Node * findRun(const char * topic,
+                         const Buckets * buckets); // topic's first node
+   static int chainCount(const Buckets * buckets); // chains, old included
+   static Node * chainAt(const Buckets * buckets, int chain); // chain head
+   static void touch(Node * node, const Eviction * eviction); // mark used
+   static void copyUse(Node * to, const Node * from); // keep use in a copy
+   static size_t websiteBytes(const Website& website); // node and strings
+   static int hashIndex(const char * key,
+                        const Buckets * buckets); // bucket index
+   static size_t topicHash(const char * key,
+                           const Buckets * buckets); // before the mod
+   static uint64_t topicKey(const char * topic); // filter hash of a topic
+   static uint64_t urlKey(const char * url); // filter hash of a URL
+   static bool displayAll(const Buckets * buckets); // display every chain
+   static bool retrieve(const Buckets * buckets, const char * searchTopic,
+                        Website websites[], int& num_found,
+                        const Eviction * eviction = nullptr);
+   static bool topK(const Buckets * buckets, const char * searchTopic, int k,
+                    const Website * top[], int& num_found,
+                    const Eviction * eviction = nullptr);
+   static bool saveToFile(const Buckets * buckets, const char * filename);
+   static int nextBatch(const Buckets * buckets, Cursor& cursor,
+                        const Website * batch[], int max);
 };
 
 #endif
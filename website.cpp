@@ -9,6 +9,7 @@
 # Output:             None
 #******************************************************************************/
 #include "website.h"
+#include "memory_stats.h"
 
 using namespace std;
 
@@ -47,21 +48,25 @@ void Website::destroy()
 {
    if (topic)
    {
+      memoryFreed(MEM_KEYS, strlen(topic) + 1);
       delete [] topic;
       topic = nullptr;
    }
    if (url)
    {
+      memoryFreed(MEM_KEYS, strlen(url) + 1);
       delete [] url;
       url = nullptr;
    }
    if (summary)
    {
+      memoryFreed(MEM_TEXT, strlen(summary) + 1);
       delete [] summary;
       summary = nullptr;
    }
    if (review)
    {
+      memoryFreed(MEM_TEXT, strlen(review) + 1);
       delete [] review;
       review = nullptr;
    }
@@ -92,10 +97,12 @@ void Website::setTopic(char * topic)
 {
    if (this->topic) // if topic is not null
    {
+      memoryFreed(MEM_KEYS, strlen(this->topic) + 1);
       delete [] this->topic;
       this->topic = nullptr;
    }
    this->topic = new char[strlen(topic) + 1];
+   memoryAllocated(MEM_KEYS, strlen(topic) + 1);
    strcpy(this->topic, topic);
 }
 
@@ -111,10 +118,12 @@ void Website::setURL(char * url)
 {
    if (this->url) // if url is not null
    {
+      memoryFreed(MEM_KEYS, strlen(this->url) + 1);
       delete [] this->url;
       this->url = nullptr;
    }
    this->url = new char[strlen(url) + 1];
+   memoryAllocated(MEM_KEYS, strlen(url) + 1);
    strcpy(this->url, url);
 }
 
@@ -130,10 +139,12 @@ void Website::setSummary(char * summary)
 {
    if (this->summary) // if summary is not null
    {
+      memoryFreed(MEM_TEXT, strlen(this->summary) + 1);
       delete [] this->summary;
       this->summary = nullptr;
    }
    this->summary = new char[strlen(summary) + 1];
+   memoryAllocated(MEM_TEXT, strlen(summary) + 1);
    strcpy(this->summary, summary);
 }
 
@@ -149,10 +160,12 @@ void Website::setReview(char * review)
 {
    if (this->review) // if review is not null
    {
+      memoryFreed(MEM_TEXT, strlen(this->review) + 1);
       delete [] this->review;
       this->review = nullptr;
    }
    this->review = new char[strlen(review) + 1];
+   memoryAllocated(MEM_TEXT, strlen(review) + 1);
    strcpy(this->review, review);
 }
 
@@ -247,29 +260,29 @@ ostream & operator<<(ostream & out, const Website & website)
 {
    out << "Topic: ";
    if (website.topic)
-      out << website.topic << endl;
+      out << website.topic << '\n';
    else
-      out << "N/A" << endl;
+      out << "N/A" << '\n';
    out << "URL: ";
    if (website.url)
-      out << website.url << endl;
+      out << website.url << '\n';
    else
-      out << "N/A" << endl;
+      out << "N/A" << '\n';
    out << "Summary: ";
    if (website.summary)
-      out << website.summary << endl;
+      out << website.summary << '\n';
    else
-      out << "N/A" << endl;
+      out << "N/A" << '\n';
    out << "Review: ";
    if (website.review)
-      out << website.review << endl;
+      out << website.review << '\n';
    else
-      out << "N/A" << endl;
+      out << "N/A" << '\n';
    out << "Rating: ";
    if (website.rating != -1)
-      out << website.rating << endl;
+      out << website.rating << '\n';
    else
-      out << "N/A" << endl;
+      out << "N/A" << '\n';
    return out;
 }
 
@@ -0,0 +1,188 @@
+/******************************************************************************
+# Program Desc.:      This program is a website bookmarking program. The program
+#                     implements a hash table using chaining (pointer array of
+#                     linked lists) to store website information.
+# File:               work_pool.cpp
+# File Description:   Implementation file for the WorkStealingPool class.
+# Input:              None
+# Output:             None
+#******************************************************************************/
+#include "work_pool.h"
+
+// Loop
+// Shared state of one parallelFor call.
+struct WorkStealingPool::Loop
+{
+   const RangeBody * body;
+   int remaining; // chunks not finished yet, guarded by lock
+   mutex lock;
+   condition_variable finished;
+};
+
+// Constructor
+// Description: Starts threads - 1 pool threads; the thread that calls
+//              parallelFor is the last worker.
+// Input: threads - total workers, 0 for one per core
+WorkStealingPool::WorkStealingPool(int threads)
+{
+   if (threads <= 0)
+   {
+      threads = (int)thread::hardware_concurrency();
+   }
+   if (threads <= 0)
+   {
+      threads = 1;
+   }
+   pending = 0;
+   stopping = false;
+   for (int i = 0; i < threads; i++)
+   {
+      queues.push_back(unique_ptr<Queue>(new Queue()));
+   }
+   for (int i = 0; i < threads - 1; i++)
+   {
+      workers.push_back(thread(&WorkStealingPool::workerLoop, this, i));
+   }
+}
+
+// Destructor
+WorkStealingPool::~WorkStealingPool()
+{
+   {
+      lock_guard<mutex> guard(sleepLock);
+      stopping = true;
+   }
+   wakeUp.notify_all();
+   for (size_t i = 0; i < workers.size(); i++)
+   {
+      workers[i].join();
+   }
+}
+
+// getThreadCount
+// Description: Returns how many threads work on a parallelFor.
+int WorkStealingPool::getThreadCount() const
+{
+   return (int)queues.size();
+}
+
+// parallelFor
+// Description: Cuts [begin, end) into chunks of grain, deals them round
+//              robin to the thread deques, wakes the pool and works on them
+//              with the calling thread until every chunk is finished. Chunk
+//              indexes are stable (0, 1, 2, ... in range order), so callers
+//              can keep one result per chunk and merge them in order to get
+//              the same answer as a sequential loop no matter which thread
+//              ran which chunk.
+// Input: begin, end - the range, grain - chunk size, body - work per chunk
+// Output: the number of chunks
+int WorkStealingPool::parallelFor(int begin, int end, int grain,
+                                  const RangeBody & body)
+{
+   if (grain < 1)
+   {
+      grain = 1;
+   }
+   int numChunks = end > begin ? (end - begin + grain - 1) / grain : 0;
+   if (numChunks == 0)
+   {
+      return 0;
+   }
+   Loop loop;
+   loop.body = &body;
+   loop.remaining = numChunks;
+   for (int i = 0; i < numChunks; i++)
+   {
+      Chunk chunk;
+      chunk.begin = begin + i * grain;
+      chunk.end = chunk.begin + grain < end ? chunk.begin + grain : end;
+      chunk.index = i;
+      chunk.loop = &loop;
+      Queue & queue = *queues[i % queues.size()];
+      lock_guard<mutex> guard(queue.lock);
+      queue.chunks.push_back(chunk);
+   }
+   pending += numChunks;
+   {
+      lock_guard<mutex> guard(sleepLock); // no lost wake up
+   }
+   wakeUp.notify_all();
+
+   int self = (int)queues.size() - 1; // the caller's own deque
+   while (runOne(self))
+   {
+   }
+   // nothing left to take; wait for chunks other threads are finishing
+   unique_lock<mutex> guard(loop.lock);
+   loop.finished.wait(guard, [&loop] { return loop.remaining == 0; });
+   return numChunks;
+}
+
+// runOne
+// Description: Runs one chunk: the newest from this thread's own deque, or
+//              else the oldest from another thread's deque (stealing the
+//              biggest remaining piece of someone else's work).
+// Input: self - index of this thread's deque
+// Output: false if every deque was empty
+bool WorkStealingPool::runOne(int self)
+{
+   Chunk chunk;
+   bool found = false;
+   {
+      Queue & own = *queues[self];
+      lock_guard<mutex> guard(own.lock);
+      if (!own.chunks.empty())
+      {
+         chunk = own.chunks.back();
+         own.chunks.pop_back();
+         found = true;
+      }
+   }
+   for (size_t i = 1; !found && i < queues.size(); i++)
+   {
+      Queue & victim = *queues[(self + i) % queues.size()];
+      lock_guard<mutex> guard(victim.lock);
+      if (!victim.chunks.empty())
+      {
+         chunk = victim.chunks.front();
+         victim.chunks.pop_front();
+         found = true;
+      }
+   }
+   if (!found)
+   {
+      return false;
+   }
+   pending--;
+   Loop * loop = chunk.loop;
+   (*loop->body)(chunk.begin, chunk.end, chunk.index);
+   // decrement under the lock: once the caller sees 0 it may return and
+   // destroy the loop, so nothing may touch it after this unlock
+   lock_guard<mutex> guard(loop->lock);
+   if (--loop->remaining == 0) // last chunk of the loop
+   {
+      loop->finished.notify_all();
+   }
+   return true;
+}
+
+// workerLoop
+// Description: Pool thread body. Runs chunks while there are any, sleeps
+//              otherwise.
+// Input: self - index of this thread's deque
+void WorkStealingPool::workerLoop(int self)
+{
+   while (true)
+   {
+      if (runOne(self))
+      {
+         continue;
+      }
+      unique_lock<mutex> guard(sleepLock);
+      wakeUp.wait(guard, [this] { return stopping || pending > 0; });
+      if (stopping)
+      {
+         return;
+      }
+   }
+}
@@ -0,0 +1,67 @@
+/******************************************************************************
+# Program Desc.:      This program is a website bookmarking program. The program
+#                     implements a hash table using chaining (pointer array of
+#                     linked lists) to store website information.
+# File:               work_pool.h
+# File Description:   Header file for the WorkStealingPool class, a fixed set
+#                     of threads that run parallelFor loops. A loop's range is
+#                     cut into chunks that are dealt out to per thread deques;
+#                     a thread works from the back of its own deque and, when
+#                     it runs dry, steals from the front of another's. The
+#                     calling thread works too until the loop is finished.
+# Input:              None
+# Output:             None
+#******************************************************************************/
+#ifndef WORK_POOL_H
+#define WORK_POOL_H
+#include <vector>
+#include <deque>
+#include <memory>
+#include <functional>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+using namespace std;
+
+class WorkStealingPool
+{
+public:
+   // body(chunkBegin, chunkEnd, chunkIndex) is called once per chunk
+   typedef function<void(int, int, int)> RangeBody;
+
+   WorkStealingPool(int threads = 0); // 0 means one thread per core
+   ~WorkStealingPool(); // stops and joins the threads
+   WorkStealingPool(const WorkStealingPool &) = delete;
+
+   // run body over [begin, end) in chunks of grain, returns the chunk count
+   int parallelFor(int begin, int end, int grain, const RangeBody & body);
+   int getThreadCount() const; // pool threads plus the calling thread
+
+private:
+   struct Loop; // one parallelFor call
+   struct Chunk // a piece of a loop's range
+   {
+      int begin;
+      int end;
+      int index; // position of the chunk in the range, for merging
+      Loop * loop;
+   };
+   struct alignas(64) Queue // one deque per thread (the caller is the last)
+   {
+      mutex lock;
+      deque<Chunk> chunks;
+   };
+   vector<unique_ptr<Queue> > queues;
+   vector<thread> workers;
+   atomic<int> pending; // chunks queued and not yet taken
+   mutex sleepLock; // guards stopping, used with wakeUp
+   condition_variable wakeUp;
+   bool stopping;
+
+   bool runOne(int self); // run one chunk (own or stolen), false if none
+   void workerLoop(int self);
+};
+
+#endif
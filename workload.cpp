@@ -0,0 +1,761 @@
+/******************************************************************************
+# Program Desc.:      This program is a website bookmarking program. The program
+#                     implements a hash table using chaining (pointer array of
+#                     linked lists) to store website information.
+# File:               workload.cpp
+# File Description:   Workload tool for performance work. Generates synthetic
+#                     website corpora in the loadFromFile format and operation
+#                     traces in the batch command format (see app.cpp), both
+#                     fully determined by their options and seed, and replays
+#                     a trace against a Table, timing every operation.
+# Input:              Command line options (see usage)
+# Output:             A corpus or trace on stdout, or a timing summary
+#******************************************************************************/
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <cstdlib>
+#include <cstdint>
+using namespace std;
+
+#include "table.h"
+#include "website.h"
+#include "perf_counters.h"
+
+// Options for generating a corpus and a trace over it
+struct WorkloadOptions
+{
+   int records = 10000; // websites in the corpus
+   int topics = 100; // distinct topics
+   int skew = 100; // Zipf exponent in percent: topic of rank r has weight
+                   // 1 / r^(skew / 100)
+   int urlLength = 40; // mean URL length in characters
+   int summaryWords = 12; // mean summary length in words
+   int reviewWords = 25; // mean review length in words
+   int spread = 50; // length spread in percent (lognormal sigma)
+   int ratings[5] = { 10, 10, 20, 30, 30 }; // weights of 1 to 5 stars
+   uint64_t seed = 1;
+   int ops = 100000; // operations in a trace
+   int getPercent = 80; // the rest of the mix after gets, adds and edits
+   int addPercent = 10; // are purges, which scan the whole table
+   int editPercent = 10;
+   const char * load = nullptr; // corpus file the trace starts by loading
+   const char * out = nullptr; // write here instead of stdout
+};
+
+// Options for replaying a trace
+struct ReplayOptions
+{
+   const char * trace = nullptr;
+   int capacity = 0; // initial buckets, 0 for the Table default
+   int cache = 0; // result cache topics, 0 for none
+   bool filter = false; // membership filter on
+   uint64_t hashSeed = 0; // KeyedStringHash key, 0 for TopicSumHash
+   bool perf = false; // print hardware counters per operation too
+};
+
+// WorkloadRandom
+// Seeded random source. mt19937_64 is fully specified by the standard but
+// the std distributions are not (they differ between standard libraries),
+// so every draw is made from its raw output here and a seed always gives
+// the same corpus and trace.
+class WorkloadRandom
+{
+public:
+   WorkloadRandom(uint64_t seed) : engine(seed) {}
+   uint64_t next() { return engine(); }
+   double uniform(); // in [0, 1)
+   int below(int n) { return (int)(next() % (uint64_t)n); } // in [0, n)
+   int length(int mean, int spread); // lognormal around mean, at least 1
+   int weighted(const vector<double> & cumulative); // index by weight
+
+private:
+   mt19937_64 engine;
+};
+
+// Record
+// One generated website
+struct Record
+{
+   int topic; // topic rank
+   string url;
+   int rating;
+};
+
+// Operation
+// One parsed trace command
+struct Operation
+{
+   int command; // TRACE_LOAD ...
+   string args[5]; // LOAD: file; ADD: the 5 fields; GET: topic;
+                   // EDIT: topic, URL, review
+   int rating;
+};
+
+// Trace commands, in the order they are reported
+enum TraceCommand { TRACE_LOAD, TRACE_ADD, TRACE_GET, TRACE_EDIT, TRACE_PURGE,
+                    NUM_TRACE_COMMANDS };
+const char * const TRACE_COMMAND_NAMES[NUM_TRACE_COMMANDS] = { "LOAD", "ADD",
+                                                               "GET", "EDIT",
+                                                               "PURGE" };
+
+// Word list for summaries, reviews and host names
+const char * const WORDS[] = { "fast", "simple", "guide", "recipe", "review",
+   "tutorial", "reference", "daily", "news", "forum", "great", "clear",
+   "examples", "tips", "deep", "dive", "beginner", "advanced", "notes",
+   "weekly", "photos", "maps", "music", "video", "open", "source", "free",
+   "classic", "modern", "best", "list", "archive", "useful", "detailed",
+   "community", "blog", "home", "science", "history", "travel", "garden",
+   "kitchen", "code", "data", "tools", "market", "local", "world" };
+const int NUM_WORDS = sizeof(WORDS) / sizeof(WORDS[0]);
+
+const double PI = 3.14159265358979323846;
+
+// Syllables topic names are spelled with, one per 4 bits of the rank
+const char * const SYLLABLES[16] = { "ka", "lo", "mi", "nu", "pe", "ra", "si",
+                                     "to", "va", "ze", "bo", "du", "fi", "ge",
+                                     "ha", "jo" };
+
+// Function Prototypes
+bool parseOptions(int argc, char * argv[], WorkloadOptions &options);
+bool parseReplayOptions(int argc, char * argv[], ReplayOptions &options);
+string topicName(int rank);
+vector<double> zipfWeights(int topics, int skew);
+vector<Record> makeCorpus(const WorkloadOptions &options,
+                          WorkloadRandom &random);
+string makeURL(int id, int length, WorkloadRandom &random);
+string makeText(int words, WorkloadRandom &random);
+void writeCorpus(const WorkloadOptions &options, ostream &out);
+void writeTrace(const WorkloadOptions &options, ostream &out);
+bool readTrace(const char * filename, vector<Operation> &operations);
+int replay(const ReplayOptions &options);
+
+int main(int argc, char * argv[])
+{
+   const char * mode = argc > 1 ? argv[1] : "";
+   WorkloadOptions options;
+   ReplayOptions replayOptions;
+   if ((strcmp(mode, "corpus") == 0 || strcmp(mode, "trace") == 0) &&
+       parseOptions(argc - 1, argv + 1, options))
+   {
+      ofstream file;
+      if (options.out)
+      {
+         file.open(options.out);
+         if (!file)
+         {
+            cerr << "Could not open " << options.out << endl;
+            return 1;
+         }
+      }
+      ostream &out = options.out ? file : cout;
+      if (strcmp(mode, "corpus") == 0)
+      {
+         writeCorpus(options, out);
+      }
+      else
+      {
+         writeTrace(options, out);
+      }
+      out.flush();
+      return out ? 0 : 1;
+   }
+   if (strcmp(mode, "replay") == 0 &&
+       parseReplayOptions(argc - 1, argv + 1, replayOptions))
+   {
+      return replay(replayOptions);
+   }
+   cerr << "Usage: workload corpus [--records n] [--topics n] "
+        << "[--skew percent] [--url-length n] [--summary-words n] "
+        << "[--review-words n] [--spread percent] [--ratings w1,w2,w3,w4,w5] "
+        << "[--seed n] [--out file]" << endl
+        << "       workload trace (corpus options) [--ops n] "
+        << "[--gets percent] [--adds percent] [--edits percent] "
+        << "[--load corpus file] [--out file]" << endl
+        << "       workload replay <trace file> [--capacity n] "
+        << "[--cache topics] [--filter 0|1] [--hash-seed n] [--perf 0|1]"
+        << endl;
+   return 1;
+}
+
+// parseOptions function
+// Description: Reads the corpus and trace options into options.
+// Input: argc, argv (after the mode), options to fill
+// Output: false if an option is unknown, missing its value or out of range
+bool parseOptions(int argc, char * argv[], WorkloadOptions &options)
+{
+   for (int i = 1; i < argc; i++)
+   {
+      if (i + 1 >= argc)
+      {
+         return false;
+      }
+      const char * value = argv[i + 1];
+      if (strcmp(argv[i], "--records") == 0)
+         options.records = max(0, atoi(value));
+      else if (strcmp(argv[i], "--topics") == 0)
+         options.topics = max(1, atoi(value));
+      else if (strcmp(argv[i], "--skew") == 0)
+         options.skew = max(0, atoi(value));
+      else if (strcmp(argv[i], "--url-length") == 0)
+         options.urlLength = max(1, atoi(value));
+      else if (strcmp(argv[i], "--summary-words") == 0)
+         options.summaryWords = max(1, atoi(value));
+      else if (strcmp(argv[i], "--review-words") == 0)
+         options.reviewWords = max(1, atoi(value));
+      else if (strcmp(argv[i], "--spread") == 0)
+         options.spread = max(0, atoi(value));
+      else if (strcmp(argv[i], "--ratings") == 0)
+      {
+         int total = 0;
+         for (int r = 0; r < 5; r++)
+         {
+            char * end = nullptr;
+            options.ratings[r] = max(0, (int)strtol(value, &end, 10));
+            total += options.ratings[r];
+            if (end == value || (r < 4 && *end != ','))
+            {
+               return false;
+            }
+            value = end + 1;
+         }
+         if (total == 0)
+         {
+            return false;
+         }
+      }
+      else if (strcmp(argv[i], "--seed") == 0)
+         options.seed = strtoull(value, nullptr, 10);
+      else if (strcmp(argv[i], "--ops") == 0)
+         options.ops = max(0, atoi(value));
+      else if (strcmp(argv[i], "--gets") == 0)
+         options.getPercent = max(0, atoi(value));
+      else if (strcmp(argv[i], "--adds") == 0)
+         options.addPercent = max(0, atoi(value));
+      else if (strcmp(argv[i], "--edits") == 0)
+         options.editPercent = max(0, atoi(value));
+      else if (strcmp(argv[i], "--load") == 0)
+         options.load = value;
+      else if (strcmp(argv[i], "--out") == 0)
+         options.out = value;
+      else
+         return false;
+      i++;
+   }
+   return options.getPercent + options.addPercent + options.editPercent <=
+          100;
+}
+
+// parseReplayOptions function
+// Description: Reads the trace file name and table options into options.
+// Input: argc, argv (after the mode), options to fill
+// Output: false if the trace is missing or an option is unknown
+bool parseReplayOptions(int argc, char * argv[], ReplayOptions &options)
+{
+   if (argc < 2)
+   {
+      return false;
+   }
+   options.trace = argv[1];
+   for (int i = 2; i < argc; i++)
+   {
+      if (i + 1 >= argc)
+      {
+         return false;
+      }
+      const char * value = argv[i + 1];
+      if (strcmp(argv[i], "--capacity") == 0)
+         options.capacity = max(0, atoi(value));
+      else if (strcmp(argv[i], "--cache") == 0)
+         options.cache = max(0, atoi(value));
+      else if (strcmp(argv[i], "--filter") == 0)
+         options.filter = atoi(value) != 0;
+      else if (strcmp(argv[i], "--hash-seed") == 0)
+         options.hashSeed = strtoull(value, nullptr, 10);
+      else if (strcmp(argv[i], "--perf") == 0)
+         options.perf = atoi(value) != 0;
+      else
+         return false;
+      i++;
+   }
+   return true;
+}
+
+// RANDOM
+
+// uniform
+// Description: Returns a double in [0, 1) from the top 53 bits of a draw.
+double WorkloadRandom::uniform()
+{
+   return (next() >> 11) * (1.0 / 9007199254740992.0);
+}
+
+// length
+// Description: Draws a length from a lognormal distribution with the mean
+//              passed in, so most lengths are near the mean with a long
+//              tail of longer ones. The normal draw is a Box-Muller
+//              transform of two uniform draws.
+// Input: mean - the mean length
+//        spread - sigma of the underlying normal, in percent
+// Output: the length, at least 1
+int WorkloadRandom::length(int mean, int spread)
+{
+   double sigma = spread / 100.0;
+   double u1 = 1.0 - uniform(); // (0, 1], so the log is finite
+   double u2 = uniform();
+   double normal = sqrt(-2.0 * log(u1)) * cos(2.0 * PI * u2);
+   int drawn = (int)lround(mean * exp(sigma * normal - sigma * sigma / 2));
+   return drawn < 1 ? 1 : drawn;
+}
+
+// weighted
+// Description: Picks an index with probability in proportion to its weight.
+// Input: cumulative - running totals of the weights
+// Output: the index
+int WorkloadRandom::weighted(const vector<double> & cumulative)
+{
+   double draw = uniform() * cumulative.back();
+   int index = (int)(upper_bound(cumulative.begin(), cumulative.end(), draw) -
+                     cumulative.begin());
+   return index < (int)cumulative.size() ? index : (int)cumulative.size() - 1;
+}
+
+// GENERATING
+
+// topicName function
+// Description: Spells a topic rank as syllables, so every rank gets its
+//              own pronounceable topic of a realistic length.
+// Input: rank - the topic rank, from 0
+// Output: the topic
+string topicName(int rank)
+{
+   string name;
+   do
+   {
+      name += SYLLABLES[rank & 15];
+      rank >>= 4;
+   } while (rank > 0);
+   return name;
+}
+
+// zipfWeights function
+// Description: Running totals of the Zipf weights of topics topics.
+// Input: topics - the number of topics, skew - the exponent in percent
+// Output: the running totals
+vector<double> zipfWeights(int topics, int skew)
+{
+   vector<double> cumulative(topics);
+   double total = 0;
+   for (int r = 0; r < topics; r++)
+   {
+      total += 1.0 / pow(r + 1, skew / 100.0);
+      cumulative[r] = total;
+   }
+   return cumulative;
+}
+
+// makeURL function
+// Description: Makes a URL about length characters long. The website id
+//              goes in the path, so URLs are unique whatever the length.
+// Input: id - the website id, length - the length wanted, random
+// Output: the URL
+string makeURL(int id, int length, WorkloadRandom &random)
+{
+   string url = string("https://") + WORDS[random.below(NUM_WORDS)] + "-" +
+                WORDS[random.below(NUM_WORDS)] + ".example/" +
+                to_string(id);
+   while ((int)url.size() < length)
+   {
+      url += "/";
+      url += WORDS[random.below(NUM_WORDS)];
+   }
+   return url;
+}
+
+// makeText function
+// Description: Makes a sentence of words words from the word list.
+// Input: words - the number of words, random
+// Output: the text
+string makeText(int words, WorkloadRandom &random)
+{
+   string text;
+   for (int i = 0; i < words; i++)
+   {
+      if (i > 0)
+      {
+         text += ' ';
+      }
+      text += WORDS[random.below(NUM_WORDS)];
+   }
+   return text;
+}
+
+// makeCorpus function
+// Description: Draws the topic, URL and rating of every corpus website.
+//              Summaries and reviews are drawn by writeCorpus from a second
+//              random source, so the trace generator can rebuild the
+//              corpus's keys without the text.
+// Input: options, random
+// Output: the websites, in file order
+vector<Record> makeCorpus(const WorkloadOptions &options,
+                          WorkloadRandom &random)
+{
+   vector<double> topics = zipfWeights(options.topics, options.skew);
+   vector<double> ratings(5);
+   double total = 0;
+   for (int r = 0; r < 5; r++)
+   {
+      total += options.ratings[r];
+      ratings[r] = total;
+   }
+   vector<Record> records(options.records);
+   for (int i = 0; i < options.records; i++)
+   {
+      records[i].topic = random.weighted(topics);
+      records[i].url = makeURL(i, random.length(options.urlLength,
+                                                options.spread), random);
+      records[i].rating = random.weighted(ratings) + 1;
+   }
+   return records;
+}
+
+// writeCorpus function
+// Description: Writes options.records websites in the loadFromFile format
+//              (topic, URL, summary, review, rating, blank line). Topics
+//              follow a Zipf distribution, URL and text lengths lognormal
+//              ones, ratings the weights given. The same options and seed
+//              always write the same file.
+// Input: options, out
+// Output: None
+void writeCorpus(const WorkloadOptions &options, ostream &out)
+{
+   WorkloadRandom random(options.seed);
+   vector<Record> records = makeCorpus(options, random);
+   WorkloadRandom text(options.seed ^ UINT64_C(0x9E3779B97F4A7C15));
+   for (size_t i = 0; i < records.size(); i++)
+   {
+      out << topicName(records[i].topic) << '\n' << records[i].url << '\n'
+          << makeText(text.length(options.summaryWords, options.spread),
+                      text) << '\n'
+          << makeText(text.length(options.reviewWords, options.spread),
+                      text) << '\n'
+          << records[i].rating << "\n\n";
+   }
+}
+
+// writeTrace function
+// Description: Writes options.ops operations as app batch commands (see
+//              runBatch in app.cpp), so a trace can be replayed here or fed
+//              to app --batch. It starts with LOAD of options.load, if any,
+//              whose websites are rebuilt from the same options and seed so
+//              edits can name them. GET topics follow the Zipf distribution
+//              (half the time a topic that may not exist yet), ADD inserts a
+//              new website, EDIT changes the review and rating of a website
+//              in the table, and PURGE removes 1 star websites, which the
+//              generator keeps track of so later edits still hit.
+// Input: options, out
+// Output: None
+void writeTrace(const WorkloadOptions &options, ostream &out)
+{
+   WorkloadRandom random(options.seed);
+   vector<Record> live;
+   if (options.load)
+   {
+      live = makeCorpus(options, random);
+      out << "LOAD " << options.load << '\n';
+   }
+   WorkloadRandom trace(options.seed + 1);
+   vector<double> topics = zipfWeights(options.topics, options.skew);
+   vector<double> ratings(5);
+   double total = 0;
+   for (int r = 0; r < 5; r++)
+   {
+      total += options.ratings[r];
+      ratings[r] = total;
+   }
+   int nextId = options.records; // ids after the corpus's
+   for (int i = 0; i < options.ops; i++)
+   {
+      int pick = trace.below(100);
+      if (pick < options.getPercent)
+      {
+         int topic = trace.weighted(topics);
+         if (trace.below(2) == 0) // a rank past the corpus's topics
+         {
+            topic += options.topics;
+         }
+         out << "GET " << topicName(topic) << '\n';
+      }
+      else if (pick < options.getPercent + options.addPercent)
+      {
+         Record record;
+         record.topic = trace.weighted(topics);
+         record.url = makeURL(nextId++, trace.length(options.urlLength,
+                                                     options.spread), trace);
+         record.rating = trace.weighted(ratings) + 1;
+         out << "ADD\n" << topicName(record.topic) << '\n' << record.url
+             << '\n'
+             << makeText(trace.length(options.summaryWords, options.spread),
+                         trace) << '\n'
+             << makeText(trace.length(options.reviewWords, options.spread),
+                         trace) << '\n'
+             << record.rating << '\n';
+         live.push_back(record);
+      }
+      else if (pick < options.getPercent + options.addPercent +
+                      options.editPercent)
+      {
+         if (live.empty())
+         {
+            continue;
+         }
+         Record &record = live[trace.below((int)live.size())];
+         record.rating = trace.weighted(ratings) + 1;
+         out << "EDIT " << topicName(record.topic) << ' ' << record.url
+             << '\n'
+             << makeText(trace.length(options.reviewWords, options.spread),
+                         trace) << '\n'
+             << record.rating << '\n';
+      }
+      else
+      {
+         out << "PURGE\n";
+         live.erase(remove_if(live.begin(), live.end(),
+                              [](const Record &record)
+                              {
+                                 return record.rating == 1;
+                              }),
+                    live.end());
+      }
+   }
+}
+
+// REPLAYING
+
+// readTrace function
+// Description: Parses a trace of LOAD, ADD, GET, EDIT and PURGE batch
+//              commands into memory, so parsing is not part of the timing.
+//              Blank lines and lines starting with # are skipped.
+// Input: filename, operations to fill
+// Output: false if the file cannot be opened or a command is malformed
+bool readTrace(const char * filename, vector<Operation> &operations)
+{
+   ifstream in(filename);
+   if (!in)
+   {
+      cerr << "Could not open " << filename << endl;
+      return false;
+   }
+   string line;
+   int lineNum = 0;
+   while (getline(in, line))
+   {
+      lineNum++;
+      if (!line.empty() && line[line.size() - 1] == '\r') // CRLF files
+      {
+         line.erase(line.size() - 1);
+      }
+      if (line.empty() || line[0] == '#')
+      {
+         continue;
+      }
+      size_t space = line.find(' ');
+      string name = line.substr(0, space);
+      Operation operation;
+      operation.command = 0;
+      operation.rating = 0;
+      while (operation.command < NUM_TRACE_COMMANDS &&
+             name != TRACE_COMMAND_NAMES[operation.command])
+      {
+         operation.command++;
+      }
+      string args = space == string::npos ? "" : line.substr(space + 1);
+      bool ok = operation.command < NUM_TRACE_COMMANDS;
+      int lines = 0; // lines after the command
+      if (operation.command == TRACE_ADD)
+      {
+         lines = 5;
+      }
+      else if (operation.command == TRACE_EDIT)
+      {
+         size_t last = args.rfind(' '); // topic, then the URL (no spaces)
+         ok = last != string::npos;
+         operation.args[0] = args.substr(0, last);
+         operation.args[1] = ok ? args.substr(last + 1) : "";
+         lines = 2;
+      }
+      else
+      {
+         operation.args[0] = args;
+      }
+      string fields[5];
+      for (int i = 0; ok && i < lines; i++)
+      {
+         ok = bool(getline(in, fields[i]));
+         lineNum++;
+         if (ok && !fields[i].empty() &&
+             fields[i][fields[i].size() - 1] == '\r')
+         {
+            fields[i].erase(fields[i].size() - 1);
+         }
+      }
+      if (ok && lines > 0)
+      {
+         char * end = nullptr;
+         const char * rating = fields[lines - 1].c_str();
+         operation.rating = (int)strtol(rating, &end, 10);
+         ok = end != rating;
+      }
+      if (!ok)
+      {
+         cerr << filename << ": bad " << name << " at line " << lineNum
+              << endl;
+         return false;
+      }
+      if (operation.command == TRACE_ADD)
+      {
+         for (int i = 0; i < 4; i++)
+         {
+            operation.args[i] = fields[i];
+         }
+      }
+      else if (operation.command == TRACE_EDIT)
+      {
+         operation.args[2] = fields[0];
+      }
+      operations.push_back(operation);
+   }
+   return true;
+}
+
+// replay function
+// Description: Runs a trace against a new Table, timing each operation, and
+//              prints per command counts and latency percentiles, the
+//              overall rate, and a checksum of the results (websites loaded,
+//              added, found, edited, purged) that only changes if the
+//              table's behavior does. With options.perf the hardware
+//              counters per Table operation (perf_counters.h) follow.
+// Input: options
+// Output: 0 if the trace was read, 1 if not
+int replay(const ReplayOptions &options)
+{
+   vector<Operation> operations;
+   if (!readTrace(options.trace, operations))
+   {
+      return 1;
+   }
+   Table table(options.capacity, options.hashSeed); // 0, 0 for defaults
+   if (options.filter)
+   {
+      table.enableFilter(1000000);
+   }
+   if (options.cache > 0)
+   {
+      table.enableCache(options.cache);
+   }
+   vector<long long> latencies[NUM_TRACE_COMMANDS];
+   PerfStats * perf = options.perf ? new PerfStats() : nullptr;
+   ScopedPerfStats scoped(perf);
+   vector<const Website *> matches(1);
+   uint64_t checksum = UINT64_C(14695981039346656037); // FNV-1a of results
+   double seconds = 0;
+   for (size_t i = 0; i < operations.size(); i++)
+   {
+      Operation &operation = operations[i];
+      long long result = 0;
+      if (operation.command == TRACE_GET &&
+          (int)matches.size() < table.getSize())
+      {
+         matches.resize(table.getSize()); // outside the timing
+      }
+      chrono::steady_clock::time_point start = chrono::steady_clock::now();
+      switch (operation.command)
+      {
+         case TRACE_LOAD:
+         {
+            int before = table.getSize();
+            table.loadFromFile(operation.args[0].c_str());
+            result = table.getSize() - before;
+            break;
+         }
+         case TRACE_ADD:
+         {
+            Website website;
+            website.setTopic(&operation.args[0][0]);
+            website.setURL(&operation.args[1][0]);
+            website.setSummary(&operation.args[2][0]);
+            website.setReview(&operation.args[3][0]);
+            website.setRating(operation.rating);
+            result = table.insert(website);
+            break;
+         }
+         case TRACE_GET:
+         {
+            int found = 0;
+            table.topK(operation.args[0].c_str(), (int)matches.size(),
+                       matches.data(), found);
+            result = found;
+            break;
+         }
+         case TRACE_EDIT:
+         {
+            result = table.edit(&operation.args[0][0], &operation.args[1][0],
+                                &operation.args[2][0], operation.rating);
+            break;
+         }
+         case TRACE_PURGE:
+         {
+            int before = table.getSize();
+            table.removeOneStar();
+            result = before - table.getSize();
+            break;
+         }
+      }
+      chrono::nanoseconds elapsed = chrono::steady_clock::now() - start;
+      latencies[operation.command].push_back(elapsed.count());
+      seconds += elapsed.count() / 1e9;
+      checksum = (checksum ^ (uint64_t)result) * UINT64_C(1099511628211);
+   }
+
+   cout << "command      count     total ms     p50 ns     p99 ns   p99.9 ns"
+        << "     max ns" << endl;
+   for (int c = 0; c < NUM_TRACE_COMMANDS; c++)
+   {
+      vector<long long> &times = latencies[c];
+      if (times.empty())
+      {
+         continue;
+      }
+      sort(times.begin(), times.end());
+      long long total = 0;
+      for (size_t i = 0; i < times.size(); i++)
+      {
+         total += times[i];
+      }
+      size_t last = times.size() - 1;
+      cout << left << setw(8) << TRACE_COMMAND_NAMES[c] << right << setw(10)
+           << times.size() << fixed << setprecision(3) << setw(13)
+           << total / 1e6 << setw(11) << times[last / 2] << setw(11)
+           << times[last * 99 / 100] << setw(11) << times[last * 999 / 1000]
+           << setw(11) << times[last] << endl;
+   }
+   cout << setprecision(0) << "ops/s: "
+        << (seconds > 0 ? operations.size() / seconds : 0) << endl;
+   cout << "final size: " << table.getSize() << ", checksum: " << hex
+        << checksum << dec << endl;
+   if (perf)
+   {
+      cout << *perf;
+   }
+   setPerfStats(nullptr);
+   delete perf;
+   perf = nullptr;
+   return 0;
+}